@@ -0,0 +1,357 @@
+#include "benchmark.hh"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <thread>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <x86intrin.h>
+
+static benchConfig config_m{{}, {}, 0, 0, 10, -1, BenchTimer::Chrono, 0, ".", "", true, false};
+static cpu_set_t original_affinity_m;
+
+static void usage(const char* program, int status){
+    std::ostream& out= status == 0? std::cout: std::cerr;
+    out << "Usage: " << program << " [options]\n"
+        << "  --bench a,b,...     benchmarks to run (default: all, see --list)\n"
+        << "  --sizes n,m,...     feature sizes (batch sizes for sigmoid), default: each benchmark's own\n"
+        << "  --iterations N      timed samples per size, default: each benchmark's own\n"
+        << "  --reps N            calls averaged per sample (epochs for hogwild, rows for dataset_reader,\n"
+        << "                      publish interval for snapshot), default: each benchmark's own\n"
+        << "  --warmup N          iterations of a discarded run before every size (default 10), the run builds\n"
+        << "                      its own models and buffers: it warms code, clocks and the allocator, not the\n"
+        << "                      measured run's data\n"
+        << "  --cpu N             pin the driver thread to core N\n"
+        << "  --timer chrono|rdtsc  clock for latencies, rdtsc reports TSC cycles (default chrono)\n"
+        << "  --histogram BINS    add log-spaced latency histograms with BINS bins to the JSON\n"
+        << "  --output DIR        directory for the *_Benchmark.json files (default .)\n"
+        << "  --isa sse4.2|avx2|avx512  force a lower kernel tier, same as AVX_LR_ISA\n"
+        << "  --no-perf           skip the perf_event_open counters (cycles, instructions, L1D/LLC/dTLB misses)\n"
+        << "  --list              print the benchmark names and default sizes, then exit\n";
+    std::exit(status);
+}
+
+static std::vector<std::string> splitList(const std::string& list){
+    std::vector<std::string> items;
+    size_t begin= 0;
+    while (begin <= list.size()){
+        size_t end= std::min(list.find(',', begin), list.size());
+        if (end > begin){
+            items.push_back(list.substr(begin, end - begin));
+        }
+        begin= end + 1;
+    }
+    return items;
+}
+
+template <typename T>
+static T parseNumber(const char* program, const std::string& option, const std::string& text){
+    T value{};
+    auto [end, error]= std::from_chars(text.data(), text.data() + text.size(), value);
+    if (error != std::errc() || end != text.data() + text.size()){
+        std::cerr << option << ": '" << text << "' is not a valid number" << std::endl;
+        usage(program, 1);
+    }
+    return value;
+}
+
+void parseBenchArgs(int argc, char** argv){
+    for (int i= 1; i < argc; i++){
+        std::string option= argv[i];
+        if (option == "--help" || option == "-h"){
+            usage(argv[0], 0);
+        }
+        if (option == "--list"){
+            config_m.list= true;
+            continue;
+        }
+        if (option == "--no-perf"){
+            config_m.perf_counters= false;
+            continue;
+        }
+        if (i + 1 == argc){
+            std::cerr << "Missing value for " << option << std::endl;
+            usage(argv[0], 1);
+        }
+        std::string value= argv[++i];
+
+        if (option == "--bench"){
+            config_m.benchmarks= splitList(value);
+        }
+        else if (option == "--sizes"){
+            config_m.sizes.clear();
+            for (const std::string& size: splitList(value)){
+                config_m.sizes.push_back(parseNumber<size_t>(argv[0], option, size));
+            }
+        }
+        else if (option == "--iterations"){
+            config_m.iterations= parseNumber<int>(argv[0], option, value);
+        }
+        else if (option == "--reps"){
+            config_m.reps= parseNumber<int>(argv[0], option, value);
+        }
+        else if (option == "--warmup"){
+            config_m.warmup= parseNumber<int>(argv[0], option, value);
+        }
+        else if (option == "--cpu"){
+            config_m.cpu= parseNumber<int>(argv[0], option, value);
+        }
+        else if (option == "--histogram"){
+            config_m.histogram_bins= parseNumber<size_t>(argv[0], option, value);
+        }
+        else if (option == "--output"){
+            config_m.output_dir= value;
+        }
+        else if (option == "--isa"){
+            config_m.isa= value;
+        }
+        else if (option == "--timer"){
+            if (value == "chrono"){
+                config_m.timer= BenchTimer::Chrono;
+            }
+            else if (value == "rdtsc"){
+                config_m.timer= BenchTimer::Rdtsc;
+            }
+            else{
+                std::cerr << "--timer: unknown clock '" << value << "'" << std::endl;
+                usage(argv[0], 1);
+            }
+        }
+        else{
+            std::cerr << "Unknown option " << option << std::endl;
+            usage(argv[0], 1);
+        }
+    }
+
+    if (config_m.iterations < 0 || config_m.reps < 0 || config_m.warmup < 0 || config_m.cpu < -1){
+        std::cerr << "Counts must be positive" << std::endl;
+        usage(argv[0], 1);
+    }
+    if (std::find(config_m.sizes.begin(), config_m.sizes.end(), 0) != config_m.sizes.end()){
+        std::cerr << "--sizes: sizes must be positive" << std::endl;
+        usage(argv[0], 1);
+    }
+    if (!config_m.isa.empty()){
+        setenv("AVX_LR_ISA", config_m.isa.c_str(), 1);
+    }
+}
+
+const benchConfig& settings(){
+    return config_m;
+}
+
+void pinDriverThread(){
+    if (config_m.cpu < 0){
+        return;
+    }
+    static bool saved= pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &original_affinity_m) == 0;
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(config_m.cpu, &cpus);
+    if (!saved || pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpus) != 0){
+        std::cerr << "Cannot pin to core " << config_m.cpu << ", running unpinned" << std::endl;
+        config_m.cpu= -1;
+    }
+}
+
+void releaseDriverThread(){
+    if (config_m.cpu < 0){
+        return;
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &original_affinity_m);
+}
+
+//lfence on both sides keeps the timed code from drifting across the timestamp
+static inline uint64_t fencedRdtsc(){
+    _mm_lfence();
+    uint64_t tsc= __rdtsc();
+    _mm_lfence();
+    return tsc;
+}
+
+uint64_t benchClock::now(){
+    if (config_m.timer == BenchTimer::Rdtsc){
+        return fencedRdtsc();
+    }
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+}
+
+double benchClock::elapsed(uint64_t start, uint64_t end){
+    return static_cast<double>(end - start);
+}
+
+double benchClock::tscGHz(){
+    if (config_m.timer != BenchTimer::Rdtsc){
+        return 0.0;
+    }
+    static const double ghz= []{
+        auto start= std::chrono::steady_clock::now();
+        uint64_t tsc_start= fencedRdtsc();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        uint64_t tsc_end= fencedRdtsc();
+        auto end= std::chrono::steady_clock::now();
+        return (tsc_end - tsc_start)/ std::chrono::duration<double, std::nano>(end - start).count();
+    }();
+    return ghz;
+}
+
+double benchClock::toSeconds(double ticks){
+    if (config_m.timer == BenchTimer::Rdtsc){
+        return ticks/ (tscGHz()* 1e9);
+    }
+    return ticks* 1e-9;
+}
+
+const char* benchClock::unit(){
+    return config_m.timer == BenchTimer::Rdtsc? "cycles": "ns";
+}
+
+size_t cacheBytes(int level){
+    long size= sysconf(level == 2? _SC_LEVEL2_CACHE_SIZE: _SC_LEVEL3_CACHE_SIZE);
+    if (size > 0){
+        return size;
+    }
+    for (int index= 0; index < 8; index++){
+        const std::string path= "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+        std::ifstream level_file(path + "level");
+        std::ifstream type_file(path + "type");
+        std::ifstream size_file(path + "size");
+        int cache_level= 0;
+        std::string type;
+        size_t kilobytes= 0;
+        if (level_file >> cache_level && type_file >> type && size_file >> kilobytes && cache_level == level && type != "Instruction"){
+            return kilobytes* 1024;
+        }
+    }
+    return level == 2? size_t(1) << 20: size_t(32) << 20;
+}
+
+void flushFromCache(const void* data, size_t bytes){
+    const char* begin= static_cast<const char*>(data);
+    for (size_t offset= 0; offset < bytes; offset+= 64){
+        _mm_clflush(begin + offset);
+    }
+    _mm_clflush(begin + bytes - 1);
+    _mm_mfence();
+}
+
+//Log-spaced so the tail gets as many bins per decade as the bulk, counts[i] covers [edges[i], edges[i + 1])
+static json histogram(const std::vector<double>& sorted, size_t bins){
+    double low= std::max(sorted.front(), 1e-3);
+    double high= std::max(sorted.back(), low)* (1.0 + 1e-9);
+    double ratio= std::pow(high/ low, 1.0/ bins);
+
+    std::vector<double> edges(bins + 1);
+    for (size_t b= 0; b <= bins; b++){
+        edges[b]= low* std::pow(ratio, b);
+    }
+    edges[bins]= high;
+
+    std::vector<size_t> counts(bins, 0);
+    size_t bin= 0;
+    for (double value: sorted){
+        while (bin + 1 < bins && value >= edges[bin + 1]){
+            bin++;
+        }
+        counts[bin]++;
+    }
+
+    json result;
+    result["edges_" + std::string(benchClock::unit())]= edges;
+    result["counts"]= counts;
+    return result;
+}
+
+json analyze_timings(std::vector<double>& timings, const std::string& title){
+    json result;
+    if (timings.empty()) {
+        result["error"]= "No data provided for " + title;
+        return result;
+    }
+
+    std::sort(timings.begin(), timings.end());
+    double median= timings[timings.size()/2];
+    double mean= std::accumulate(timings.begin(), timings.end(), 0.0)/timings.size();
+    double p95= timings[static_cast<int>(timings.size()*0.95)];
+    double p99= timings[static_cast<int>(timings.size()*0.99)];
+    double p99_9= timings[static_cast<int>(timings.size()*0.999)];
+
+    const std::string unit= benchClock::unit();
+    result["title"]= title;
+    result["median_" + unit]= median;
+    result["mean_" + unit]= mean;
+    result["p95_" + unit]= p95;
+    result["p99_" + unit]= p99;
+    result["p999_" + unit]= p99_9;
+    if (config_m.histogram_bins > 0){
+        result["histogram"]= histogram(timings, config_m.histogram_bins);
+    }
+
+    return result;
+}
+
+json analyze_errors(std::vector<double>& errors, const std::string& title) {
+    json result;
+    if (errors.empty()) {
+        result["error"]= "No data provided for " + title;
+        return result;
+    }
+
+    std::sort(errors.begin(), errors.end());
+    double median = errors[errors.size() / 2];
+    double mean = std::accumulate(errors.begin(), errors.end(), 0.0) / errors.size();
+    double p95 = errors[static_cast<int>(errors.size() * 0.95)];
+    double p99 = errors[static_cast<int>(errors.size() * 0.99)];
+
+    result["title"]= title;
+    result["median_error"]= median;
+    result["mean_error"]= mean;
+    result["p95_error"]= p95;
+    result["p99_error"]= p99;
+
+    return result;
+}
+
+json analyze_p95_speedup(std::vector<double>& timings, std::vector<double>& relativeTo, const std::string& title){
+    json result;
+    if (timings.empty() || relativeTo.empty()) {
+        result["error"]= "No data provided for " + title;
+        return result;
+    }
+
+    std::sort(timings.begin(), timings.end());
+    std::sort(relativeTo.begin(), relativeTo.end());
+    double timings_p95= timings[static_cast<int>(timings.size()*0.95)];
+    double relativeTo_p95= relativeTo[static_cast<int>(relativeTo.size()* 0.95)];
+    double speedup= (relativeTo_p95/timings_p95);
+
+    result["title"]= title;
+    double multiplier= std::pow(10, 2);
+    if (speedup < 1){
+        result["x slowdown"]= std::round(1/speedup * multiplier)/multiplier;
+    }
+    else{
+        result["x speedup"]=  std::round(speedup* multiplier)/ multiplier;
+    }
+
+    return result;
+}
+
+json configJson(){
+    json config;
+    config["Timer"]= config_m.timer == BenchTimer::Rdtsc? "rdtsc": "chrono";
+    config["Unit"]= benchClock::unit();
+    if (config_m.timer == BenchTimer::Rdtsc){
+        config["TSC_GHz"]= benchClock::tscGHz();
+    }
+    config["Warmup"]= config_m.warmup;
+    config["CPU"]= config_m.cpu;
+    config["Perf_Counters"]= config_m.perf_counters;
+    return config;
+}
@@ -0,0 +1,62 @@
+//Benchmark driver settings, timing and result summaries shared by every benchmark in main.cpp
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+enum class BenchTimer{
+    Chrono, //high_resolution_clock, results in ns
+    Rdtsc   //fenced rdtsc/rdtscp, results in TSC cycles
+};
+
+//Empty lists and zero counts mean "each benchmark's defaults"
+struct benchConfig{
+    std::vector<std::string> benchmarks;
+    std::vector<size_t> sizes;
+    int iterations;
+    int reps;
+    int warmup;             //iterations of a separate, discarded run of the benchmark before every measured case
+    int cpu;                //core the driver thread is pinned to, -1 leaves affinity alone
+    BenchTimer timer;
+    size_t histogram_bins;  //0 leaves latency histograms out of the JSON
+    std::string output_dir;
+    std::string isa;        //forwarded to AVX_LR_ISA before the kernels are resolved
+    bool perf_counters;     //hardware counters per measured region where a benchmark collects them
+    bool list;
+};
+
+//Parses argv into settings(), prints usage and exits on --help or bad input
+void parseBenchArgs(int argc, char** argv);
+
+const benchConfig& settings();
+
+//Pins the calling thread to settings().cpu, the multi-threaded benchmarks release it so their workers can spread out
+void pinDriverThread();
+void releaseDriverThread();
+
+struct benchClock{
+    static uint64_t now();
+    //Elapsed time in the configured unit, ns or cycles
+    static double elapsed(uint64_t start, uint64_t end);
+    static double toSeconds(double ticks);
+    static const char* unit();
+    //Measured TSC rate against steady_clock, 0 until the first call in Rdtsc mode
+    static double tscGHz();
+};
+
+//Data or unified cache size of the given level (2 or 3) from sysconf, then sysfs, then a typical desktop size
+size_t cacheBytes(int level);
+
+//clflush every line of [data, data + bytes), fenced so the next access goes to DRAM
+void flushFromCache(const void* data, size_t bytes);
+
+//Summaries in benchClock units, timings and errors are sorted in place
+json analyze_timings(std::vector<double>& timings, const std::string& title);
+json analyze_errors(std::vector<double>& errors, const std::string& title);
+json analyze_p95_speedup(std::vector<double>& timings, std::vector<double>& relativeTo, const std::string& title);
+
+//Settings and clock of this run, stored under "Config" in every output file
+json configJson();
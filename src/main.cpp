@@ -1,95 +1,55 @@
 #include "utils/containers.hh"
+#include "utils/allocators.hh"
 #include "utils/avx.hh"
 #include "utils/tools.hh"
 #include "utils/scalar.hh"
+#include "utils/dispatch.hh"
+#include "utils/logistic_regession.hh"
+#include "utils/fixed_logistic_regression.hh"
+#include "utils/hogwild.hh"
+#include "utils/sharded_inference.hh"
+#include "utils/dataset_reader.hh"
+#include "utils/snapshot_model.hh"
+#include "utils/model_bank.hh"
+#include "utils/feature_hasher.hh"
+#include "utils/event_pipeline.hh"
+#include "utils/inference_server.hh"
+#include "utils/affinity.hh"
+#include "benchmark.hh"
+#include "perf_counters.hh"
 
 #include <iostream>
 #include <fstream>
 #include <random>
-#include <chrono>
-#include <nlohmann/json.hpp>
+#include <thread>
+#include <filesystem>
+#include <mutex>
+#include <functional>
+#include <algorithm>
+#include <map>
+#include <optional>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
-using json = nlohmann::json;
-
-json analyze_timings(std::vector<double>& timings, const std::string& title){
-    json result; 
-    if (timings.empty()) {
-        result["error"]= "No data provided for " + title;
-        return result;
-    }
-    
-    std::sort(timings.begin(), timings.end());
-    double median= timings[timings.size()/2];
-    double mean= std::accumulate(timings.begin(), timings.end(), 0.0)/timings.size(); 
-    double p95= timings[static_cast<int>(timings.size()*0.95)];
-    double p99= timings[static_cast<int>(timings.size()*0.99)];
-
-    result["title"]= title;
-    result["median_ns"]= median;
-    result["mean_ns"]= mean;
-    result["p95_ns"]= p95;
-    result["p99_ns"]= p99;
-
-    return result;
-}
-
-json analyze_errors(std::vector<double>& errors, const std::string& title) {
-    json result;
-    if (errors.empty()) {
-        result["error"]= "No data provided for " + title;
-        return result;
-    }
-    
-    std::sort(errors.begin(), errors.end());
-    double median = errors[errors.size() / 2];
-    double mean = std::accumulate(errors.begin(), errors.end(), 0.0) / errors.size();
-    double p95 = errors[static_cast<int>(errors.size() * 0.95)];
-    double p99 = errors[static_cast<int>(errors.size() * 0.99)];
-
-    result["title"]= title;
-    result["median_error"]= median;
-    result["mean_error"]= mean;
-    result["p95_error"]= p95;
-    result["p99_error"]= p99;
-
-    return result;
-}
-
-json analyze_p95_speedup(std::vector<double>& timings, std::vector<double>& relativeTo, const std::string& title){
-    json result;
-    if (timings.empty() || relativeTo.empty()) {
-        result["error"]= "No data provided for " + title;
-        return result;
-    }
-
-    std::sort(timings.begin(), timings.end());
-    std::sort(relativeTo.begin(), relativeTo.end());
-    double timings_p95= timings[static_cast<int>(timings.size()*0.95)];
-    double relativeTo_p95= relativeTo[static_cast<int>(relativeTo.size()* 0.95)];
-    double speedup= (relativeTo_p95/timings_p95);
-
-    result["title"]= title;
-    double multiplier= std::pow(10, 2);
-    if (speedup < 1){ 
-        result["x slowdown"]= std::round(1/speedup * multiplier)/multiplier;
-    }
-    else{
-        result["x speedup"]=  std::round(speedup* multiplier)/ multiplier;
-    }
-
-    return result;
-}
-
-template <size_t feature_size>
-json benchmark_inference(int iterations, int reps) {
+json benchmark_inference(size_t feature_size, int iterations, int reps) {
+    const KernelTable& isa_kernels= kernels();
     alignedArray<int16_t> avx_q8_8_weights(feature_size);
     alignedArray<int16_t> avx_q8_8_inputs(feature_size);
 
     alignedArray<float> avx_weights(feature_size);
     alignedArray<float> avx_inputs(feature_size);
 
-    std::array<float, feature_size> scalar_weights{};
-    std::array<float, feature_size> scalar_inputs{};
+    //per-tensor INT8 runs on every tier, per-block only has an AVX2 kernel
+    const bool int8_blocked= detectISA() >= ISA::AVX2;
+    const size_t int8_blocks= (feature_size + INT8_BLOCK - 1)/ INT8_BLOCK;
+    alignedArray<int8_t> avx_int8_weights(feature_size);
+    alignedArray<int8_t> avx_int8_inputs(feature_size);
+    alignedArray<float> avx_int8_weight_scales(int8_blocks);
+    alignedArray<float> avx_int8_input_scales(int8_blocks);
+
+    std::vector<float> scalar_weights(feature_size);
+    std::vector<float> scalar_inputs(feature_size);
     
     std::random_device rd;
     std::mt19937 mt(rd());
@@ -99,33 +59,33 @@ json benchmark_inference(int iterations, int reps) {
     std::vector<double> avx_latency{};
     std::vector<double> scalar_latency{};
     std::vector<double> absolute_errors_q8_8{};
+    std::vector<double> absolute_errors_q8_8_interp{};
     std::vector<double> absolute_errors_fp{};
+    std::vector<double> avx_int8_latency{};
+    std::vector<double> avx_int8_blocked_latency{};
+    std::vector<double> absolute_errors_int8{};
+    std::vector<double> absolute_errors_int8_blocked{};
+    avx_int8_latency.reserve(iterations);
+    absolute_errors_int8.reserve(iterations);
+    if (int8_blocked){
+        avx_int8_blocked_latency.reserve(iterations);
+        absolute_errors_int8_blocked.reserve(iterations);
+    }
     scalar_latency.reserve(iterations);
     avx_latency.reserve(iterations);
     avx_q8_8_latency.reserve(iterations);
     absolute_errors_q8_8.reserve(iterations);
+    absolute_errors_q8_8_interp.reserve(iterations);
     absolute_errors_fp.reserve(iterations);
 
     volatile float accumulation = 0.0f;
-    std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
-
-    for (int w = 0; w < 100; w++) {
-        for (size_t j = 0; j < feature_size; j++) {
-            float rw= dist(mt);
-            float rx= dist(mt);
 
-            scalar_weights[j]= rw;
-            scalar_inputs[j]= rx;
-
-            avx_weights[j]= rw;
-            avx_inputs[j]= rx;
-        }
-        quantize8_8_inplace(scalar_weights.data(), avx_q8_8_weights.data(), feature_size);
-        quantize8_8_inplace(scalar_inputs.data(),  avx_q8_8_inputs.data(),  feature_size);
-        accumulation+= sigmoid_fp(dotproduct_scalar(scalar_weights.data(), scalar_inputs.data(), feature_size));
-        accumulation+= q8_8_to_float(sigmoidApprox_fp_to_q8_8(dotproduct_fp(avx_weights.data(), avx_inputs.data(), feature_size)));
-        accumulation+= q8_8_to_float(sigmoidApprox_q8_8(dotproduct_q8_8(avx_q8_8_weights.data(), avx_q8_8_inputs.data(), feature_size)));
-    }
+    PerfCounters counters;
+    perfRegion scalar_counters;
+    perfRegion avx_counters;
+    perfRegion avx_q8_8_counters;
+    perfRegion avx_int8_counters;
+    perfRegion avx_int8_blocked_counters;
 
     for (int iter = 0; iter < iterations; iter++) {
         for (size_t j = 0; j < feature_size; j++) {
@@ -139,47 +99,92 @@ json benchmark_inference(int iterations, int reps) {
             avx_inputs[j]= rand_x;
         }
 
-        quantize8_8_inplace(scalar_weights.data(), avx_q8_8_weights.data(), feature_size);
-        quantize8_8_inplace(scalar_inputs.data(),  avx_q8_8_inputs.data(),  feature_size);
+        isa_kernels.quantize8_8_inplace(avx_weights.data(), avx_q8_8_weights.data(), feature_size);
+        isa_kernels.quantize8_8_inplace(avx_inputs.data(),  avx_q8_8_inputs.data(),  feature_size);
+
+        float int8_w_scale= isa_kernels.absmax_scale_int8(avx_weights.data(), feature_size);
+        float int8_x_scale= isa_kernels.absmax_scale_int8(avx_inputs.data(), feature_size);
+        isa_kernels.quantize_int8(avx_weights.data(), avx_int8_weights.data(), feature_size, int8_w_scale);
+        isa_kernels.quantize_int8(avx_inputs.data(),  avx_int8_inputs.data(),  feature_size, int8_x_scale);
 
-        auto start= std::chrono::high_resolution_clock::now();
+        counters.begin();
+        auto start= benchClock::now();
         float scalar_result = 0.0f;
         for (int r= 0; r < reps; r++) {
             scalar_result += sigmoid_fp(dotproduct_scalar(scalar_weights.data(), scalar_inputs.data(), feature_size));
         }
-        auto end= std::chrono::high_resolution_clock::now();
-        double scalar_time= std::chrono::duration<double>(end - start).count() / reps;
-        scalar_latency.push_back(scalar_time * 1e9);
+        auto end= benchClock::now();
+        counters.end(scalar_counters, reps);
+        scalar_latency.push_back(benchClock::elapsed(start, end)/ reps);
         accumulation+= scalar_result;
 
-        start = std::chrono::high_resolution_clock::now();
+        counters.begin();
+        start = benchClock::now();
         int16_t avx_result_q8_8 = 0;
         for (int r= 0; r < reps; r++) {
-            avx_result_q8_8+= sigmoidApprox_fp_to_q8_8(dotproduct_fp(avx_weights.data(), avx_inputs.data(), feature_size));
+            avx_result_q8_8+= sigmoidApprox_fp_to_q8_8(isa_kernels.dotproduct_fp(avx_weights.data(), avx_inputs.data(), feature_size));
         }
-        end = std::chrono::high_resolution_clock::now();
-        double avx_time= std::chrono::duration<double>(end - start).count() / reps;
-        avx_latency.push_back(avx_time * 1e9);
+        end = benchClock::now();
+        counters.end(avx_counters, reps);
+        avx_latency.push_back(benchClock::elapsed(start, end)/ reps);
         float avx_result_fp= q8_8_to_float(avx_result_q8_8);
         accumulation += avx_result_fp;
-        
-        start = std::chrono::high_resolution_clock::now();
+
+        counters.begin();
+        start = benchClock::now();
         int16_t avx_q8_8_result= 0;
         for (int r= 0; r < reps; r++) {
-            avx_q8_8_result+= sigmoidApprox_q16_16_to_q8_8(dotproduct_q8_8(avx_q8_8_weights.data(), avx_q8_8_inputs.data(), feature_size));
+            avx_q8_8_result+= sigmoidApprox_q16_16_to_q8_8(isa_kernels.dotproduct_q8_8(avx_q8_8_weights.data(), avx_q8_8_inputs.data(), feature_size));
         }
-        end= std::chrono::high_resolution_clock::now();
-        double avx_q8_8_time= std::chrono::duration<double>(end - start).count() / reps;
-        avx_q8_8_latency.push_back(avx_q8_8_time * 1e9);
+        end= benchClock::now();
+        counters.end(avx_q8_8_counters, reps);
+        avx_q8_8_latency.push_back(benchClock::elapsed(start, end)/ reps);
         float avx_q8_8_result_fp= q8_8_to_float(avx_q8_8_result);
         accumulation+= avx_q8_8_result_fp;
 
+        counters.begin();
+        start= benchClock::now();
+        int16_t avx_int8_result= 0;
+        for (int r= 0; r < reps; r++) {
+            avx_int8_result+= sigmoidApprox_fp_to_q8_8(isa_kernels.dotproduct_int8(avx_int8_weights.data(), avx_int8_inputs.data(), feature_size)* int8_w_scale* int8_x_scale);
+        }
+        end= benchClock::now();
+        counters.end(avx_int8_counters, reps);
+        avx_int8_latency.push_back(benchClock::elapsed(start, end)/ reps);
+        accumulation+= q8_8_to_float(avx_int8_result);
+
         scalar_result= sigmoid_fp(dotproduct_scalar(scalar_weights.data(), scalar_inputs.data(), feature_size));
-        avx_result_fp= q8_8_to_float(sigmoidApprox_fp_to_q8_8(dotproduct_fp(avx_weights.data(), avx_inputs.data(), feature_size))); 
-        avx_q8_8_result_fp= q8_8_to_float(sigmoidApprox_q16_16_to_q8_8(dotproduct_q8_8(avx_q8_8_weights.data(), avx_q8_8_inputs.data(), feature_size)));
+        avx_result_fp= q8_8_to_float(sigmoidApprox_fp_to_q8_8(isa_kernels.dotproduct_fp(avx_weights.data(), avx_inputs.data(), feature_size))); 
+        avx_q8_8_result_fp= q8_8_to_float(sigmoidApprox_q16_16_to_q8_8(isa_kernels.dotproduct_q8_8(avx_q8_8_weights.data(), avx_q8_8_inputs.data(), feature_size)));
 
         absolute_errors_fp.push_back(std::fabs((avx_result_fp - scalar_result)));
         absolute_errors_q8_8.push_back(std::fabs((avx_q8_8_result_fp - scalar_result)));
+        float avx_q8_8_interp_result_fp= q8_8_to_float(sigmoidInterp_q16_16_to_q8_8(isa_kernels.dotproduct_q8_8(avx_q8_8_weights.data(), avx_q8_8_inputs.data(), feature_size)));
+        absolute_errors_q8_8_interp.push_back(std::fabs(avx_q8_8_interp_result_fp - scalar_result));
+
+        float avx_int8_result_fp= q8_8_to_float(sigmoidApprox_fp_to_q8_8(isa_kernels.dotproduct_int8(avx_int8_weights.data(), avx_int8_inputs.data(), feature_size)* int8_w_scale* int8_x_scale));
+        absolute_errors_int8.push_back(std::fabs(avx_int8_result_fp - scalar_result));
+
+        if (int8_blocked){
+            absmax_scales_int8_blocked(avx_weights.data(), avx_int8_weight_scales.data(), feature_size);
+            absmax_scales_int8_blocked(avx_inputs.data(), avx_int8_input_scales.data(), feature_size);
+            quantize_int8_blocked(avx_weights.data(), avx_int8_weights.data(), avx_int8_weight_scales.data(), feature_size);
+            quantize_int8_blocked(avx_inputs.data(), avx_int8_inputs.data(), avx_int8_input_scales.data(), feature_size);
+
+            counters.begin();
+            start= benchClock::now();
+            int16_t avx_int8_blocked_result= 0;
+            for (int r= 0; r < reps; r++) {
+                avx_int8_blocked_result+= sigmoidApprox_fp_to_q8_8(dotproduct_int8_blocked(avx_int8_weights.data(), avx_int8_weight_scales.data(), avx_int8_inputs.data(), avx_int8_input_scales.data(), feature_size));
+            }
+            end= benchClock::now();
+            counters.end(avx_int8_blocked_counters, reps);
+            avx_int8_blocked_latency.push_back(benchClock::elapsed(start, end)/ reps);
+            accumulation+= q8_8_to_float(avx_int8_blocked_result);
+
+            float avx_int8_blocked_result_fp= q8_8_to_float(sigmoidApprox_fp_to_q8_8(dotproduct_int8_blocked(avx_int8_weights.data(), avx_int8_weight_scales.data(), avx_int8_inputs.data(), avx_int8_input_scales.data(), feature_size)));
+            absolute_errors_int8_blocked.push_back(std::fabs(avx_int8_blocked_result_fp - scalar_result));
+        }
     }
 
     json benchmark_results;
@@ -187,21 +192,746 @@ json benchmark_inference(int iterations, int reps) {
     benchmark_results["AVX_FP32_Latency"]= analyze_timings(avx_latency, "AVX FP32 Inference");
     benchmark_results["AVX_Q88_Latency"]= analyze_timings(avx_q8_8_latency, "AVX Q(8.8) Inference");
     benchmark_results["AVX_Q88_Error"]= analyze_errors(absolute_errors_q8_8, "AVX Q(8.8) vs Scalar");
+    benchmark_results["AVX_Q88_Interp_Error"]= analyze_errors(absolute_errors_q8_8_interp, "AVX Q(8.8) with the interpolated sigmoid vs Scalar");
     benchmark_results["AVX_FP32_Error"]= analyze_errors(absolute_errors_fp, "AVX FP32 vs Scalar");
     benchmark_results["AVX_Q88_Scalar_Speedup"]= analyze_p95_speedup(avx_q8_8_latency, scalar_latency, "AVX Q(8.8) vs Scalar");
     benchmark_results["AVX_FP32_Scalar_Speedup"]= analyze_p95_speedup(avx_latency, scalar_latency, "AVX FP32 vs Scalar");
     benchmark_results["AVX_Q88_Fp32_Speedup"]= analyze_p95_speedup(avx_q8_8_latency, avx_latency, "AVX Q(8.8) vs AVX FP32");
+    benchmark_results["AVX_INT8_Latency"]= analyze_timings(avx_int8_latency, "AVX INT8 Inference");
+    benchmark_results["AVX_INT8_Error"]= analyze_errors(absolute_errors_int8, "AVX INT8 vs Scalar");
+    benchmark_results["AVX_INT8_Scalar_Speedup"]= analyze_p95_speedup(avx_int8_latency, scalar_latency, "AVX INT8 vs Scalar");
+    benchmark_results["AVX_INT8_Q88_Speedup"]= analyze_p95_speedup(avx_int8_latency, avx_q8_8_latency, "AVX INT8 vs AVX Q(8.8)");
+    if (int8_blocked){
+        benchmark_results["AVX_INT8_Blocked_Latency"]= analyze_timings(avx_int8_blocked_latency, "AVX INT8 per-block Inference");
+        benchmark_results["AVX_INT8_Blocked_Error"]= analyze_errors(absolute_errors_int8_blocked, "AVX INT8 per-block vs Scalar");
+        benchmark_results["AVX_INT8_Blocked_Scalar_Speedup"]= analyze_p95_speedup(avx_int8_blocked_latency, scalar_latency, "AVX INT8 per-block vs Scalar");
+    }
+    benchmark_results["Counters"]["Scalar_FP32"]= counters.summary(scalar_counters);
+    benchmark_results["Counters"]["AVX_FP32"]= counters.summary(avx_counters);
+    benchmark_results["Counters"]["AVX_Q88"]= counters.summary(avx_q8_8_counters);
+    benchmark_results["Counters"]["AVX_INT8"]= counters.summary(avx_int8_counters);
+    if (int8_blocked){
+        benchmark_results["Counters"]["AVX_INT8_Blocked"]= counters.summary(avx_int8_blocked_counters);
+    }
+    std::cout << "Accumulation (to avoid optimization): " << accumulation << std::endl;
+
+    return benchmark_results;
+}
+
+//Q(8.8) and FP32 inference where the weights are not in cache: every call scores a different model from a shuffled
+//working set sized past L2 ("L3") or past the LLC ("DRAM"), or the one model is clflushed before each call ("Flushed")
+//Inputs stay hot like a request that was just parsed, "Warm" reuses one model as benchmark_inference does
+json benchmark_cold_inference(size_t feature_size, int iterations, int reps){
+    const KernelTable& isa_kernels= kernels();
+    const size_t stride= (feature_size + 31) & ~size_t(31); //every model starts on a cache line
+    const size_t model_bytes= stride* (sizeof(float) + sizeof(int16_t));
+    const size_t l2_bytes= cacheBytes(2);
+    const size_t llc_bytes= cacheBytes(3);
+    constexpr size_t max_working_set= size_t(1) << 30;
+
+    //L3 aims at 4x L2 but stays within half the LLC, DRAM at 2x the LLC up to 1 GiB
+    const size_t l3_target= std::min(4* l2_bytes, llc_bytes/ 2);
+    const size_t dram_target= std::min(2* llc_bytes, max_working_set);
+    const std::vector<std::pair<std::string, size_t>> modes{
+        {"Warm", 1},
+        {"L3", std::max<size_t>(2, l3_target/ model_bytes)},
+        {"DRAM", std::max<size_t>(2, dram_target/ model_bytes)},
+        {"Flushed", 1}
+    };
+    const size_t max_models= std::max(modes[1].second, modes[2].second);
+
+    std::random_device rd;
+    std::mt19937 mt(rd());
+    std::uniform_real_distribution<float> dist(-1, 1);
+
+    //one random model copied across the arena: the values don't change the timing, touching every page does
+    alignedArray<float> weights(64, max_models* stride);
+    alignedArray<int16_t> weights_q8_8(64, max_models* stride);
+    alignedArray<float> inputs(64, stride);
+    alignedArray<int16_t> inputs_q8_8(64, stride);
+    for (size_t j= 0; j < stride; j++){
+        weights[j]= (j < feature_size)? dist(mt): 0.0f;
+        inputs[j]= (j < feature_size)? dist(mt): 0.0f;
+    }
+    isa_kernels.quantize8_8_inplace(weights.data(), weights_q8_8.data(), stride);
+    isa_kernels.quantize8_8_inplace(inputs.data(), inputs_q8_8.data(), stride);
+    for (size_t m= 1; m < max_models; m++){
+        std::memcpy(&weights[m* stride], weights.data(), stride* sizeof(float));
+        std::memcpy(&weights_q8_8[m* stride], weights_q8_8.data(), stride* sizeof(int16_t));
+    }
+
+    json benchmark_results;
+    benchmark_results["L2_MB"]= l2_bytes/ 1e6;
+    benchmark_results["LLC_MB"]= llc_bytes/ 1e6;
+    volatile float accumulation= 0.0f;
+    std::vector<double> warm_q8_8_latency{};
+    std::vector<double> warm_fp_latency{};
+
+    for (auto& [mode, models]: modes){
+        const bool flushed= mode == "Flushed";
+        std::vector<size_t> order(std::max<size_t>(models, reps));
+        for (size_t n= 0; n < order.size(); n++){
+            order[n]= n % models;
+        }
+        std::shuffle(order.begin(), order.end(), mt);
+
+        std::vector<double> q8_8_latency{};
+        std::vector<double> fp_latency{};
+        q8_8_latency.reserve(iterations);
+        fp_latency.reserve(iterations);
+        size_t next= 0;
+
+        //Flushed times each call on its own so the flush stays outside the timestamps
+        auto timeCalls= [&](auto weights_of, auto call, size_t bytes_per_model){
+            double elapsed= 0.0;
+            if (flushed){
+                for (int r= 0; r < reps; r++){
+                    flushFromCache(weights_of(0), bytes_per_model);
+                    auto start= benchClock::now();
+                    accumulation= accumulation + call(0);
+                    auto end= benchClock::now();
+                    elapsed+= benchClock::elapsed(start, end);
+                }
+                return elapsed/ reps;
+            }
+            float result= 0.0f;
+            auto start= benchClock::now();
+            for (int r= 0; r < reps; r++){
+                result+= call(order[next]);
+                next= (next + 1) % order.size();
+            }
+            auto end= benchClock::now();
+            accumulation= accumulation + result;
+            return benchClock::elapsed(start, end)/ reps;
+        };
+
+        auto q8_8_weights= [&](size_t m){ return &weights_q8_8[m* stride]; };
+        auto q8_8_call= [&](size_t m){
+            return q8_8_to_float(sigmoidApprox_q16_16_to_q8_8(isa_kernels.dotproduct_q8_8(q8_8_weights(m), inputs_q8_8.data(), feature_size)));
+        };
+        auto fp_weights= [&](size_t m){ return &weights[m* stride]; };
+        auto fp_call= [&](size_t m){
+            return q8_8_to_float(sigmoidApprox_fp_to_q8_8(isa_kernels.dotproduct_fp(fp_weights(m), inputs.data(), feature_size)));
+        };
+
+        for (int iter= 0; iter < iterations; iter++){
+            q8_8_latency.push_back(timeCalls(q8_8_weights, q8_8_call, feature_size* sizeof(int16_t)));
+            fp_latency.push_back(timeCalls(fp_weights, fp_call, feature_size* sizeof(float)));
+        }
+
+        json mode_results;
+        mode_results["Models"]= models;
+        mode_results["Working_Set_MB"]= models* model_bytes/ 1e6;
+        mode_results["Exceeds_LLC"]= flushed || models* model_bytes > llc_bytes;
+        mode_results["AVX_Q88_Latency"]= analyze_timings(q8_8_latency, mode + " AVX Q(8.8) Inference");
+        mode_results["AVX_FP32_Latency"]= analyze_timings(fp_latency, mode + " AVX FP32 Inference");
+        if (mode == "Warm"){
+            warm_q8_8_latency= q8_8_latency;
+            warm_fp_latency= fp_latency;
+        }
+        else{
+            mode_results["AVX_Q88_Warm_Speedup"]= analyze_p95_speedup(q8_8_latency, warm_q8_8_latency, mode + " vs Warm AVX Q(8.8)");
+            mode_results["AVX_FP32_Warm_Speedup"]= analyze_p95_speedup(fp_latency, warm_fp_latency, mode + " vs Warm AVX FP32");
+        }
+        mode_results["AVX_Q88_FP32_Speedup"]= analyze_p95_speedup(q8_8_latency, fp_latency, mode + " AVX Q(8.8) vs AVX FP32");
+        benchmark_results[mode]= mode_results;
+    }
+    std::cout << "Accumulation (to avoid optimization): " << accumulation << std::endl;
+
+    return benchmark_results;
+}
+
+//MB of the process's anonymous memory backed by transparent huge pages, 0 when smaps_rollup is unavailable
+static double anonHugePagesMB(){
+    std::ifstream smaps("/proc/self/smaps_rollup");
+    std::string line;
+    while (std::getline(smaps, line)){
+        if (line.rfind("AnonHugePages:", 0) == 0){
+            return std::stod(line.substr(14))/ 1024.0;
+        }
+    }
+    return 0.0;
+}
+
+//The same models built on aligned_alloc, huge pages, a pool and a pool over huge pages: enough models to span a fixed
+//working set are scored in random order (per-call latency, dTLB misses from the counters), Create builds and
+//destroys them all (per model). Arrays below the HugePageAllocator threshold fall back to aligned_alloc
+json benchmark_allocators(size_t feature_size, int iterations, int reps){
+    constexpr size_t working_set= size_t(64) << 20;
+    constexpr size_t max_models= 4096;
+    constexpr int create_rounds= 5;
+    const size_t model_bytes= feature_size* (2* sizeof(float) + 2* sizeof(int16_t) + 2* sizeof(int8_t));
+    const size_t model_count= std::clamp<size_t>(working_set/ model_bytes, 1, max_models);
+
+    std::random_device rd;
+    std::mt19937 mt(rd());
+    std::uniform_real_distribution<float> dist(-1, 1);
+    alignedArray<float> inputs(feature_size);
+    for (size_t j= 0; j < feature_size; j++){
+        inputs[j]= dist(mt);
+    }
+    std::vector<size_t> order(std::max<size_t>(model_count, reps));
+    for (size_t n= 0; n < order.size(); n++){
+        order[n]= n % model_count;
+    }
+    std::shuffle(order.begin(), order.end(), mt);
+
+    const std::vector<std::pair<std::string, std::function<std::unique_ptr<ArrayAllocator>()>>> allocators{
+        {"Default", []{ return std::unique_ptr<ArrayAllocator>(); }},
+        {"Huge_Pages", []{ return std::unique_ptr<ArrayAllocator>(std::make_unique<HugePageAllocator>()); }},
+        {"Pool", []{ return std::unique_ptr<ArrayAllocator>(std::make_unique<PoolAllocator>()); }},
+        {"Pool_Huge_Pages", []{ return std::unique_ptr<ArrayAllocator>(std::make_unique<PoolAllocator>(HUGE_PAGE_BYTES, hugePageAllocator())); }}
+    };
+
+    volatile float accumulation= 0.0f;
+    json benchmark_results;
+    benchmark_results["Models"]= model_count;
+    benchmark_results["Working_Set_MB"]= model_count* model_bytes/ 1e6;
+    PerfCounters counters;
+    std::vector<double> default_q8_8_latency;
+    std::vector<double> default_fp_latency;
+    std::vector<double> default_create_latency;
+
+    for (auto& [name, make_allocator]: allocators){
+        std::vector<double> create_latency;
+        for (int round= 0; round < create_rounds; round++){
+            auto start= benchClock::now();
+            {
+                std::unique_ptr<ArrayAllocator> allocator= make_allocator();
+                std::vector<std::unique_ptr<SGDLogisticRegression>> models;
+                models.reserve(model_count);
+                for (size_t m= 0; m < model_count; m++){
+                    models.push_back(std::make_unique<SGDLogisticRegression>(feature_size, 0.01f, 0.0f, ARRAY_DEFAULT_ALIGNMENT, allocator.get()));
+                }
+                accumulation= accumulation + models.back()->weights()[0];
+            }
+            auto end= benchClock::now();
+            create_latency.push_back(benchClock::elapsed(start, end)/ model_count);
+        }
+
+        const double huge_before= anonHugePagesMB();
+        std::unique_ptr<ArrayAllocator> allocator= make_allocator();
+        std::vector<std::unique_ptr<SGDLogisticRegression>> models;
+        models.reserve(model_count);
+        for (size_t m= 0; m < model_count; m++){
+            models.push_back(std::make_unique<SGDLogisticRegression>(feature_size, 0.01f, 0.0f, ARRAY_DEFAULT_ALIGNMENT, allocator.get()));
+        }
+        const double huge_after= anonHugePagesMB();
+
+        std::vector<double> q8_8_latency;
+        std::vector<double> fp_latency;
+        q8_8_latency.reserve(iterations);
+        fp_latency.reserve(iterations);
+        perfRegion q8_8_counters;
+        perfRegion fp_counters;
+        size_t next= 0;
+        for (int iter= 0; iter < iterations; iter++){
+            float result= 0.0f;
+            counters.begin();
+            auto start= benchClock::now();
+            for (int r= 0; r < reps; r++){
+                result+= models[order[(next + r) % order.size()]]->inference_q8_8_to_fp(inputs);
+            }
+            auto end= benchClock::now();
+            counters.end(q8_8_counters, reps);
+            q8_8_latency.push_back(benchClock::elapsed(start, end)/ reps);
+
+            counters.begin();
+            start= benchClock::now();
+            for (int r= 0; r < reps; r++){
+                result+= models[order[(next + r) % order.size()]]->inference_fp(inputs);
+            }
+            end= benchClock::now();
+            counters.end(fp_counters, reps);
+            fp_latency.push_back(benchClock::elapsed(start, end)/ reps);
+            next= (next + reps) % order.size();
+            accumulation= accumulation + result;
+        }
+
+        json allocator_results;
+        allocator_results["Create_Latency"]= analyze_timings(create_latency, name + " model construction and destruction");
+        allocator_results["Q88_Latency"]= analyze_timings(q8_8_latency, name + " Q(8.8) Inference");
+        allocator_results["FP32_Latency"]= analyze_timings(fp_latency, name + " FP32 Inference");
+        allocator_results["Counters"]["Q88"]= counters.summary(q8_8_counters);
+        allocator_results["Counters"]["FP32"]= counters.summary(fp_counters);
+        allocator_results["THP_Backed_MB"]= std::max(0.0, huge_after - huge_before);
+        if (HugePageAllocator* huge= dynamic_cast<HugePageAllocator*>(allocator.get())){
+            allocator_results["HugeTLB_MB"]= huge->hugetlbBytes()/ 1e6;
+            allocator_results["Advised_MB"]= huge->advisedBytes()/ 1e6;
+        }
+        if (PoolAllocator* pool= dynamic_cast<PoolAllocator*>(allocator.get())){
+            allocator_results["Pool_Used_MB"]= pool->usedBytes()/ 1e6;
+            allocator_results["Pool_Reserved_MB"]= pool->reservedBytes()/ 1e6;
+        }
+        if (name == "Default"){
+            default_q8_8_latency= q8_8_latency;
+            default_fp_latency= fp_latency;
+            default_create_latency= create_latency;
+        }
+        else{
+            allocator_results["Q88_Default_Speedup"]= analyze_p95_speedup(q8_8_latency, default_q8_8_latency, name + " vs Default Q(8.8)");
+            allocator_results["FP32_Default_Speedup"]= analyze_p95_speedup(fp_latency, default_fp_latency, name + " vs Default FP32");
+            allocator_results["Create_Default_Speedup"]= analyze_p95_speedup(create_latency, default_create_latency, name + " vs Default construction");
+        }
+        models.clear();
+        benchmark_results[name]= allocator_results;
+    }
+    std::cout << "Accumulation (to avoid optimization): " << accumulation << std::endl;
+
+    return benchmark_results;
+}
+
+//FixedLogisticRegression against SGDLogisticRegression holding the same weights: Q(8.8) and FP32 inference and the
+//fused online step, per call. Q(8.8) probabilities must match exactly, the two learners must stay identical
+template <size_t N>
+static json benchmark_fixed_model_n(int iterations, int reps){
+    constexpr size_t input_count= 64;
+
+    std::random_device rd;
+    std::mt19937 mt(rd());
+    std::uniform_real_distribution<float> dist(-1, 1);
+
+    std::vector<alignedArray<float>> inputs;
+    for (size_t i= 0; i < input_count; i++){
+        inputs.emplace_back(N);
+        for (size_t j= 0; j < N; j++){
+            inputs[i][j]= dist(mt);
+        }
+    }
+    SGDLogisticRegression dynamic(N);
+    SGDLogisticRegression dynamic_learner(N);
+    auto fixed= std::make_unique<FixedLogisticRegression<N, WeightFormat::Q8_8>>();
+    auto fixed_fp= std::make_unique<FixedLogisticRegression<N, WeightFormat::FP32>>();
+    auto fixed_learner= std::make_unique<FixedLogisticRegression<N, WeightFormat::Q8_8>>();
+    alignedArray<float> weights(N);
+    std::memcpy(weights.data(), dynamic.weights(), N* sizeof(float));
+    dynamic_learner.setWeights(weights.data());
+    fixed->setWeights(weights.data());
+    fixed_fp->setWeights(weights.data());
+    fixed_learner->setWeights(weights.data());
+
+    std::vector<double> dynamic_q8_8_latency, fixed_q8_8_latency, dynamic_fp_latency, fixed_fp_latency;
+    std::vector<double> dynamic_learn_latency, fixed_learn_latency;
+    for (auto* timings: {&dynamic_q8_8_latency, &fixed_q8_8_latency, &dynamic_fp_latency, &fixed_fp_latency, &dynamic_learn_latency, &fixed_learn_latency}){
+        timings->reserve(iterations);
+    }
+    size_t mismatches= 0;
+    volatile float accumulation= 0.0f;
+
+    auto time= [&](std::vector<double>& timings, auto call){
+        float result= 0.0f;
+        auto start= benchClock::now();
+        for (int r= 0; r < reps; r++){
+            result+= call();
+        }
+        auto end= benchClock::now();
+        timings.push_back(benchClock::elapsed(start, end)/ reps);
+        accumulation= accumulation + result;
+        return result;
+    };
+
+    for (int iter= 0; iter < iterations; iter++){
+        alignedArray<float>& x= inputs[iter % input_count];
+        const float label= static_cast<float>(iter & 1);
+        float dynamic_q8_8= time(dynamic_q8_8_latency, [&]{ return dynamic.inference_q8_8_to_fp(x); });
+        float fixed_q8_8= time(fixed_q8_8_latency, [&]{ return fixed->inference_q8_8_to_fp(x); });
+        time(dynamic_fp_latency, [&]{ return dynamic.inference_fp(x); });
+        time(fixed_fp_latency, [&]{ return fixed_fp->inference_fp(x); });
+        float dynamic_learn= time(dynamic_learn_latency, [&]{ return dynamic_learner.predict_and_learn(x, label); });
+        float fixed_learn= time(fixed_learn_latency, [&]{ return fixed_learner->predict_and_learn(x, label); });
+        mismatches+= dynamic_q8_8 != fixed_q8_8;
+        mismatches+= dynamic_learn != fixed_learn;
+    }
+    mismatches+= std::memcmp(dynamic_learner.weights_q8_8(), fixed_learner->weights_q8_8(), N* sizeof(int16_t)) != 0;
+
+    json benchmark_results;
+    benchmark_results["Fixed_Object_Bytes"]= sizeof(FixedLogisticRegression<N, WeightFormat::Q8_8>);
+    benchmark_results["Dynamic_Q88_Latency"]= analyze_timings(dynamic_q8_8_latency, "SGDLogisticRegression Q(8.8) Inference");
+    benchmark_results["Fixed_Q88_Latency"]= analyze_timings(fixed_q8_8_latency, "FixedLogisticRegression Q(8.8) Inference");
+    benchmark_results["Dynamic_FP32_Latency"]= analyze_timings(dynamic_fp_latency, "SGDLogisticRegression FP32 Inference");
+    benchmark_results["Fixed_FP32_Latency"]= analyze_timings(fixed_fp_latency, "FixedLogisticRegression FP32 Inference");
+    benchmark_results["Dynamic_Predict_And_Learn_Latency"]= analyze_timings(dynamic_learn_latency, "SGDLogisticRegression predict_and_learn");
+    benchmark_results["Fixed_Predict_And_Learn_Latency"]= analyze_timings(fixed_learn_latency, "FixedLogisticRegression predict_and_learn");
+    benchmark_results["Fixed_Q88_Speedup"]= analyze_p95_speedup(fixed_q8_8_latency, dynamic_q8_8_latency, "Fixed vs dynamic Q(8.8)");
+    benchmark_results["Fixed_FP32_Speedup"]= analyze_p95_speedup(fixed_fp_latency, dynamic_fp_latency, "Fixed vs dynamic FP32");
+    benchmark_results["Fixed_Predict_And_Learn_Speedup"]= analyze_p95_speedup(fixed_learn_latency, dynamic_learn_latency, "Fixed vs dynamic predict_and_learn");
+    benchmark_results["Q88_Mismatches"]= mismatches;
+    std::cout << "Accumulation (to avoid optimization): " << accumulation << std::endl;
+
+    return benchmark_results;
+}
+
+//Sizes must have an explicit instantiation in fixed_logistic_regression.cpp
+json benchmark_fixed_model(size_t feature_size, int iterations, int reps){
+    switch (feature_size){
+        case 16: return benchmark_fixed_model_n<16>(iterations, reps);
+        case 32: return benchmark_fixed_model_n<32>(iterations, reps);
+        case 64: return benchmark_fixed_model_n<64>(iterations, reps);
+        case 128: return benchmark_fixed_model_n<128>(iterations, reps);
+        case 256: return benchmark_fixed_model_n<256>(iterations, reps);
+        default:{
+            json benchmark_results;
+            benchmark_results["Error"]= "No FixedLogisticRegression instantiation for " + std::to_string(feature_size) + " features";
+            return benchmark_results;
+        }
+    }
+}
+
+//One input scored against many small models: separate SGDLogisticRegression objects against the ModelMajor and
+//Interleaved banks holding the same weights, for every model and for a random eighth of them, plus single-model updates
+//Latencies are per model scored (per update), Q(8.8) probabilities must match the separate models exactly
+json benchmark_model_bank(size_t feature_size, int iterations, int reps){
+    constexpr std::array<size_t, 3> model_counts{32, 512, 4096};
+    const bool interleaved= kernels().isa >= ISA::AVX2;
+
+    std::random_device rd;
+    std::mt19937 mt(rd());
+    std::uniform_real_distribution<float> dist(-1, 1);
+
+    alignedArray<float> inputs(feature_size);
+    alignedArray<float> weights(feature_size);
+    volatile float accumulation= 0.0f;
+    json benchmark_results;
+
+    for (size_t num_models: model_counts){
+        ModelBank major(num_models, feature_size, BankLayout::ModelMajor);
+        std::optional<ModelBank> tiled;
+        if (interleaved){
+            tiled.emplace(num_models, feature_size, BankLayout::Interleaved);
+        }
+        std::vector<SGDLogisticRegression> separate;
+        separate.reserve(num_models);
+        for (size_t m= 0; m < num_models; m++){
+            major.getWeights(m, weights.data());
+            separate.emplace_back(feature_size);
+            separate.back().setWeights(weights.data());
+            if (tiled){
+                tiled->setWeights(m, weights.data());
+            }
+        }
+
+        const size_t subset_count= std::max<size_t>(1, num_models/ 8);
+        std::vector<size_t> subset(subset_count);
+        alignedArray<float> probabilities(num_models);
+        alignedArray<float> reference(num_models);
+
+        std::map<std::string, std::vector<double>> latency;
+        size_t q8_8_mismatches= 0;
+        double max_fp_error= 0.0;
+
+        auto timeScoring= [&](const std::string& name, size_t scored, auto score){
+            auto start= benchClock::now();
+            for (int r= 0; r < reps; r++){
+                score();
+                accumulation= accumulation + probabilities[0];
+            }
+            auto end= benchClock::now();
+            latency[name].push_back(benchClock::elapsed(start, end)/ (reps* scored));
+        };
+        auto compare= [&](size_t count, bool q8_8){
+            for (size_t i= 0; i < count; i++){
+                if (q8_8){
+                    q8_8_mismatches+= probabilities[i] != reference[i];
+                }
+                else{
+                    max_fp_error= std::max<double>(max_fp_error, std::fabs(probabilities[i] - reference[i]));
+                }
+            }
+        };
+
+        for (int iter= 0; iter < iterations; iter++){
+            for (size_t j= 0; j < feature_size; j++){
+                inputs[j]= dist(mt);
+            }
+            for (size_t& model: subset){
+                model= mt() % num_models;
+            }
+
+            for (bool q8_8: {true, false}){
+                const std::string format= q8_8? "Q88": "FP32";
+                timeScoring("Separate_All_" + format, num_models, [&]{
+                    for (size_t m= 0; m < num_models; m++){
+                        probabilities[m]= q8_8? separate[m].inference_q8_8_to_fp(inputs): separate[m].inference_fp(inputs);
+                    }
+                });
+                std::memcpy(reference.data(), probabilities.data(), num_models* sizeof(float));
+                timeScoring("ModelMajor_All_" + format, num_models, [&]{
+                    q8_8? major.inference_all_q8_8_to_fp(inputs, probabilities.data()): major.inference_all_fp(inputs, probabilities.data());
+                });
+                compare(num_models, q8_8);
+                if (tiled){
+                    timeScoring("Interleaved_All_" + format, num_models, [&]{
+                        q8_8? tiled->inference_all_q8_8_to_fp(inputs, probabilities.data()): tiled->inference_all_fp(inputs, probabilities.data());
+                    });
+                    compare(num_models, q8_8);
+                }
+
+                timeScoring("Separate_Subset_" + format, subset_count, [&]{
+                    for (size_t i= 0; i < subset_count; i++){
+                        probabilities[i]= q8_8? separate[subset[i]].inference_q8_8_to_fp(inputs): separate[subset[i]].inference_fp(inputs);
+                    }
+                });
+                std::memcpy(reference.data(), probabilities.data(), subset_count* sizeof(float));
+                timeScoring("ModelMajor_Subset_" + format, subset_count, [&]{
+                    q8_8? major.inference_subset_q8_8_to_fp(inputs, subset.data(), subset_count, probabilities.data()):
+                        major.inference_subset_fp(inputs, subset.data(), subset_count, probabilities.data());
+                });
+                compare(subset_count, q8_8);
+                if (tiled){
+                    timeScoring("Interleaved_Subset_" + format, subset_count, [&]{
+                        q8_8? tiled->inference_subset_q8_8_to_fp(inputs, subset.data(), subset_count, probabilities.data()):
+                            tiled->inference_subset_fp(inputs, subset.data(), subset_count, probabilities.data());
+                    });
+                    compare(subset_count, q8_8);
+                }
+            }
+
+            //the same step on every copy of one model keeps the three in sync for the next comparison
+            const size_t model= subset[0];
+            const float prediction= separate[model].inference_q8_8_to_fp(inputs);
+            const float label= dist(mt) > 0.0f;
+            auto start= benchClock::now();
+            separate[model].setInputs(inputs.data());
+            separate[model].update_weights(prediction, label);
+            auto end= benchClock::now();
+            latency["Separate_Update"].push_back(benchClock::elapsed(start, end));
+
+            start= benchClock::now();
+            major.update_weights(model, inputs, prediction, label);
+            end= benchClock::now();
+            latency["ModelMajor_Update"].push_back(benchClock::elapsed(start, end));
+
+            if (tiled){
+                start= benchClock::now();
+                tiled->update_weights(model, inputs, prediction, label);
+                end= benchClock::now();
+                latency["Interleaved_Update"].push_back(benchClock::elapsed(start, end));
+            }
+        }
+
+        json count_results;
+        for (auto& [name, timings]: latency){
+            count_results[name + "_Latency"]= analyze_timings(timings, name + (name.ends_with("Update")? " (per update)": " (per model)"));
+        }
+        for (const std::string layout: {"ModelMajor", "Interleaved"}){
+            for (const std::string mode: {"All_Q88", "All_FP32", "Subset_Q88", "Subset_FP32", "Update"}){
+                if (latency.count(layout + "_" + mode)){
+                    count_results[layout + "_" + mode + "_Speedup"]= analyze_p95_speedup(latency[layout + "_" + mode], latency["Separate_" + mode], layout + " vs Separate, " + mode);
+                }
+            }
+        }
+        count_results["Q88_Mismatches"]= q8_8_mismatches;
+        count_results["FP32_Max_Error"]= max_fp_error;
+        benchmark_results[std::to_string(num_models)]= count_results;
+    }
+    std::cout << "Accumulation (to avoid optimization): " << accumulation << std::endl;
+
+    return benchmark_results;
+}
+
+json benchmark_inference_batch(size_t feature_size, int iterations, int reps){
+    constexpr std::array<size_t, 6> batch_sizes{1, 4, 8, 16, 64, 256};
+    constexpr size_t max_batch= batch_sizes.back();
+
+    alignedArray<float> avx_weights(feature_size);
+    alignedArray<float> avx_inputs(max_batch* feature_size);
+    alignedArray<int16_t> avx_q8_8_weights(feature_size);
+    alignedArray<int16_t> avx_q8_8_inputs(max_batch* feature_size);
+    alignedArray<float> avx_outputs(max_batch);
+    alignedArray<int32_t> avx_q16_16_outputs(max_batch);
+
+    std::random_device rd;
+    std::mt19937 mt(rd());
+    std::uniform_real_distribution<float> dist(-1, 1);
+
+    for (size_t j= 0; j < feature_size; j++){
+        avx_weights[j]= dist(mt);
+    }
+    for (size_t j= 0; j < max_batch* feature_size; j++){
+        avx_inputs[j]= dist(mt);
+    }
+    quantize8_8_inplace(avx_weights.data(), avx_q8_8_weights.data(), feature_size);
+    quantize8_8_rows(avx_inputs.data(), avx_q8_8_inputs.data(), max_batch, feature_size, feature_size);
+
+    volatile float accumulation= 0.0f;
+    json benchmark_results;
+
+    for (size_t batch_size: batch_sizes){
+        std::vector<double> avx_latency{};
+        std::vector<double> avx_batch_latency{};
+        std::vector<double> avx_q8_8_latency{};
+        std::vector<double> avx_q8_8_batch_latency{};
+        avx_latency.reserve(iterations);
+        avx_batch_latency.reserve(iterations);
+        avx_q8_8_latency.reserve(iterations);
+        avx_q8_8_batch_latency.reserve(iterations);
+
+        for (int iter= 0; iter < iterations; iter++){
+            auto start= benchClock::now();
+            int16_t avx_result_q8_8= 0;
+            for (int r= 0; r < reps; r++){
+                for (size_t n= 0; n < batch_size; n++){
+                    avx_result_q8_8+= sigmoidApprox_fp_to_q8_8(dotproduct_fp(avx_weights.data(), &avx_inputs[n* feature_size], feature_size));
+                }
+            }
+            auto end= benchClock::now();
+            avx_latency.push_back(benchClock::elapsed(start, end) / (reps* batch_size));
+            accumulation= accumulation + q8_8_to_float(avx_result_q8_8);
+
+            start= benchClock::now();
+            avx_result_q8_8= 0;
+            for (int r= 0; r < reps; r++){
+                dotproduct_fp_batch(avx_weights.data(), avx_inputs.data(), avx_outputs.data(), batch_size, feature_size);
+                for (size_t n= 0; n < batch_size; n++){
+                    avx_result_q8_8+= sigmoidApprox_fp_to_q8_8(avx_outputs[n]);
+                }
+            }
+            end= benchClock::now();
+            avx_batch_latency.push_back(benchClock::elapsed(start, end) / (reps* batch_size));
+            accumulation= accumulation + q8_8_to_float(avx_result_q8_8);
+
+            start= benchClock::now();
+            avx_result_q8_8= 0;
+            for (int r= 0; r < reps; r++){
+                for (size_t n= 0; n < batch_size; n++){
+                    avx_result_q8_8+= sigmoidApprox_q16_16_to_q8_8(dotproduct_q8_8(avx_q8_8_weights.data(), &avx_q8_8_inputs[n* feature_size], feature_size));
+                }
+            }
+            end= benchClock::now();
+            avx_q8_8_latency.push_back(benchClock::elapsed(start, end) / (reps* batch_size));
+            accumulation= accumulation + q8_8_to_float(avx_result_q8_8);
+
+            start= benchClock::now();
+            avx_result_q8_8= 0;
+            for (int r= 0; r < reps; r++){
+                dotproduct_q8_8_batch(avx_q8_8_weights.data(), avx_q8_8_inputs.data(), avx_q16_16_outputs.data(), batch_size, feature_size, feature_size);
+                for (size_t n= 0; n < batch_size; n++){
+                    avx_result_q8_8+= sigmoidApprox_q16_16_to_q8_8(avx_q16_16_outputs[n]);
+                }
+            }
+            end= benchClock::now();
+            avx_q8_8_batch_latency.push_back(benchClock::elapsed(start, end) / (reps* batch_size));
+            accumulation= accumulation + q8_8_to_float(avx_result_q8_8);
+        }
+
+        json batch_results;
+        batch_results["AVX_FP32_Latency"]= analyze_timings(avx_latency, "AVX FP32 Inference (per sample)");
+        batch_results["AVX_FP32_Batch_Latency"]= analyze_timings(avx_batch_latency, "AVX FP32 Batched Inference (per sample)");
+        batch_results["AVX_Q88_Latency"]= analyze_timings(avx_q8_8_latency, "AVX Q(8.8) Inference (per sample)");
+        batch_results["AVX_Q88_Batch_Latency"]= analyze_timings(avx_q8_8_batch_latency, "AVX Q(8.8) Batched Inference (per sample)");
+        batch_results["AVX_FP32_Batch_Speedup"]= analyze_p95_speedup(avx_batch_latency, avx_latency, "AVX FP32 Batched vs Single");
+        batch_results["AVX_Q88_Batch_Speedup"]= analyze_p95_speedup(avx_q8_8_batch_latency, avx_q8_8_latency, "AVX Q(8.8) Batched vs Single");
+        benchmark_results[std::to_string(batch_size)]= batch_results;
+    }
+    std::cout << "Accumulation (to avoid optimization): " << accumulation << std::endl;
+
+    return benchmark_results;
+}
+
+//Activation only, per logit: the exact sigmoid, the 2048-entry Q8.8 table and the interpolated batch kernels
+//Logits span [-12, 12] so the clamped tails are exercised, errors are the max per iteration against double precision
+json benchmark_sigmoid(size_t batch_size, int iterations, int reps){
+    alignedArray<float> logits(batch_size);
+    alignedArray<int32_t> logits_q16_16(batch_size);
+    alignedArray<float> outputs(batch_size);
+    alignedArray<int16_t> outputs_q8_8(batch_size);
+
+    std::random_device rd;
+    std::mt19937 mt(rd());
+    std::uniform_real_distribution<float> dist(-12, 12);
+
+    std::vector<double> exact_latency{};
+    std::vector<double> table_latency{};
+    std::vector<double> interp_q8_8_latency{};
+    std::vector<double> interp_fp_latency{};
+    std::vector<double> table_error{};
+    std::vector<double> interp_q8_8_error{};
+    std::vector<double> interp_fp_error{};
+
+    volatile float accumulation= 0.0f;
+
+    for (int iter= 0; iter < iterations; iter++){
+        for (size_t n= 0; n < batch_size; n++){
+            logits_q16_16[n]= static_cast<int32_t>(dist(mt)* 65536.0f);
+            logits[n]= logits_q16_16[n]/ 65536.0f;
+        }
+
+        auto start= benchClock::now();
+        for (int r= 0; r < reps; r++){
+            for (size_t n= 0; n < batch_size; n++){
+                outputs[n]= sigmoid_fp(logits[n]);
+            }
+            accumulation= accumulation + outputs[batch_size - 1];
+        }
+        auto end= benchClock::now();
+        exact_latency.push_back(benchClock::elapsed(start, end)/ (reps* batch_size));
+
+        start= benchClock::now();
+        for (int r= 0; r < reps; r++){
+            for (size_t n= 0; n < batch_size; n++){
+                outputs_q8_8[n]= sigmoidApprox_q16_16_to_q8_8(logits_q16_16[n]);
+            }
+            accumulation= accumulation + outputs_q8_8[batch_size - 1];
+        }
+        end= benchClock::now();
+        table_latency.push_back(benchClock::elapsed(start, end)/ (reps* batch_size));
+
+        double max_error= 0.0;
+        for (size_t n= 0; n < batch_size; n++){
+            max_error= std::max(max_error, std::fabs(q8_8_to_float(outputs_q8_8[n]) - 1.0/ (1.0 + std::exp(-static_cast<double>(logits[n])))));
+        }
+        table_error.push_back(max_error);
+
+        start= benchClock::now();
+        for (int r= 0; r < reps; r++){
+            sigmoid_batch_q16_16_to_q8_8(logits_q16_16.data(), outputs_q8_8.data(), batch_size);
+            accumulation= accumulation + outputs_q8_8[batch_size - 1];
+        }
+        end= benchClock::now();
+        interp_q8_8_latency.push_back(benchClock::elapsed(start, end)/ (reps* batch_size));
+
+        max_error= 0.0;
+        for (size_t n= 0; n < batch_size; n++){
+            max_error= std::max(max_error, std::fabs(q8_8_to_float(outputs_q8_8[n]) - 1.0/ (1.0 + std::exp(-static_cast<double>(logits[n])))));
+        }
+        interp_q8_8_error.push_back(max_error);
+
+        start= benchClock::now();
+        for (int r= 0; r < reps; r++){
+            sigmoid_batch_fp(logits.data(), outputs.data(), batch_size);
+            accumulation= accumulation + outputs[batch_size - 1];
+        }
+        end= benchClock::now();
+        interp_fp_latency.push_back(benchClock::elapsed(start, end)/ (reps* batch_size));
+
+        max_error= 0.0;
+        for (size_t n= 0; n < batch_size; n++){
+            max_error= std::max(max_error, std::fabs(outputs[n] - 1.0/ (1.0 + std::exp(-static_cast<double>(logits[n])))));
+        }
+        interp_fp_error.push_back(max_error);
+    }
+
+    json benchmark_results;
+    benchmark_results["Exact_Latency"]= analyze_timings(exact_latency, "sigmoid_fp (per logit)");
+    benchmark_results["Table_Q88_Latency"]= analyze_timings(table_latency, "sigmoidApprox_q16_16_to_q8_8 (per logit)");
+    benchmark_results["Interp_Q88_Latency"]= analyze_timings(interp_q8_8_latency, "sigmoid_batch_q16_16_to_q8_8 (per logit)");
+    benchmark_results["Interp_FP32_Latency"]= analyze_timings(interp_fp_latency, "sigmoid_batch_fp, FP32 table (per logit)");
+    benchmark_results["Interp_Q88_Table_Speedup"]= analyze_p95_speedup(interp_q8_8_latency, table_latency, "Interpolated Q(8.8) batch vs Q(8.8) table");
+    benchmark_results["Interp_FP32_Exact_Speedup"]= analyze_p95_speedup(interp_fp_latency, exact_latency, "Interpolated FP32 batch vs exact");
+    benchmark_results["Table_Q88_Error"]= analyze_errors(table_error, "Q(8.8) table vs exact (max per batch)");
+    benchmark_results["Interp_Q88_Error"]= analyze_errors(interp_q8_8_error, "Interpolated Q(8.8) vs exact (max per batch)");
+    benchmark_results["Interp_FP32_Error"]= analyze_errors(interp_fp_error, "Interpolated FP32 vs exact (max per batch)");
     std::cout << "Accumulation (to avoid optimization): " << accumulation << std::endl;
 
     return benchmark_results;
 }
 
-template <size_t feature_size>
-json benchmark_sgd(int iterations, int reps){
+json benchmark_sgd(size_t feature_size, int iterations, int reps){
+    const KernelTable& isa_kernels= kernels();
     alignedArray<float> avx_weights(feature_size);
     alignedArray<float> avx_inputs(feature_size);
-    std::array<float, feature_size> scalar_weights{};
-    std::array<float, feature_size> scalar_inputs{};
+    std::vector<float> scalar_weights(feature_size);
+    std::vector<float> scalar_inputs(feature_size);
 
     std::random_device rd;
     std::mt19937 mt(rd());
@@ -214,6 +944,10 @@ json benchmark_sgd(int iterations, int reps){
     avx_latency.reserve(iterations);
     avx_fp_error.reserve(iterations);
 
+    PerfCounters counters;
+    perfRegion avx_counters;
+    perfRegion scalar_counters;
+
     for(int i= 0; i < 100; i ++){
         for(size_t j= 0; j < feature_size; j ++){
             float rand_w= dist(mt);
@@ -233,7 +967,7 @@ json benchmark_sgd(int iterations, int reps){
         auto scalar_weights_copy= scalar_weights;
 
         int16_t y_hat_q8_8= float_to_q8_8(y_hat);
-        sgd_inplace(y_hat_q8_8, y, avx_weights_copy.data(), avx_inputs.data(), feature_size, 0.001);
+        isa_kernels.sgd_inplace(y_hat_q8_8, y, avx_weights_copy.data(), avx_inputs.data(), feature_size, 0.001);
         sgd_inplace_scalar(y_hat, y, scalar_weights_copy.data(), scalar_inputs.data(), feature_size, 0.001);
     }
 
@@ -255,24 +989,28 @@ json benchmark_sgd(int iterations, int reps){
         auto avx_weights_copy= avx_weights.deepCopy();
         auto scalar_weights_copy= scalar_weights;
 
-        auto start= std::chrono::high_resolution_clock::now();
+        counters.begin();
+        auto start= benchClock::now();
         int16_t y_hat_q8_8= float_to_q8_8(y_hat);
         for (int r= 0; r < reps; r++){
-            sgd_inplace(y_hat_q8_8, y, avx_weights_copy.data(), avx_inputs.data(), feature_size, 0.001);
+            isa_kernels.sgd_inplace(y_hat_q8_8, y, avx_weights_copy.data(), avx_inputs.data(), feature_size, 0.001);
         }
-        auto end= std::chrono::high_resolution_clock::now();
-        avx_latency.push_back(std::chrono::duration<double, std::nano>(end - start).count() / reps);
+        auto end= benchClock::now();
+        counters.end(avx_counters, reps);
+        avx_latency.push_back(benchClock::elapsed(start, end) / reps);
 
-        start= std::chrono::high_resolution_clock::now();
+        counters.begin();
+        start= benchClock::now();
         for (int r= 0; r < reps; r++){
             sgd_inplace_scalar(y_hat, y, scalar_weights_copy.data(), scalar_inputs.data(), feature_size, 0.001);
         }
-        end= std::chrono::high_resolution_clock::now();
-        scalar_latency.push_back(std::chrono::duration<double, std::nano>(end - start).count() / reps);
+        end= benchClock::now();
+        counters.end(scalar_counters, reps);
+        scalar_latency.push_back(benchClock::elapsed(start, end) / reps);
 
         avx_weights_copy= avx_weights.deepCopy();
         scalar_weights_copy= scalar_weights;
-        sgd_inplace(y_hat_q8_8, y, avx_weights_copy.data(), avx_inputs.data(), feature_size, 0.001);
+        isa_kernels.sgd_inplace(y_hat_q8_8, y, avx_weights_copy.data(), avx_inputs.data(), feature_size, 0.001);
         sgd_inplace_scalar(y_hat, y, scalar_weights_copy.data(), scalar_inputs.data(), feature_size, 0.001);
 
         float sum_abs_diff= 0.0f;
@@ -288,48 +1026,1731 @@ json benchmark_sgd(int iterations, int reps){
     benchmark_results["AVX_FP32_Latency"]= analyze_timings(avx_latency, "AVX FP32 SGD");
     benchmark_results["AVX_FP32_Scalar_Speedup"]= analyze_p95_speedup(avx_latency, scalar_latency, "AVX FP32 vs Scalar");
     benchmark_results["AVX_FP32_Error"]= analyze_errors(avx_fp_error, "AVX FP32 Error");
+    benchmark_results["Counters"]["Scalar_FP32"]= counters.summary(scalar_counters);
+    benchmark_results["Counters"]["AVX_FP32"]= counters.summary(avx_counters);
 
     return benchmark_results;
 }
 
-int main() {
-    std::ofstream SGD_Benchmark("SGD_Benchmark.json");
-    json data_SGD;
-
-    data_SGD["16"]= benchmark_sgd<16>(1e5, 100);
-    data_SGD["32"]= benchmark_sgd<32>(1e5, 100);
-    data_SGD["64"]= benchmark_sgd<64>(1e5, 100);
-    data_SGD["128"]= benchmark_sgd<128>(1e5, 100);
-    data_SGD["256"]= benchmark_sgd<256>(1e5, 100);
-    data_SGD["512"]= benchmark_sgd<512>(1e5, 100);
-    data_SGD["1024"]= benchmark_sgd<1024>(1e5, 100);
-    data_SGD["2048"]= benchmark_sgd<2048>(1e5, 100);
-    data_SGD["4096"]= benchmark_sgd<4096>(1e5, 100);
-    data_SGD["8192"]= benchmark_sgd<8192>(1e5, 100);
-    data_SGD["16384"]= benchmark_sgd<16384>(1e5, 100);
-    data_SGD["32768"]= benchmark_sgd<32768>(1e5, 100);
-
-    SGD_Benchmark << data_SGD.dump(4);
-    SGD_Benchmark.close();
-
-    std::ofstream Inference_Benchmark("Inference_Benchmark.json");
-    json data_Inf;
-
-    data_Inf["16"]= benchmark_inference<16>(1e5, 100);
-    data_Inf["32"]= benchmark_inference<32>(1e5, 100);
-    data_Inf["64"]= benchmark_inference<64>(1e5, 100);
-    data_Inf["128"]= benchmark_inference<128>(1e5, 100);
-    data_Inf["256"]= benchmark_inference<256>(1e5, 100);
-    data_Inf["512"]= benchmark_inference<512>(1e5, 100);
-    data_Inf["1024"]= benchmark_inference<1024>(1e5, 100);
-    data_Inf["2048"]= benchmark_inference<2048>(1e5, 100);
-    data_Inf["4096"]= benchmark_inference<4096>(1e5, 100);
-    data_Inf["8192"]= benchmark_inference<8192>(1e5, 100);
-    data_Inf["16384"]= benchmark_inference<16384>(1e5, 100);
-    data_Inf["32768"]= benchmark_inference<32768>(1e5, 100);
-
-    Inference_Benchmark << data_Inf.dump(4);
-    Inference_Benchmark.close();
+json benchmark_adamw(size_t feature_size, int iterations, int reps){
+    alignedArray<float> avx_weights(feature_size);
+    alignedArray<float> avx_inputs(feature_size);
+    std::vector<float> scalar_weights(feature_size);
+    std::vector<float> scalar_inputs(feature_size);
 
-    return 0;
-}
\ No newline at end of file
+    std::random_device rd;
+    std::mt19937 mt(rd());
+    std::uniform_real_distribution<float> dist(-1, 1);
+
+    std::vector<double> scalar_latency{};
+    std::vector<double> avx_latency{};
+    std::vector<double> avx_fp_error{};
+    scalar_latency.reserve(iterations);
+    avx_latency.reserve(iterations);
+    avx_fp_error.reserve(iterations);
+
+    AdamWParams avx_params(feature_size);
+    AdamWParams scalar_params(feature_size);
+
+    for (int i = 0; i < iterations; i ++){
+        for(size_t j= 0; j < feature_size; j ++){
+            float rand_w= dist(mt);
+            float rand_x= dist(mt);
+
+            avx_weights[j]= rand_w;
+            avx_inputs[j]=  rand_x;
+
+            scalar_weights[j]= rand_w;
+            scalar_inputs[j]= rand_x;
+        }
+
+        float y= dist(mt);
+        float y_hat= dist(mt);
+
+        auto avx_weights_copy= avx_weights.deepCopy();
+        auto scalar_weights_copy= scalar_weights;
+
+        auto start= benchClock::now();
+        int16_t y_hat_q8_8= float_to_q8_8(y_hat);
+        for (int r= 0; r < reps; r++){
+            adamW_inplace(y_hat_q8_8, y, avx_weights_copy.data(), avx_inputs.data(), feature_size, avx_params);
+        }
+        auto end= benchClock::now();
+        avx_latency.push_back(benchClock::elapsed(start, end) / reps);
+
+        start= benchClock::now();
+        for (int r= 0; r < reps; r++){
+            adamW_inplace_scalar(y_hat, y, scalar_weights_copy.data(), scalar_inputs.data(), feature_size, scalar_params);
+        }
+        end= benchClock::now();
+        scalar_latency.push_back(benchClock::elapsed(start, end) / reps);
+
+        //Single step from identical optimizer state
+        AdamWParams avx_step_params(feature_size);
+        AdamWParams scalar_step_params(feature_size);
+        avx_weights_copy= avx_weights.deepCopy();
+        scalar_weights_copy= scalar_weights;
+        adamW_inplace(y_hat_q8_8, y, avx_weights_copy.data(), avx_inputs.data(), feature_size, avx_step_params);
+        adamW_inplace_scalar(q8_8_to_float(y_hat_q8_8), y, scalar_weights_copy.data(), scalar_inputs.data(), feature_size, scalar_step_params);
+
+        float sum_abs_diff= 0.0f;
+        for (size_t j = 0; j < feature_size; j ++){
+            sum_abs_diff+= std::fabs(avx_weights_copy[j] - scalar_weights_copy[j]);
+        }
+
+        avx_fp_error.push_back(sum_abs_diff/ feature_size);
+    }
+
+    json benchmark_results;
+    benchmark_results["Scalar_FP32_Latency"]= analyze_timings(scalar_latency, "Scalar FP32 AdamW");
+    benchmark_results["AVX_FP32_Latency"]= analyze_timings(avx_latency, "AVX FP32 AdamW");
+    benchmark_results["AVX_FP32_Scalar_Speedup"]= analyze_p95_speedup(avx_latency, scalar_latency, "AVX FP32 vs Scalar");
+    benchmark_results["AVX_FP32_Error"]= analyze_errors(avx_fp_error, "AVX FP32 Error");
+
+    return benchmark_results;
+}
+
+json benchmark_sgd_batch(size_t feature_size, int iterations, int reps){
+    constexpr std::array<size_t, 5> batch_sizes{1, 4, 16, 64, 256};
+    constexpr size_t max_batch= batch_sizes.back();
+
+    alignedArray<float> avx_weights(feature_size);
+    alignedArray<int16_t> avx_q8_8_weights(feature_size);
+    alignedArray<float> avx_inputs(max_batch* feature_size);
+    alignedArray<float> y_hat(max_batch);
+    alignedArray<float> y(max_batch);
+
+    std::random_device rd;
+    std::mt19937 mt(rd());
+    std::uniform_real_distribution<float> dist(-1, 1);
+
+    for (size_t j= 0; j < feature_size; j++){
+        avx_weights[j]= dist(mt);
+    }
+    for (size_t j= 0; j < max_batch* feature_size; j++){
+        avx_inputs[j]= dist(mt);
+    }
+    for (size_t n= 0; n < max_batch; n++){
+        y_hat[n]= dist(mt);
+        y[n]= dist(mt);
+    }
+
+    json benchmark_results;
+
+    for (size_t batch_size: batch_sizes){
+        std::vector<double> avx_latency{};
+        std::vector<double> avx_batch_latency{};
+        std::vector<double> avx_batch_error{};
+        avx_latency.reserve(iterations);
+        avx_batch_latency.reserve(iterations);
+        avx_batch_error.reserve(iterations);
+
+        for (int iter= 0; iter < iterations; iter++){
+            auto avx_weights_copy= avx_weights.deepCopy();
+            auto start= benchClock::now();
+            for (int r= 0; r < reps; r++){
+                for (size_t n= 0; n < batch_size; n++){
+                    sgd_inplace(float_to_q8_8(y_hat[n]), y[n], avx_weights_copy.data(), &avx_inputs[n* feature_size], feature_size, 1e-6);
+                    quantize8_8_inplace(avx_weights_copy.data(), avx_q8_8_weights.data(), feature_size);
+                }
+            }
+            auto end= benchClock::now();
+            avx_latency.push_back(benchClock::elapsed(start, end) / (reps* batch_size));
+
+            auto avx_batch_weights_copy= avx_weights.deepCopy();
+            start= benchClock::now();
+            for (int r= 0; r < reps; r++){
+                sgd_batch_inplace(y_hat.data(), y.data(), avx_batch_weights_copy.data(), avx_q8_8_weights.data(), avx_inputs.data(), batch_size, feature_size, 1e-6);
+            }
+            end= benchClock::now();
+            avx_batch_latency.push_back(benchClock::elapsed(start, end) / (reps* batch_size));
+
+            float sum_abs_diff= 0.0f;
+            for (size_t j= 0; j < feature_size; j++){
+                sum_abs_diff+= std::fabs(avx_batch_weights_copy[j] - avx_weights_copy[j]);
+            }
+            avx_batch_error.push_back(sum_abs_diff/ feature_size);
+        }
+
+        json batch_results;
+        batch_results["AVX_FP32_Latency"]= analyze_timings(avx_latency, "AVX FP32 SGD + Requantize (per sample)");
+        batch_results["AVX_FP32_Batch_Latency"]= analyze_timings(avx_batch_latency, "AVX FP32 Mini-batch SGD (per sample)");
+        batch_results["AVX_FP32_Batch_Speedup"]= analyze_p95_speedup(avx_batch_latency, avx_latency, "AVX FP32 Mini-batch vs Per-sample");
+        batch_results["AVX_FP32_Batch_Error"]= analyze_errors(avx_batch_error, "AVX FP32 Mini-batch vs Per-sample");
+        benchmark_results[std::to_string(batch_size)]= batch_results;
+    }
+
+    return benchmark_results;
+}
+
+json benchmark_sparse(size_t feature_size, int iterations, int reps){
+    constexpr std::array<float, 2> densities{0.01f, 0.03f};
+
+    alignedArray<float> avx_weights(feature_size);
+    alignedArray<int16_t> avx_q8_8_weights(feature_size + 1);
+    alignedArray<float> avx_inputs(feature_size);
+    alignedArray<int16_t> avx_q8_8_inputs(feature_size);
+    sparseArray sparse_inputs(feature_size);
+
+    std::random_device rd;
+    std::mt19937 mt(rd());
+    std::uniform_real_distribution<float> dist(-1, 1);
+    std::uniform_real_distribution<float> coin(0, 1);
+
+    for (size_t j= 0; j < feature_size; j++){
+        avx_weights[j]= dist(mt);
+    }
+    quantize8_8_inplace(avx_weights.data(), avx_q8_8_weights.data(), feature_size);
+    avx_q8_8_weights[feature_size]= 0;
+
+    volatile float accumulation= 0.0f;
+    json benchmark_results;
+
+    for (float density: densities){
+        std::vector<double> avx_latency{};
+        std::vector<double> avx_q8_8_latency{};
+        std::vector<double> sparse_latency{};
+        std::vector<double> sparse_q8_8_latency{};
+        std::vector<double> avx_sgd_latency{};
+        std::vector<double> sparse_sgd_latency{};
+        std::vector<double> sparse_q8_8_error{};
+
+        for (int iter= 0; iter < iterations; iter++){
+            sparse_inputs.clear();
+            for (size_t j= 0; j < feature_size; j++){
+                avx_inputs[j]= 0.0f;
+                if (coin(mt) < density){
+                    avx_inputs[j]= dist(mt);
+                    sparse_inputs.push_back(j, avx_inputs[j]);
+                }
+            }
+            quantize8_8_inplace(avx_inputs.data(), avx_q8_8_inputs.data(), feature_size);
+
+            auto start= benchClock::now();
+            int16_t result_q8_8= 0;
+            for (int r= 0; r < reps; r++){
+                result_q8_8+= sigmoidApprox_fp_to_q8_8(dotproduct_fp(avx_weights.data(), avx_inputs.data(), feature_size));
+            }
+            auto end= benchClock::now();
+            avx_latency.push_back(benchClock::elapsed(start, end) / reps);
+            accumulation= accumulation + q8_8_to_float(result_q8_8);
+
+            start= benchClock::now();
+            result_q8_8= 0;
+            for (int r= 0; r < reps; r++){
+                result_q8_8+= sigmoidApprox_q16_16_to_q8_8(dotproduct_q8_8(avx_q8_8_weights.data(), avx_q8_8_inputs.data(), feature_size));
+            }
+            end= benchClock::now();
+            avx_q8_8_latency.push_back(benchClock::elapsed(start, end) / reps);
+            accumulation= accumulation + q8_8_to_float(result_q8_8);
+
+            start= benchClock::now();
+            result_q8_8= 0;
+            for (int r= 0; r < reps; r++){
+                result_q8_8+= sigmoidApprox_fp_to_q8_8(dotproduct_sparse_fp(avx_weights.data(), sparse_inputs.indices.data(), sparse_inputs.values.data(), sparse_inputs.nnz));
+            }
+            end= benchClock::now();
+            sparse_latency.push_back(benchClock::elapsed(start, end) / reps);
+            accumulation= accumulation + q8_8_to_float(result_q8_8);
+
+            start= benchClock::now();
+            result_q8_8= 0;
+            for (int r= 0; r < reps; r++){
+                result_q8_8+= sigmoidApprox_q16_16_to_q8_8(dotproduct_sparse_q8_8(avx_q8_8_weights.data(), sparse_inputs.indices.data(), sparse_inputs.values.data(), sparse_inputs.nnz));
+            }
+            end= benchClock::now();
+            sparse_q8_8_latency.push_back(benchClock::elapsed(start, end) / reps);
+            accumulation= accumulation + q8_8_to_float(result_q8_8);
+
+            auto avx_weights_copy= avx_weights.deepCopy();
+            start= benchClock::now();
+            for (int r= 0; r < reps; r++){
+                sgd_inplace(float_to_q8_8(0.5f), 1.0f, avx_weights_copy.data(), avx_inputs.data(), feature_size, 1e-6);
+                quantize8_8_inplace(avx_weights_copy.data(), avx_q8_8_weights.data(), feature_size);
+            }
+            end= benchClock::now();
+            avx_sgd_latency.push_back(benchClock::elapsed(start, end) / reps);
+
+            avx_weights_copy= avx_weights.deepCopy();
+            start= benchClock::now();
+            for (int r= 0; r < reps; r++){
+                sgd_sparse_inplace(float_to_q8_8(0.5f), 1.0f, avx_weights_copy.data(), avx_q8_8_weights.data(), sparse_inputs.indices.data(), sparse_inputs.values.data(), sparse_inputs.nnz, 1e-6);
+            }
+            end= benchClock::now();
+            sparse_sgd_latency.push_back(benchClock::elapsed(start, end) / reps);
+            quantize8_8_inplace(avx_weights.data(), avx_q8_8_weights.data(), feature_size);
+
+            float scalar_result= sigmoid_fp(dotproduct_scalar(avx_weights.data(), avx_inputs.data(), feature_size));
+            float sparse_q8_8_result= q8_8_to_float(sigmoidApprox_q16_16_to_q8_8(dotproduct_sparse_q8_8(avx_q8_8_weights.data(), sparse_inputs.indices.data(), sparse_inputs.values.data(), sparse_inputs.nnz)));
+            sparse_q8_8_error.push_back(std::fabs(sparse_q8_8_result - scalar_result));
+        }
+
+        json density_results;
+        density_results["AVX_FP32_Latency"]= analyze_timings(avx_latency, "AVX FP32 Dense Inference");
+        density_results["AVX_Q88_Latency"]= analyze_timings(avx_q8_8_latency, "AVX Q(8.8) Dense Inference");
+        density_results["AVX_FP32_Sparse_Latency"]= analyze_timings(sparse_latency, "AVX FP32 Sparse Inference");
+        density_results["AVX_Q88_Sparse_Latency"]= analyze_timings(sparse_q8_8_latency, "AVX Q(8.8) Sparse Inference");
+        density_results["AVX_FP32_SGD_Latency"]= analyze_timings(avx_sgd_latency, "AVX FP32 Dense SGD + Requantize");
+        density_results["AVX_FP32_Sparse_SGD_Latency"]= analyze_timings(sparse_sgd_latency, "AVX FP32 Sparse SGD");
+        density_results["AVX_Q88_Sparse_Error"]= analyze_errors(sparse_q8_8_error, "AVX Q(8.8) Sparse vs Scalar");
+        density_results["AVX_FP32_Sparse_Speedup"]= analyze_p95_speedup(sparse_latency, avx_latency, "AVX FP32 Sparse vs Dense");
+        density_results["AVX_Q88_Sparse_Speedup"]= analyze_p95_speedup(sparse_q8_8_latency, avx_q8_8_latency, "AVX Q(8.8) Sparse vs Dense");
+        density_results["AVX_FP32_Sparse_SGD_Speedup"]= analyze_p95_speedup(sparse_sgd_latency, avx_sgd_latency, "AVX FP32 Sparse SGD vs Dense");
+        benchmark_results[std::to_string(density)]= density_results;
+    }
+    std::cout << "Accumulation (to avoid optimization): " << accumulation << std::endl;
+
+    return benchmark_results;
+}
+
+//Raw 64-bit categorical ids into a feature_size model: today's path (hash into a zeroed dense vector, dense predict
+//and update) against FeatureHasher + sparse predict and update, plus the hashing kernels on their own
+//Both models start from the same weights and see the same events, so their Q(8.8) predictions must stay identical
+json benchmark_feature_hashing(size_t feature_size, int iterations, int reps){
+    constexpr std::array<size_t, 2> active_counts{32, 256};
+    constexpr uint64_t seed= 0x9E3779B97F4A7C15ull;
+
+    std::random_device rd;
+    std::mt19937_64 mt(rd());
+    std::uniform_real_distribution<float> dist(0, 1);
+
+    SGDLogisticRegression dense_model(feature_size);
+    SGDLogisticRegression hashed_model(feature_size);
+    alignedArray<float> weights(feature_size);
+    std::memcpy(weights.data(), dense_model.weights(), feature_size* sizeof(float));
+    hashed_model.setWeights(weights.data());
+
+    FeatureHasher hasher(feature_size, seed);
+    alignedArray<float> dense_inputs(feature_size);
+
+    volatile float accumulation= 0.0f;
+    json benchmark_results;
+
+    for (size_t count: active_counts){
+        alignedArray<uint64_t> ids(count);
+        alignedArray<float> values(count);
+        alignedArray<int32_t> indices(count);
+        alignedArray<float> hashed_values(count);
+        alignedArray<int32_t> reference_indices(count);
+        alignedArray<float> reference_values(count);
+
+        std::vector<double> scalar_hash_latency{};
+        std::vector<double> avx_hash_latency{};
+        std::vector<double> hasher_latency{};
+        std::vector<double> dense_step_latency{};
+        std::vector<double> hashed_step_latency{};
+        size_t hash_mismatches= 0;
+        size_t q8_8_mismatches= 0;
+        size_t collisions= 0;
+
+        for (int iter= 0; iter < iterations; iter++){
+            for (size_t i= 0; i < count; i++){
+                ids[i]= mt();
+                values[i]= dist(mt);
+            }
+            const float label= dist(mt) > 0.5f;
+
+            auto start= benchClock::now();
+            for (int r= 0; r < reps; r++){
+                for (size_t i= 0; i < count; i++){
+                    uint64_t h= hash_feature_id(ids[i], seed);
+                    reference_indices[i]= hashed_index(h, static_cast<uint32_t>(feature_size));
+                    reference_values[i]= values[i]* hashed_sign(h);
+                }
+            }
+            auto end= benchClock::now();
+            scalar_hash_latency.push_back(benchClock::elapsed(start, end) / reps);
+
+            start= benchClock::now();
+            for (int r= 0; r < reps; r++){
+                hash_features(ids.data(), values.data(), count, seed, static_cast<uint32_t>(feature_size), indices.data(), hashed_values.data());
+            }
+            end= benchClock::now();
+            avx_hash_latency.push_back(benchClock::elapsed(start, end) / reps);
+            hash_mismatches+= std::memcmp(indices.data(), reference_indices.data(), count* sizeof(int32_t)) != 0 ||
+                std::memcmp(hashed_values.data(), reference_values.data(), count* sizeof(float)) != 0;
+
+            start= benchClock::now();
+            for (int r= 0; r < reps; r++){
+                accumulation= accumulation + hasher.hash(ids.data(), nullptr, count).values[0];
+            }
+            end= benchClock::now();
+            hasher_latency.push_back(benchClock::elapsed(start, end) / reps);
+            collisions+= count - hasher.hash(ids.data(), nullptr, count).nnz;
+
+            float dense_prediction= 0.0f;
+            start= benchClock::now();
+            for (int r= 0; r < reps; r++){
+                std::memset(dense_inputs.data(), 0, feature_size* sizeof(float));
+                for (size_t i= 0; i < count; i++){
+                    uint64_t h= hash_feature_id(ids[i], seed);
+                    dense_inputs[hashed_index(h, static_cast<uint32_t>(feature_size))]+= hashed_sign(h);
+                }
+                dense_model.setInputs(dense_inputs.data());
+                dense_prediction= dense_model.inference_q8_8_to_fp(dense_inputs);
+                dense_model.update_weights(dense_prediction, label);
+            }
+            end= benchClock::now();
+            dense_step_latency.push_back(benchClock::elapsed(start, end) / reps);
+
+            float hashed_prediction= 0.0f;
+            start= benchClock::now();
+            for (int r= 0; r < reps; r++){
+                sparseArray& features= hasher.hash(ids.data(), nullptr, count);
+                hashed_prediction= hashed_model.inference_sparse_q8_8_to_fp(features);
+                hashed_model.update_weights_sparse(features, hashed_prediction, label);
+            }
+            end= benchClock::now();
+            hashed_step_latency.push_back(benchClock::elapsed(start, end) / reps);
+            q8_8_mismatches+= dense_prediction != hashed_prediction;
+            accumulation= accumulation + dense_prediction + hashed_prediction;
+        }
+
+        json count_results;
+        count_results["Scalar_Hash_Latency"]= analyze_timings(scalar_hash_latency, "Scalar Hash");
+        count_results["AVX_Hash_Latency"]= analyze_timings(avx_hash_latency, "AVX Hash");
+        count_results["Hasher_Latency"]= analyze_timings(hasher_latency, "FeatureHasher (Hash + Merge Collisions)");
+        count_results["Dense_Step_Latency"]= analyze_timings(dense_step_latency, "Dense Input + Q(8.8) Inference + SGD");
+        count_results["Hashed_Step_Latency"]= analyze_timings(hashed_step_latency, "Hashed Input + Sparse Q(8.8) Inference + SGD");
+        count_results["AVX_Hash_Speedup"]= analyze_p95_speedup(avx_hash_latency, scalar_hash_latency, "AVX Hash vs Scalar");
+        count_results["Hashed_Step_Speedup"]= analyze_p95_speedup(hashed_step_latency, dense_step_latency, "Hashed vs Dense Step");
+        count_results["Hash_Mismatches"]= hash_mismatches;
+        count_results["Q88_Mismatches"]= q8_8_mismatches;
+        count_results["Collisions_Per_Event"]= static_cast<double>(collisions)/ iterations;
+        benchmark_results[std::to_string(count)]= count_results;
+    }
+    std::cout << "Accumulation (to avoid optimization): " << accumulation << std::endl;
+
+    return benchmark_results;
+}
+
+json benchmark_softmax(size_t feature_size, int iterations, int reps){
+    constexpr std::array<size_t, 6> class_counts{2, 4, 8, 16, 32, 64};
+    constexpr size_t max_classes= class_counts.back();
+
+    //Row-major K x F for the K independent binary models, feature-major F x K for softmax
+    alignedArray<float> binary_weights(max_classes* feature_size);
+    alignedArray<int16_t> binary_q8_8_weights(max_classes* feature_size);
+    alignedArray<float> softmax_weights(feature_size* max_classes);
+    alignedArray<int16_t> softmax_q8_8_weights(feature_size* max_classes);
+    alignedArray<float> avx_inputs(feature_size);
+    alignedArray<int16_t> avx_q8_8_inputs(feature_size);
+    alignedArray<float> logits(max_classes);
+    alignedArray<int32_t> logits_q16_16(max_classes);
+    alignedArray<float> neg_coeff(max_classes);
+
+    std::random_device rd;
+    std::mt19937 mt(rd());
+    std::uniform_real_distribution<float> dist(-1, 1);
+
+    for (size_t j= 0; j < max_classes* feature_size; j++){
+        binary_weights[j]= dist(mt);
+        softmax_weights[j]= dist(mt);
+    }
+    for (size_t j= 0; j < feature_size; j++){
+        avx_inputs[j]= dist(mt);
+    }
+    for (size_t k= 0; k < max_classes; k++){
+        neg_coeff[k]= 1e-6f* dist(mt);
+    }
+    quantize8_8_inplace(binary_weights.data(), binary_q8_8_weights.data(), max_classes* feature_size);
+    quantize8_8_inplace(softmax_weights.data(), softmax_q8_8_weights.data(), max_classes* feature_size);
+    quantize8_8_inplace(avx_inputs.data(), avx_q8_8_inputs.data(), feature_size);
+
+    volatile float accumulation= 0.0f;
+    json benchmark_results;
+
+    for (size_t num_classes: class_counts){
+        size_t class_stride= (num_classes + 7) & ~size_t(7);
+
+        std::vector<double> binary_latency{};
+        std::vector<double> softmax_latency{};
+        std::vector<double> binary_q8_8_latency{};
+        std::vector<double> softmax_q8_8_latency{};
+        std::vector<double> binary_sgd_latency{};
+        std::vector<double> softmax_sgd_latency{};
+
+        for (int iter= 0; iter < iterations; iter++){
+            auto start= benchClock::now();
+            float result= 0.0f;
+            for (int r= 0; r < reps; r++){
+                for (size_t k= 0; k < num_classes; k++){
+                    result+= q8_8_to_float(sigmoidApprox_fp_to_q8_8(dotproduct_fp(&binary_weights[k* feature_size], avx_inputs.data(), feature_size)));
+                }
+            }
+            auto end= benchClock::now();
+            binary_latency.push_back(benchClock::elapsed(start, end) / reps);
+            accumulation= accumulation + result;
+
+            start= benchClock::now();
+            result= 0.0f;
+            for (int r= 0; r < reps; r++){
+                softmax_logits_fp(softmax_weights.data(), avx_inputs.data(), logits.data(), class_stride, feature_size);
+                softmax_inplace(logits.data(), num_classes, class_stride);
+                result+= logits[0];
+            }
+            end= benchClock::now();
+            softmax_latency.push_back(benchClock::elapsed(start, end) / reps);
+            accumulation= accumulation + result;
+
+            start= benchClock::now();
+            result= 0.0f;
+            for (int r= 0; r < reps; r++){
+                for (size_t k= 0; k < num_classes; k++){
+                    result+= q8_8_to_float(sigmoidApprox_q16_16_to_q8_8(dotproduct_q8_8(&binary_q8_8_weights[k* feature_size], avx_q8_8_inputs.data(), feature_size)));
+                }
+            }
+            end= benchClock::now();
+            binary_q8_8_latency.push_back(benchClock::elapsed(start, end) / reps);
+            accumulation= accumulation + result;
+
+            start= benchClock::now();
+            result= 0.0f;
+            for (int r= 0; r < reps; r++){
+                softmax_logits_q8_8(softmax_q8_8_weights.data(), avx_q8_8_inputs.data(), logits_q16_16.data(), class_stride, feature_size);
+                for (size_t k= 0; k < class_stride; k++){
+                    logits[k]= logits_q16_16[k]/ (SCALE_FACTOR* SCALE_FACTOR);
+                }
+                softmax_inplace(logits.data(), num_classes, class_stride);
+                result+= logits[0];
+            }
+            end= benchClock::now();
+            softmax_q8_8_latency.push_back(benchClock::elapsed(start, end) / reps);
+            accumulation= accumulation + result;
+
+            start= benchClock::now();
+            for (int r= 0; r < reps; r++){
+                for (size_t k= 0; k < num_classes; k++){
+                    sgd_inplace(float_to_q8_8(0.5f), 1.0f, &binary_weights[k* feature_size], avx_inputs.data(), feature_size, 1e-6);
+                }
+            }
+            end= benchClock::now();
+            binary_sgd_latency.push_back(benchClock::elapsed(start, end) / reps);
+
+            start= benchClock::now();
+            for (int r= 0; r < reps; r++){
+                softmax_sgd_inplace(neg_coeff.data(), softmax_weights.data(), avx_inputs.data(), class_stride, feature_size);
+            }
+            end= benchClock::now();
+            softmax_sgd_latency.push_back(benchClock::elapsed(start, end) / reps);
+        }
+
+        json class_results;
+        class_results["AVX_FP32_Binary_Latency"]= analyze_timings(binary_latency, "AVX FP32 K x Binary Inference");
+        class_results["AVX_FP32_Softmax_Latency"]= analyze_timings(softmax_latency, "AVX FP32 Softmax Inference");
+        class_results["AVX_Q88_Binary_Latency"]= analyze_timings(binary_q8_8_latency, "AVX Q(8.8) K x Binary Inference");
+        class_results["AVX_Q88_Softmax_Latency"]= analyze_timings(softmax_q8_8_latency, "AVX Q(8.8) Softmax Inference");
+        class_results["AVX_FP32_Binary_SGD_Latency"]= analyze_timings(binary_sgd_latency, "AVX FP32 K x Binary SGD");
+        class_results["AVX_FP32_Softmax_SGD_Latency"]= analyze_timings(softmax_sgd_latency, "AVX FP32 Softmax SGD");
+        class_results["AVX_FP32_Softmax_Speedup"]= analyze_p95_speedup(softmax_latency, binary_latency, "AVX FP32 Softmax vs K x Binary");
+        class_results["AVX_Q88_Softmax_Speedup"]= analyze_p95_speedup(softmax_q8_8_latency, binary_q8_8_latency, "AVX Q(8.8) Softmax vs K x Binary");
+        class_results["AVX_FP32_Softmax_SGD_Speedup"]= analyze_p95_speedup(softmax_sgd_latency, binary_sgd_latency, "AVX FP32 Softmax SGD vs K x Binary");
+        benchmark_results[std::to_string(num_classes)]= class_results;
+    }
+    std::cout << "Accumulation (to avoid optimization): " << accumulation << std::endl;
+
+    return benchmark_results;
+}
+
+json benchmark_predict_and_learn(size_t feature_size, int iterations, int reps){
+    constexpr size_t pool_size= 64;
+
+    SGDLogisticRegression sequence_model(feature_size);
+    SGDLogisticRegression fused_model(feature_size);
+    std::vector<alignedArray<float>> inputs;
+    std::array<float, pool_size> labels{};
+    for (size_t n= 0; n < pool_size; n++){
+        inputs.emplace_back(feature_size);
+    }
+
+    std::random_device rd;
+    std::mt19937 mt(rd());
+    std::uniform_real_distribution<float> dist(-1, 1);
+
+    std::vector<double> sequence_latency{};
+    std::vector<double> fused_latency{};
+    sequence_latency.reserve(iterations);
+    fused_latency.reserve(iterations);
+
+    volatile float accumulation= 0.0f;
+
+    for (int iter= 0; iter < iterations; iter++){
+        for (size_t n= 0; n < pool_size; n++){
+            for (size_t j= 0; j < feature_size; j++){
+                inputs[n][j]= dist(mt);
+            }
+            labels[n]= dist(mt) > 0.0f;
+        }
+
+        //each event is a fresh row, the sequence model copies it into its inputs first
+        auto start= benchClock::now();
+        float sequence_result= 0.0f;
+        for (int r= 0; r < reps; r++){
+            for (size_t n= 0; n < pool_size; n++){
+                sequence_model.setInputs(inputs[n].data());
+                float prediction= sequence_model.inference_q8_8_to_fp(inputs[n]);
+                sequence_model.update_weights(prediction, labels[n]);
+                sequence_result+= prediction;
+            }
+        }
+        auto end= benchClock::now();
+        sequence_latency.push_back(benchClock::elapsed(start, end)/ (reps* pool_size));
+        accumulation= accumulation + sequence_result;
+
+        start= benchClock::now();
+        float fused_result= 0.0f;
+        for (int r= 0; r < reps; r++){
+            for (size_t n= 0; n < pool_size; n++){
+                fused_result+= fused_model.predict_and_learn(inputs[n], labels[n]);
+            }
+        }
+        end= benchClock::now();
+        fused_latency.push_back(benchClock::elapsed(start, end)/ (reps* pool_size));
+        accumulation= accumulation + fused_result;
+    }
+
+    json benchmark_results;
+    benchmark_results["Sequence_Latency"]= analyze_timings(sequence_latency, "setInputs + inference_q8_8_to_fp + update_weights (per event)");
+    benchmark_results["Fused_Latency"]= analyze_timings(fused_latency, "predict_and_learn (per event)");
+    benchmark_results["Fused_Sequence_Speedup"]= analyze_p95_speedup(fused_latency, sequence_latency, "predict_and_learn vs 3-call sequence");
+    std::cout << "Accumulation (to avoid optimization): " << accumulation << std::endl;
+
+    return benchmark_results;
+}
+
+//sgd_inplace + quantize8_8_inplace vs the fused kernel (dispatched), on dense inputs and on inputs where
+//only one 16-feature block in eight is non-zero (e.g. one-hot groups laid out densely)
+//Fused_Mismatches counts FP32 or Q8.8 weights where the two differ, expected 0
+json benchmark_sgd_requantize(size_t feature_size, int iterations, int reps){
+    const KernelTable& isa_kernels= kernels();
+
+    alignedArray<float> weights(feature_size);
+    alignedArray<int16_t> weights_q8_8(feature_size);
+    alignedArray<float> separate_weights(feature_size);
+    alignedArray<int16_t> separate_q8_8(feature_size);
+    alignedArray<float> dense_inputs(feature_size);
+    alignedArray<float> partial_inputs(feature_size);
+
+    std::random_device rd;
+    std::mt19937 mt(rd());
+    std::uniform_real_distribution<float> dist(-1, 1);
+
+    std::vector<double> dense_separate_latency{};
+    std::vector<double> dense_fused_latency{};
+    std::vector<double> partial_separate_latency{};
+    std::vector<double> partial_fused_latency{};
+    size_t q8_8_mismatches= 0;
+
+    auto timeUpdate= [&](float* x, std::vector<double>& separate_latency, std::vector<double>& fused_latency){
+        int16_t y_hat= float_to_q8_8(dist(mt));
+        float y= dist(mt) > 0.0f;
+
+        auto start= benchClock::now();
+        for (int r= 0; r < reps; r++){
+            isa_kernels.sgd_inplace(y_hat, y, separate_weights.data(), x, feature_size, 1e-6);
+            isa_kernels.quantize8_8_inplace(separate_weights.data(), separate_q8_8.data(), feature_size);
+        }
+        auto end= benchClock::now();
+        separate_latency.push_back(benchClock::elapsed(start, end)/ reps);
+
+        start= benchClock::now();
+        for (int r= 0; r < reps; r++){
+            isa_kernels.sgd_q8_8_inplace(y_hat, y, weights.data(), weights_q8_8.data(), x, feature_size, 1e-6);
+        }
+        end= benchClock::now();
+        fused_latency.push_back(benchClock::elapsed(start, end)/ reps);
+
+        for (size_t j= 0; j < feature_size; j++){
+            q8_8_mismatches+= weights[j] != separate_weights[j] || weights_q8_8[j] != separate_q8_8[j];
+        }
+    };
+
+    for (int iter= 0; iter < iterations; iter++){
+        for (size_t j= 0; j < feature_size; j++){
+            weights[j]= dist(mt);
+            dense_inputs[j]= dist(mt);
+            partial_inputs[j]= ((j/ 16) % 8 == 0)? dist(mt): 0.0f;
+        }
+        isa_kernels.quantize8_8_inplace(weights.data(), weights_q8_8.data(), feature_size);
+        std::memcpy(separate_weights.data(), weights.data(), feature_size* sizeof(float));
+        std::memcpy(separate_q8_8.data(), weights_q8_8.data(), feature_size* sizeof(int16_t));
+
+        timeUpdate(dense_inputs.data(), dense_separate_latency, dense_fused_latency);
+        timeUpdate(partial_inputs.data(), partial_separate_latency, partial_fused_latency);
+    }
+
+    json benchmark_results;
+    benchmark_results["Dense_Separate_Latency"]= analyze_timings(dense_separate_latency, "sgd_inplace + quantize8_8_inplace");
+    benchmark_results["Dense_Fused_Latency"]= analyze_timings(dense_fused_latency, "sgd_q8_8_inplace");
+    benchmark_results["Dense_Fused_Speedup"]= analyze_p95_speedup(dense_fused_latency, dense_separate_latency, "Fused vs Separate, dense inputs");
+    benchmark_results["Partial_Separate_Latency"]= analyze_timings(partial_separate_latency, "sgd_inplace + quantize8_8_inplace, 1/8 of the blocks non-zero");
+    benchmark_results["Partial_Fused_Latency"]= analyze_timings(partial_fused_latency, "sgd_q8_8_inplace, 1/8 of the blocks non-zero");
+    benchmark_results["Partial_Fused_Speedup"]= analyze_p95_speedup(partial_fused_latency, partial_separate_latency, "Fused vs Separate, partial inputs");
+    benchmark_results["Fused_Mismatches"]= q8_8_mismatches;
+
+    return benchmark_results;
+}
+
+//Errors are against an exact int64 reference, the adversarial cases hit every lane with the largest |w·x|
+json benchmark_q8_8_wide(size_t feature_size, int iterations, int reps){
+    const KernelTable& isa_kernels= kernels();
+
+    alignedArray<int16_t> w_q8_8(feature_size);
+    alignedArray<int16_t> x_q8_8(feature_size);
+
+    std::random_device rd;
+    std::mt19937 mt(rd());
+    std::uniform_int_distribution<int> full_range(INT16_MIN, INT16_MAX);
+    std::uniform_real_distribution<float> dist(-1, 1);
+
+    auto reference= [&](){
+        int64_t sum= 0;
+        for (size_t j= 0; j < feature_size; j++){
+            sum+= int32_t(w_q8_8[j])* x_q8_8[j];
+        }
+        return sum;
+    };
+
+    json adversarial;
+    size_t narrow_errors= 0;
+    size_t wide_errors= 0;
+    auto check= [&](const char* name, auto w, auto x){
+        for (size_t j= 0; j < feature_size; j++){
+            w_q8_8[j]= w(j);
+            x_q8_8[j]= x(j);
+        }
+        int64_t expected= reference();
+        int64_t wide= isa_kernels.dotproduct_q8_8_wide(w_q8_8.data(), x_q8_8.data(), feature_size);
+        int32_t narrow= isa_kernels.dotproduct_q8_8(w_q8_8.data(), x_q8_8.data(), feature_size);
+        narrow_errors+= narrow != expected;
+        wide_errors+= wide != expected;
+        adversarial[name]= {{"Expected", expected}, {"Narrow", narrow}, {"Wide", wide}};
+    };
+    check("Min_x_Min", [](size_t){ return INT16_MIN; }, [](size_t){ return INT16_MIN; });
+    check("Max_x_Max", [](size_t){ return INT16_MAX; }, [](size_t){ return INT16_MAX; });
+    check("Min_x_Max", [](size_t){ return INT16_MIN; }, [](size_t){ return INT16_MAX; });
+    check("Alternating", [](size_t j){ return (j/ 2) % 2? INT16_MIN: INT16_MAX; }, [](size_t){ return INT16_MIN; });
+    check("Random_Full_Range", [&](size_t){ return full_range(mt); }, [&](size_t){ return full_range(mt); });
+
+    std::vector<double> narrow_latency{};
+    std::vector<double> wide_latency{};
+    volatile int64_t sink= 0;
+
+    for (int iter= 0; iter < iterations; iter++){
+        for (size_t j= 0; j < feature_size; j++){
+            w_q8_8[j]= float_to_q8_8(dist(mt));
+            x_q8_8[j]= float_to_q8_8(dist(mt));
+        }
+        int64_t expected= reference();
+        wide_errors+= isa_kernels.dotproduct_q8_8_wide(w_q8_8.data(), x_q8_8.data(), feature_size) != expected;
+
+        auto start= benchClock::now();
+        for (int r= 0; r < reps; r++){
+            sink= sink + isa_kernels.dotproduct_q8_8(w_q8_8.data(), x_q8_8.data(), feature_size);
+        }
+        auto end= benchClock::now();
+        narrow_latency.push_back(benchClock::elapsed(start, end)/ reps);
+
+        start= benchClock::now();
+        for (int r= 0; r < reps; r++){
+            sink= sink + isa_kernels.dotproduct_q8_8_wide(w_q8_8.data(), x_q8_8.data(), feature_size);
+        }
+        end= benchClock::now();
+        wide_latency.push_back(benchClock::elapsed(start, end)/ reps);
+    }
+
+    json benchmark_results;
+    benchmark_results["Narrow_Latency"]= analyze_timings(narrow_latency, "dotproduct_q8_8");
+    benchmark_results["Wide_Latency"]= analyze_timings(wide_latency, "dotproduct_q8_8_wide");
+    benchmark_results["Wide_vs_Narrow"]= analyze_p95_speedup(wide_latency, narrow_latency, "Wide vs Narrow");
+    benchmark_results["Adversarial"]= adversarial;
+    benchmark_results["Narrow_Errors"]= narrow_errors;
+    benchmark_results["Wide_Errors"]= wide_errors;
+
+    return benchmark_results;
+}
+
+//reps is the number of epochs per train() call, throughput counts every sample of every epoch
+json benchmark_hogwild(size_t feature_size, int iterations, int reps){
+    constexpr std::array<size_t, 6> thread_counts{1, 2, 4, 8, 16, 32};
+    constexpr size_t merge_interval= 64;
+    const size_t max_threads= std::max<size_t>(1, std::thread::hardware_concurrency());
+    const size_t sample_count= std::max<size_t>(256, (size_t(1) << 22)/ feature_size);
+
+    std::random_device rd;
+    std::mt19937 mt(rd());
+    std::uniform_real_distribution<float> dist(-1, 1);
+
+    //labels come from a hidden linear model so accuracy shows whether racing updates still converge
+    HogwildTrainer layout(feature_size, 1);
+    const size_t stride= layout.rowStride();
+    alignedArray<float> samples(64, sample_count* stride);
+    alignedArray<float> labels(sample_count);
+    alignedArray<float> truth(feature_size);
+    alignedArray<float> row(64, stride);
+    for (size_t j= 0; j < feature_size; j++){
+        truth[j]= dist(mt);
+    }
+    for (size_t n= 0; n < sample_count; n++){
+        float logit= 0.0f;
+        for (size_t j= 0; j < stride; j++){
+            float x= (j < feature_size)? dist(mt): 0.0f;
+            samples[n* stride + j]= x;
+            logit+= (j < feature_size)? x* truth[j]: 0.0f;
+        }
+        labels[n]= logit > 0.0f;
+    }
+
+    json benchmark_results;
+    benchmark_results["Samples"]= sample_count;
+    benchmark_results["Hardware_Threads"]= max_threads;
+
+    std::vector<double> single_thread_latency{};
+    for (size_t threads: thread_counts){
+        if (threads > 1 && threads > max_threads){
+            break;
+        }
+
+        json thread_results;
+        for (size_t interval: {size_t(0), merge_interval}){
+            std::vector<double> per_sample_latency{};
+            per_sample_latency.reserve(iterations);
+            double accuracy= 0.0;
+
+            for (int iter= 0; iter < iterations; iter++){
+                HogwildTrainer trainer(feature_size, threads, 0.01f, interval);
+
+                auto start= benchClock::now();
+                trainer.train(samples, labels.data(), sample_count, reps);
+                auto end= benchClock::now();
+                per_sample_latency.push_back(benchClock::elapsed(start, end)/ (sample_count* reps));
+
+                size_t correct= 0;
+                for (size_t n= 0; n < sample_count; n++){
+                    std::memcpy(row.data(), &samples[n* stride], stride* sizeof(float));
+                    correct+= (trainer.inference_fp(row) > 0.5f) == (labels[n] > 0.5f);
+                }
+                accuracy+= static_cast<double>(correct)/ sample_count;
+            }
+
+            std::string mode= (interval == 0)? "Hogwild": "Buffered";
+            json mode_results;
+            mode_results["Latency"]= analyze_timings(per_sample_latency, mode + " SGD (per sample)");
+            mode_results["Samples_Per_Sec"]= 1.0/ benchClock::toSeconds(per_sample_latency[per_sample_latency.size()/ 2]);
+            mode_results["Train_Accuracy"]= accuracy/ iterations;
+            if (interval == 0 && threads == 1){
+                single_thread_latency= per_sample_latency;
+            }
+            if (interval == 0){
+                mode_results["Scaling"]= analyze_p95_speedup(per_sample_latency, single_thread_latency, std::to_string(threads) + " threads vs 1");
+            }
+            else{
+                mode_results["Merge_Interval"]= interval;
+            }
+            thread_results[mode]= mode_results;
+        }
+        benchmark_results[std::to_string(threads)]= thread_results;
+    }
+
+    return benchmark_results;
+}
+
+json benchmark_sharded_inference(size_t feature_size, int iterations, int reps){
+    constexpr std::array<size_t, 5> thread_counts{2, 4, 8, 16, 32};
+    const KernelTable& isa_kernels= kernels();
+    const size_t max_threads= std::max<size_t>(2, std::thread::hardware_concurrency());
+
+    alignedArray<float> weights(64, feature_size);
+    alignedArray<int16_t> weights_q8_8(64, feature_size);
+    alignedArray<float> inputs(64, feature_size);
+    alignedArray<int16_t> inputs_q8_8(64, feature_size);
+
+    std::random_device rd;
+    std::mt19937 mt(rd());
+    std::uniform_real_distribution<float> dist(-1, 1);
+
+    for (size_t j= 0; j < feature_size; j++){
+        weights[j]= dist(mt);
+    }
+    isa_kernels.quantize8_8_inplace(weights.data(), weights_q8_8.data(), feature_size);
+
+    volatile float accumulation= 0.0f;
+    std::vector<double> single_fp_latency{};
+    std::vector<double> single_q8_8_latency{};
+    single_fp_latency.reserve(iterations);
+    single_q8_8_latency.reserve(iterations);
+
+    //single-thread reference is the plain kernel pair on contiguous arrays, including input quantization like the model does
+    for (int iter= 0; iter < iterations; iter++){
+        for (size_t j= 0; j < feature_size; j++){
+            inputs[j]= dist(mt);
+        }
+
+        auto start= benchClock::now();
+        float result_fp= 0.0f;
+        for (int r= 0; r < reps; r++){
+            result_fp+= q8_8_to_float(sigmoid_fp_to_q8_8(isa_kernels.dotproduct_fp(weights.data(), inputs.data(), feature_size)));
+        }
+        auto end= benchClock::now();
+        single_fp_latency.push_back(benchClock::elapsed(start, end)/ reps);
+
+        start= benchClock::now();
+        float result_q8_8= 0.0f;
+        for (int r= 0; r < reps; r++){
+            isa_kernels.quantize8_8_inplace(inputs.data(), inputs_q8_8.data(), feature_size);
+            result_q8_8+= q8_8_to_float(sigmoidApprox_q16_16_to_q8_8(isa_kernels.dotproduct_q8_8(weights_q8_8.data(), inputs_q8_8.data(), feature_size)));
+        }
+        end= benchClock::now();
+        single_q8_8_latency.push_back(benchClock::elapsed(start, end)/ reps);
+        accumulation= accumulation + result_fp + result_q8_8;
+    }
+
+    json benchmark_results;
+    benchmark_results["Single_FP32_Latency"]= analyze_timings(single_fp_latency, "Single-thread FP32 Inference");
+    benchmark_results["Single_Q88_Latency"]= analyze_timings(single_q8_8_latency, "Single-thread Q(8.8) Inference");
+
+    for (size_t threads: thread_counts){
+        if (threads > max_threads){
+            break;
+        }
+
+        ShardedInference model(feature_size, threads);
+        model.setWeights(weights.data());
+        model.setSharded(true);
+
+        std::vector<double> sharded_fp_latency{};
+        std::vector<double> sharded_q8_8_latency{};
+        std::vector<double> errors_fp{};
+        std::vector<double> errors_q8_8{};
+        sharded_fp_latency.reserve(iterations);
+        sharded_q8_8_latency.reserve(iterations);
+        errors_fp.reserve(iterations);
+        errors_q8_8.reserve(iterations);
+
+        for (int iter= 0; iter < iterations; iter++){
+            for (size_t j= 0; j < feature_size; j++){
+                inputs[j]= dist(mt);
+            }
+
+            auto start= benchClock::now();
+            float result_fp= 0.0f;
+            for (int r= 0; r < reps; r++){
+                result_fp+= model.inference_fp(inputs);
+            }
+            auto end= benchClock::now();
+            sharded_fp_latency.push_back(benchClock::elapsed(start, end)/ reps);
+
+            start= benchClock::now();
+            float result_q8_8= 0.0f;
+            for (int r= 0; r < reps; r++){
+                result_q8_8+= model.inference_q8_8_to_fp(inputs);
+            }
+            end= benchClock::now();
+            sharded_q8_8_latency.push_back(benchClock::elapsed(start, end)/ reps);
+            accumulation= accumulation + result_fp + result_q8_8;
+
+            float single_fp= q8_8_to_float(sigmoid_fp_to_q8_8(isa_kernels.dotproduct_fp(weights.data(), inputs.data(), feature_size)));
+            isa_kernels.quantize8_8_inplace(inputs.data(), inputs_q8_8.data(), feature_size);
+            float single_q8_8= q8_8_to_float(sigmoidApprox_q16_16_to_q8_8(isa_kernels.dotproduct_q8_8(weights_q8_8.data(), inputs_q8_8.data(), feature_size)));
+            errors_fp.push_back(std::fabs(model.inference_fp(inputs) - single_fp));
+            errors_q8_8.push_back(std::fabs(model.inference_q8_8_to_fp(inputs) - single_q8_8));
+        }
+
+        json thread_results;
+        thread_results["Sharded_FP32_Latency"]= analyze_timings(sharded_fp_latency, "Sharded FP32 Inference");
+        thread_results["Sharded_Q88_Latency"]= analyze_timings(sharded_q8_8_latency, "Sharded Q(8.8) Inference");
+        thread_results["Sharded_FP32_Speedup"]= analyze_p95_speedup(sharded_fp_latency, single_fp_latency, "Sharded FP32 vs Single-thread");
+        thread_results["Sharded_Q88_Speedup"]= analyze_p95_speedup(sharded_q8_8_latency, single_q8_8_latency, "Sharded Q(8.8) vs Single-thread");
+        thread_results["Sharded_FP32_Error"]= analyze_errors(errors_fp, "Sharded FP32 vs Single-thread");
+        thread_results["Sharded_Q88_Error"]= analyze_errors(errors_q8_8, "Sharded Q(8.8) vs Single-thread");
+        //latencies are sorted by analyze_timings above
+        thread_results["Sharded_FP32_Faster"]= sharded_fp_latency[iterations* 95/ 100] < single_fp_latency[iterations* 95/ 100];
+        thread_results["Sharded_Q88_Faster"]= sharded_q8_8_latency[iterations* 95/ 100] < single_q8_8_latency[iterations* 95/ 100];
+        benchmark_results[std::to_string(threads)]= thread_results;
+    }
+    std::cout << "Accumulation (to avoid optimization): " << accumulation << std::endl;
+
+    return benchmark_results;
+}
+
+//Smallest benchmarked feature size from which sharding stays faster at p95, per thread count and format
+json sharded_crossover(json& data, const std::vector<std::string>& feature_sizes){
+    json crossover;
+    for (const std::string format: {"FP32", "Q88"}){
+        for (const std::string threads: {"2", "4", "8", "16", "32"}){
+            json point= nullptr;
+            for (auto size= feature_sizes.rbegin(); size != feature_sizes.rend(); size++){
+                json& result= data[*size];
+                if (!result.contains(threads) || !result[threads]["Sharded_" + format + "_Faster"].get<bool>()){
+                    break;
+                }
+                point= std::stoul(*size);
+            }
+            if (data[feature_sizes.front()].contains(threads)){
+                crossover[format][threads]= point;
+            }
+        }
+    }
+    return crossover;
+}
+
+//Time from "file on disk" to first prediction: mmap + header check vs reading the weights into a fresh heap model
+json benchmark_model_load(size_t feature_size, int iterations){
+    const std::string path= (std::filesystem::temp_directory_path()/ ("avx_lr_load_" + std::to_string(feature_size) + ".bin")).string();
+    SGDLogisticRegression source(feature_size);
+    source.save(path);
+
+    alignedArray<float> inputs(feature_size);
+    std::random_device rd;
+    std::mt19937 mt(rd());
+    std::uniform_real_distribution<float> dist(-1, 1);
+    for (size_t j= 0; j < feature_size; j++){
+        inputs[j]= dist(mt);
+    }
+
+    std::vector<double> mapped_latency{};
+    std::vector<double> copied_latency{};
+    std::vector<double> errors{};
+    mapped_latency.reserve(iterations);
+    copied_latency.reserve(iterations);
+    errors.reserve(iterations);
+    volatile float accumulation= 0.0f;
+
+    for (int iter= 0; iter < iterations; iter++){
+        auto start= benchClock::now();
+        SGDLogisticRegression mapped(std::make_shared<modelMapping>(path));
+        float mapped_result= mapped.inference_q8_8_to_fp(inputs);
+        auto end= benchClock::now();
+        mapped_latency.push_back(benchClock::elapsed(start, end));
+
+        start= benchClock::now();
+        modelHeader header;
+        alignedArray<float> weights(feature_size);
+        std::ifstream file(path, std::ios::binary);
+        file.read(reinterpret_cast<char*>(&header), sizeof(modelHeader));
+        file.read(reinterpret_cast<char*>(weights.data()), header.fp32_bytes);
+        SGDLogisticRegression copied(feature_size, header.learning_rate, header.threshold);
+        copied.setWeights(weights.data());
+        float copied_result= copied.inference_q8_8_to_fp(inputs);
+        end= benchClock::now();
+        copied_latency.push_back(benchClock::elapsed(start, end));
+
+        accumulation= accumulation + mapped_result + copied_result;
+        errors.push_back(std::fabs(mapped_result - copied_result));
+    }
+    std::filesystem::remove(path);
+
+    json benchmark_results;
+    benchmark_results["Mapped_Load_Latency"]= analyze_timings(mapped_latency, "mmap load + first Q(8.8) inference");
+    benchmark_results["Copied_Load_Latency"]= analyze_timings(copied_latency, "read + setWeights + first Q(8.8) inference");
+    benchmark_results["Mapped_Copied_Speedup"]= analyze_p95_speedup(mapped_latency, copied_latency, "mmap vs copy load");
+    benchmark_results["Mapped_Copied_Error"]= analyze_errors(errors, "mmap vs copy load");
+    std::cout << "Accumulation (to avoid optimization): " << accumulation << std::endl;
+
+    return benchmark_results;
+}
+
+//Parse throughput per thread count, then reader + online SGD against SGD over the same rows already in memory
+json benchmark_dataset_reader(size_t feature_size, int iterations, size_t rows){
+    constexpr std::array<size_t, 6> thread_counts{1, 2, 4, 8, 16, 32};
+    const size_t nnz= feature_size/ 8;
+    const KernelTable& isa_kernels= kernels();
+    const size_t max_threads= std::max<size_t>(2, std::thread::hardware_concurrency());
+
+    std::random_device rd;
+    std::mt19937 mt(rd());
+    std::uniform_real_distribution<float> dist(-1, 1);
+    std::uniform_int_distribution<size_t> feature(1, feature_size);
+
+    const std::filesystem::path directory= std::filesystem::temp_directory_path();
+    const std::string csv_path= (directory/ ("avx_lr_reader_" + std::to_string(feature_size) + ".csv")).string();
+    const std::string libsvm_path= (directory/ ("avx_lr_reader_" + std::to_string(feature_size) + ".svm")).string();
+    {
+        std::ofstream csv(csv_path);
+        std::ofstream libsvm(libsvm_path);
+        csv << "label";
+        for (size_t j= 0; j < feature_size; j++){
+            csv << ",x" << j;
+        }
+        csv << "\n";
+        for (size_t n= 0; n < rows; n++){
+            int label= dist(mt) > 0.0f;
+            csv << label;
+            for (size_t j= 0; j < feature_size; j++){
+                csv << "," << dist(mt);
+            }
+            csv << "\n";
+
+            libsvm << (label? "+1": "-1");
+            std::vector<size_t> indices(nnz);
+            for (size_t& index: indices){
+                index= feature(mt);
+            }
+            std::sort(indices.begin(), indices.end());
+            indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+            for (size_t index: indices){
+                libsvm << " " << index << ":" << dist(mt);
+            }
+            libsvm << "\n";
+        }
+    }
+
+    json benchmark_results;
+    volatile float accumulation= 0.0f;
+
+    for (auto [format, path, name]: {std::tuple{DatasetFormat::CSV, csv_path, std::string("CSV")}, std::tuple{DatasetFormat::LibSVM, libsvm_path, std::string("LibSVM")}}){
+        const double megabytes= std::filesystem::file_size(path)/ 1e6;
+        json format_results;
+        format_results["File_MB"]= megabytes;
+
+        for (size_t threads: thread_counts){
+            if (threads > max_threads){
+                break;
+            }
+            std::vector<double> per_row_latency{};
+            per_row_latency.reserve(iterations);
+            size_t parsed= 0;
+            for (int iter= 0; iter < iterations; iter++){
+                auto start= benchClock::now();
+                DatasetReader reader(path, format, feature_size, threads);
+                parsed= 0;
+                while (const datasetBatch* batch= reader.next()){
+                    parsed+= batch->rows;
+                    accumulation= accumulation + batch->labels[0];
+                }
+                auto end= benchClock::now();
+                per_row_latency.push_back(benchClock::elapsed(start, end)/ parsed);
+            }
+
+            json thread_results= analyze_timings(per_row_latency, name + " parse (per row)");
+            thread_results["Rows"]= parsed;
+            thread_results["MB_Per_Sec"]= megabytes/ benchClock::toSeconds(per_row_latency[per_row_latency.size()/ 2]* parsed);
+            format_results["Parse_" + std::to_string(threads)]= thread_results;
+        }
+
+        //end to end with every available parser thread: does SGD wait on the parser?
+        std::vector<double> streamed_latency{};
+        std::vector<double> in_memory_latency{};
+        for (int iter= 0; iter < iterations; iter++){
+            alignedArray<float> weights(feature_size);
+            std::memset(weights.data(), 0, feature_size* sizeof(float));
+            std::vector<alignedArray<float>> chunks;
+            std::vector<alignedArray<float>> chunk_labels;
+            std::vector<size_t> chunk_rows;
+            size_t stride= 0;
+
+            auto start= benchClock::now();
+            {
+                DatasetReader reader(path, format, feature_size, std::min(max_threads, thread_counts.back()));
+                stride= reader.rowStride();
+                while (const datasetBatch* batch= reader.next()){
+                    for (size_t n= 0; n < batch->rows; n++){
+                        float* x= batch->inputs.data() + n* stride;
+                        int16_t y_hat= sigmoid_fp_to_q8_8(isa_kernels.dotproduct_fp(weights.data(), x, feature_size));
+                        isa_kernels.sgd_inplace(y_hat, batch->labels[n], weights.data(), x, feature_size, 0.01f);
+                    }
+                    chunks.push_back(batch->inputs.deepCopy());
+                    chunk_labels.push_back(batch->labels.deepCopy());
+                    chunk_rows.push_back(batch->rows);
+                }
+            }
+            auto end= benchClock::now();
+            streamed_latency.push_back(benchClock::elapsed(start, end)/ rows);
+
+            start= benchClock::now();
+            for (size_t c= 0; c < chunks.size(); c++){
+                for (size_t n= 0; n < chunk_rows[c]; n++){
+                    float* x= &chunks[c][n* stride];
+                    int16_t y_hat= sigmoid_fp_to_q8_8(isa_kernels.dotproduct_fp(weights.data(), x, feature_size));
+                    isa_kernels.sgd_inplace(y_hat, chunk_labels[c][n], weights.data(), x, feature_size, 0.01f);
+                }
+            }
+            end= benchClock::now();
+            in_memory_latency.push_back(benchClock::elapsed(start, end)/ rows);
+            accumulation= accumulation + weights[0];
+        }
+        format_results["Streamed_SGD_Latency"]= analyze_timings(streamed_latency, name + " reader + SGD (per row, includes copying each chunk aside)");
+        format_results["In_Memory_SGD_Latency"]= analyze_timings(in_memory_latency, "SGD over pre-parsed rows (per row)");
+        format_results["Streamed_In_Memory_Speedup"]= analyze_p95_speedup(streamed_latency, in_memory_latency, name + " streamed vs in-memory");
+        benchmark_results[name]= format_results;
+    }
+
+    std::filesystem::remove(csv_path);
+    std::filesystem::remove(libsvm_path);
+    std::cout << "Accumulation (to avoid optimization): " << accumulation << std::endl;
+
+    return benchmark_results;
+}
+
+//Reader latency while one thread trains on the same model: no writer, snapshot publishing, and a mutex around the model
+json benchmark_snapshot(size_t feature_size, int iterations, int publish_interval){
+    const size_t num_readers= std::clamp<size_t>(std::thread::hardware_concurrency(), 2, 5) - 1;
+
+    std::random_device rd;
+    std::mt19937 mt(rd());
+    std::uniform_real_distribution<float> dist(-1, 1);
+
+    std::vector<alignedArray<float>> reader_inputs;
+    for (size_t r= 0; r < num_readers; r++){
+        reader_inputs.emplace_back(feature_size);
+        for (size_t j= 0; j < feature_size; j++){
+            reader_inputs[r][j]= dist(mt);
+        }
+    }
+    alignedArray<float> writer_inputs(feature_size);
+    for (size_t j= 0; j < feature_size; j++){
+        writer_inputs[j]= dist(mt);
+    }
+
+    SnapshotModel snapshot_model(feature_size, num_readers);
+    SGDLogisticRegression locked_model(feature_size);
+    std::mutex model_mutex;
+
+    json benchmark_results;
+    benchmark_results["Readers"]= num_readers;
+    volatile float accumulation= 0.0f;
+
+    for (std::string scenario: {"Idle", "Snapshot", "Mutex"}){
+        std::vector<std::vector<double>> latencies(num_readers);
+        std::atomic<bool> start_flag{false};
+        std::atomic<size_t> readers_done{0};
+        size_t updates= 0;
+        size_t failed_publishes= 0;
+
+        std::vector<std::thread> readers;
+        for (size_t r= 0; r < num_readers; r++){
+            readers.emplace_back([&, r]{
+                latencies[r].reserve(iterations);
+                while (!start_flag.load(std::memory_order_acquire)){}
+                float result= 0.0f;
+                for (int iter= 0; iter < iterations; iter++){
+                    auto start= benchClock::now();
+                    if (scenario == "Mutex"){
+                        std::lock_guard<std::mutex> lock(model_mutex);
+                        result+= locked_model.inference_q8_8_to_fp(reader_inputs[r]);
+                    }
+                    else{
+                        result+= snapshot_model.inference_q8_8_to_fp(r, reader_inputs[r]);
+                    }
+                    auto end= benchClock::now();
+                    latencies[r].push_back(benchClock::elapsed(start, end));
+                }
+                accumulation= accumulation + result;
+                readers_done.fetch_add(1, std::memory_order_release);
+            });
+        }
+
+        auto start= benchClock::now();
+        start_flag.store(true, std::memory_order_release);
+        while (readers_done.load(std::memory_order_acquire) < num_readers){
+            if (scenario == "Snapshot"){
+                snapshot_model.trainer().predict_and_learn(writer_inputs, updates & 1);
+                if (++updates % publish_interval == 0 && !snapshot_model.publish()){
+                    failed_publishes++;
+                }
+            }
+            else if (scenario == "Mutex"){
+                std::lock_guard<std::mutex> lock(model_mutex);
+                locked_model.predict_and_learn(writer_inputs, updates & 1);
+                updates++;
+            }
+        }
+        auto end= benchClock::now();
+        for (std::thread& reader: readers){
+            reader.join();
+        }
+
+        std::vector<double> all_latencies;
+        for (std::vector<double>& reader_latencies: latencies){
+            all_latencies.insert(all_latencies.end(), reader_latencies.begin(), reader_latencies.end());
+        }
+        json scenario_results= analyze_timings(all_latencies, scenario + " reader Q(8.8) inference");
+        scenario_results["Writer_Updates_Per_Sec"]= updates/ benchClock::toSeconds(benchClock::elapsed(start, end));
+        if (scenario == "Snapshot"){
+            scenario_results["Publish_Interval"]= publish_interval;
+            scenario_results["Failed_Publishes"]= failed_publishes;
+            scenario_results["Published_Version"]= snapshot_model.version();
+        }
+        benchmark_results[scenario]= scenario_results;
+    }
+    std::cout << "Accumulation (to avoid optimization): " << accumulation << std::endl;
+
+    return benchmark_results;
+}
+
+//Queue-to-result latency of the event pipeline against scoring on the caller's thread. iterations events per mode with at
+//most window in flight: the driver (SPSC) or two producer threads (MPSC) submit while fewer are outstanding, the driver
+//drains results and times each one from the timestamp the event carried. Caller_Blocked is what a producer spends in
+//trySubmit, the time a market-data thread loses per event instead of the full inference
+json benchmark_pipeline(size_t feature_size, int iterations, int window){
+    constexpr size_t input_count= 64;
+    constexpr size_t label_delay= 64;
+    constexpr size_t num_producers= 2;
+    //last CPU of the process mask so the worker stays off the driver's core, unpinned when there is only one
+    const int allowed_cpus= allowedCPUCount();
+    const int worker_cpu= allowed_cpus > 1? allowed_cpus - 1: -1;
+
+    std::random_device rd;
+    std::mt19937 mt(rd());
+    std::uniform_real_distribution<float> dist(-1, 1);
+
+    std::vector<alignedArray<float>> inputs;
+    for (size_t i= 0; i < input_count; i++){
+        inputs.emplace_back(feature_size);
+        for (size_t j= 0; j < feature_size; j++){
+            inputs[i][j]= dist(mt);
+        }
+    }
+    SGDLogisticRegression reference(feature_size);
+    alignedArray<float> weights(feature_size);
+    std::memcpy(weights.data(), reference.weights(), feature_size* sizeof(float));
+    std::vector<float> expected(input_count);
+    for (size_t i= 0; i < input_count; i++){
+        expected[i]= reference.inference_q8_8_to_fp(inputs[i]);
+    }
+
+    volatile float accumulation= 0.0f;
+    json benchmark_results;
+    benchmark_results["Worker_CPU"]= worker_cpu >= 0? allowedCPU(worker_cpu): -1;
+    benchmark_results["Window"]= window;
+
+    std::vector<double> sync_latency;
+    sync_latency.reserve(iterations);
+    for (int iter= 0; iter < iterations; iter++){
+        auto start= benchClock::now();
+        float result= reference.inference_q8_8_to_fp(inputs[iter % input_count]);
+        auto end= benchClock::now();
+        sync_latency.push_back(benchClock::elapsed(start, end));
+        accumulation= accumulation + result;
+    }
+    benchmark_results["Sync"]= analyze_timings(sync_latency, "Q(8.8) inference on the caller's thread");
+
+    for (std::string scenario: {"SPSC", "SPSC_Learning", "MPSC"}){
+        const bool learning= scenario == "SPSC_Learning";
+        const bool mpsc= scenario == "MPSC";
+        InferencePipeline pipeline(feature_size, mpsc? PipelineMode::MPSC: PipelineMode::SPSC, 2* window, learning? 4* label_delay: 0, worker_cpu);
+        pipeline.model().setWeights(weights.data());
+        pipeline.start();
+
+        std::vector<double> latency;
+        std::vector<std::vector<double>> blocked(mpsc? num_producers: 1);
+        latency.reserve(iterations);
+        std::atomic<size_t> in_flight{0};
+        std::atomic<size_t> retries{0};
+        size_t mismatches= 0;
+
+        //claims a window slot (running wait() while the window is full), then submits event id
+        auto submit= [&](uint64_t id, std::vector<double>& caller_blocked, auto wait){
+            size_t outstanding= in_flight.load(std::memory_order_relaxed);
+            while (outstanding >= static_cast<size_t>(window) || !in_flight.compare_exchange_weak(outstanding, outstanding + 1, std::memory_order_relaxed)){
+                if (outstanding >= static_cast<size_t>(window)){
+                    wait();
+                    outstanding= in_flight.load(std::memory_order_relaxed);
+                }
+            }
+            uint64_t timestamp= benchClock::now();
+            while (!pipeline.trySubmit(id, inputs[id % input_count].data(), timestamp)){
+                retries.fetch_add(1, std::memory_order_relaxed);
+            }
+            caller_blocked.push_back(benchClock::elapsed(timestamp, benchClock::now()));
+            if (learning && id >= label_delay){
+                while (!pipeline.tryLabel(id - label_delay, (id - label_delay) & 1)){
+                    retries.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        };
+        auto drain= [&]{
+            pipelineResult result;
+            while (pipeline.tryResult(result)){
+                latency.push_back(benchClock::elapsed(result.timestamp, benchClock::now()));
+                mismatches+= !learning && result.probability != expected[result.id % input_count];
+                accumulation= accumulation + result.probability;
+                in_flight.fetch_sub(1, std::memory_order_relaxed);
+            }
+        };
+
+        auto start= benchClock::now();
+        if (mpsc){
+            std::vector<std::thread> producers;
+            for (size_t p= 0; p < num_producers; p++){
+                producers.emplace_back([&, p]{
+                    blocked[p].reserve(iterations/ num_producers + 1);
+                    for (size_t id= p; id < static_cast<size_t>(iterations); id+= num_producers){
+                        submit(id, blocked[p], []{ std::this_thread::yield(); });
+                    }
+                });
+            }
+            while (latency.size() < static_cast<size_t>(iterations)){
+                drain();
+                std::this_thread::yield();
+            }
+            for (std::thread& producer: producers){
+                producer.join();
+            }
+        }
+        else{
+            blocked[0].reserve(iterations);
+            for (int id= 0; id < iterations; id++){
+                submit(id, blocked[0], [&]{ drain(); std::this_thread::yield(); });
+                drain();
+            }
+            while (latency.size() < static_cast<size_t>(iterations)){
+                drain();
+                std::this_thread::yield();
+            }
+        }
+        auto end= benchClock::now();
+        pipeline.stop();
+
+        std::vector<double> all_blocked;
+        for (std::vector<double>& producer_blocked: blocked){
+            all_blocked.insert(all_blocked.end(), producer_blocked.begin(), producer_blocked.end());
+        }
+        json scenario_results;
+        scenario_results["Queue_To_Result"]= analyze_timings(latency, scenario + " queue-to-result");
+        scenario_results["Caller_Blocked"]= analyze_timings(all_blocked, scenario + " time in trySubmit");
+        scenario_results["Events_Per_Sec"]= iterations/ benchClock::toSeconds(benchClock::elapsed(start, end));
+        scenario_results["Submit_Retries"]= retries.load();
+        scenario_results["Output_Stalls"]= pipeline.outputStalls();
+        scenario_results["Worker_Pinned"]= pipeline.pinned();
+        scenario_results["Q88_Mismatches"]= mismatches;
+        if (learning){
+            scenario_results["Label_Delay"]= label_delay;
+            scenario_results["Learned"]= pipeline.learned();
+            scenario_results["Expired_Labels"]= pipeline.expiredLabels();
+        }
+        benchmark_results[scenario]= scenario_results;
+    }
+    std::cout << "Accumulation (to avoid optimization): " << accumulation << std::endl;
+
+    return benchmark_results;
+}
+
+//Load generator for the inference server: each client is a forked process holding up to window requests in flight
+//(closed loop), per-request round trips and the client's first/last timestamps land in a shared anonymous mapping
+json benchmark_server(size_t feature_size, int iterations, int window){
+    constexpr size_t input_count= 64;
+    constexpr size_t max_batch= 16;
+    //last CPU of the process mask so the worker stays off the driver's core, unpinned when there is only one
+    const int allowed_cpus= allowedCPUCount();
+    const int worker_cpu= allowed_cpus > 1? allowed_cpus - 1: -1;
+    const std::string socket_path= "/tmp/avx_lr_bench_" + std::to_string(getpid()) + ".sock";
+    const bool batched= kernels().isa >= ISA::AVX2;
+
+    std::random_device rd;
+    std::mt19937 mt(rd());
+    std::uniform_real_distribution<float> dist(-1, 1);
+
+    std::vector<alignedArray<float>> inputs;
+    for (size_t i= 0; i < input_count; i++){
+        inputs.emplace_back(feature_size);
+        for (size_t j= 0; j < feature_size; j++){
+            inputs[i][j]= dist(mt);
+        }
+    }
+    SGDLogisticRegression reference(feature_size);
+    alignedArray<float> weights(feature_size);
+    std::memcpy(weights.data(), reference.weights(), feature_size* sizeof(float));
+    std::vector<float> expected(input_count);
+    for (size_t i= 0; i < input_count; i++){
+        expected[i]= reference.inference_interp_q8_8_to_fp(inputs[i]);
+    }
+
+    volatile float accumulation= 0.0f;
+    json benchmark_results;
+    benchmark_results["Worker_CPU"]= worker_cpu >= 0? allowedCPU(worker_cpu): -1;
+    benchmark_results["Max_Batch"]= max_batch;
+    benchmark_results["Batched"]= batched;
+
+    std::vector<double> direct_latency;
+    direct_latency.reserve(iterations);
+    for (int iter= 0; iter < iterations; iter++){
+        auto start= benchClock::now();
+        float result= reference.inference_q8_8_to_fp(inputs[iter % input_count]);
+        auto end= benchClock::now();
+        direct_latency.push_back(benchClock::elapsed(start, end));
+        accumulation= accumulation + result;
+    }
+    benchmark_results["Direct"]= analyze_timings(direct_latency, "Q(8.8) inference in the caller's process");
+
+    struct serverScenario{
+        std::string name;
+        size_t clients;
+        size_t window;
+    };
+    struct clientRecord{
+        uint64_t start;
+        uint64_t end;
+        uint64_t mismatches;
+    };
+    const std::vector<serverScenario> scenarios{{"Clients_1_Window_1", 1, 1}, {"Clients_1", 1, static_cast<size_t>(window)},
+        {"Clients_4", 4, static_cast<size_t>(window)}};
+
+    for (const serverScenario& scenario: scenarios){
+        const size_t per_client= iterations/ scenario.clients;
+        const size_t shared_bytes= scenario.clients* (sizeof(clientRecord) + per_client* sizeof(double));
+        void* shared= mmap(nullptr, shared_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (shared == MAP_FAILED){
+            throw std::runtime_error("Cannot map the client results");
+        }
+        clientRecord* records= static_cast<clientRecord*>(shared);
+        double* round_trips= reinterpret_cast<double*>(records + scenario.clients);
+
+        InferenceServer server(socket_path, scenario.clients, 2* scenario.window, max_batch, worker_cpu);
+        server.model(server.addModel(feature_size)).setWeights(weights.data());
+
+        //clients fork before the server threads exist and retry until the socket is bound
+        std::vector<pid_t> children;
+        for (size_t c= 0; c < scenario.clients; c++){
+            pid_t child= fork();
+            if (child != 0){
+                children.push_back(child);
+                continue;
+            }
+            int status= 1;
+            try{
+                std::unique_ptr<InferenceClient> client;
+                for (int attempt= 0; !client; attempt++){
+                    try{
+                        client= std::make_unique<InferenceClient>(socket_path);
+                    }
+                    catch (const std::runtime_error&){
+                        if (attempt == 5000){
+                            throw;
+                        }
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    }
+                }
+
+                std::vector<uint64_t> submitted(per_client);
+                double* latency= round_trips + c* per_client;
+                clientRecord& record= records[c];
+                size_t sent= 0, done= 0, spins= 0;
+                record.start= benchClock::now();
+                while (done < per_client){
+                    while (sent < per_client && sent - done < scenario.window){
+                        uint64_t timestamp= benchClock::now();
+                        if (!client->trySubmit(0, inputs[(c* per_client + sent) % input_count].data(), sent)){
+                            break;
+                        }
+                        submitted[sent++]= timestamp;
+                    }
+                    inferenceResponse response;
+                    bool received= false;
+                    while (client->tryResult(response)){
+                        latency[response.request_id]= benchClock::elapsed(submitted[response.request_id], benchClock::now());
+                        record.mismatches+= response.status != ResponseStatus::Ok ||
+                            response.probability != expected[(c* per_client + response.request_id) % input_count];
+                        done++;
+                        received= true;
+                    }
+                    spins= received? 0: spins + 1;
+                    if (spins > 4096){
+                        std::this_thread::yield();
+                    }
+                    else if (spins){
+                        _mm_pause();
+                    }
+                }
+                record.end= benchClock::now();
+                status= 0;
+            }
+            catch (const std::exception&){
+            }
+            _exit(status);
+        }
+
+        server.start();
+        size_t failed_clients= 0;
+        for (pid_t child: children){
+            int status= 0;
+            waitpid(child, &status, 0);
+            failed_clients+= !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+        }
+        server.stop();
+
+        std::vector<double> latency(round_trips, round_trips + scenario.clients* per_client);
+        uint64_t first= UINT64_MAX, last= 0, mismatches= 0;
+        for (size_t c= 0; c < scenario.clients; c++){
+            first= std::min(first, records[c].start);
+            last= std::max(last, records[c].end);
+            mismatches+= records[c].mismatches;
+        }
+
+        json scenario_results;
+        scenario_results["Clients"]= scenario.clients;
+        scenario_results["Window"]= scenario.window;
+        scenario_results["Failed_Clients"]= failed_clients;
+        if (failed_clients == 0){
+            scenario_results["Round_Trip"]= analyze_timings(latency, scenario.name + " submit-to-response");
+            scenario_results["Requests_Per_Sec"]= latency.size()/ benchClock::toSeconds(benchClock::elapsed(first, last));
+        }
+        scenario_results["Served"]= server.served();
+        scenario_results["Batches"]= server.batches();
+        scenario_results["Worker_Pinned"]= server.pinned();
+        if (server.batches()){
+            scenario_results["Mean_Batch"]= static_cast<double>(server.served())/ server.batches();
+        }
+        scenario_results["Q88_Mismatches"]= mismatches;
+        munmap(shared, shared_bytes);
+        benchmark_results[scenario.name]= scenario_results;
+    }
+    std::cout << "Accumulation (to avoid optimization): " << accumulation << std::endl;
+
+    return benchmark_results;
+}
+
+//One measured case, reps is the benchmark's second argument (see --help)
+struct benchCase{
+    size_t size;
+    int iterations;
+    int reps;
+};
+
+struct benchEntry{
+    std::string name;
+    std::string output;
+    bool avx2_only;     //calls the AVX2 kernels directly, skipped below the AVX2 tier
+    bool multithreaded; //spawns its own threads, runs with the driver thread unpinned
+    std::vector<benchCase> defaults;
+    std::function<json(size_t size, int iterations, int reps)> run;
+    std::function<json(json& data, const std::vector<std::string>& sizes)> crossover= nullptr;
+};
+
+static std::vector<benchEntry> benchmarks(){
+    const std::vector<benchCase> powers_of_two{{16, 100000, 100}, {32, 100000, 100}, {64, 100000, 100}, {128, 100000, 100},
+        {256, 100000, 100}, {512, 100000, 100}, {1024, 100000, 100}, {2048, 100000, 100}, {4096, 100000, 100},
+        {8192, 100000, 100}, {16384, 100000, 100}, {32768, 100000, 100}};
+
+    return {
+        {"sgd", "SGD_Benchmark.json", false, false, powers_of_two, benchmark_sgd},
+        {"sgd_requantize", "SGD_Requantize_Benchmark.json", false, false,
+            {{512, 1000, 10}, {8192, 1000, 10}, {32768, 1000, 10}, {262144, 100, 10}}, benchmark_sgd_requantize},
+        {"q8_8_wide", "Q88_Wide_Benchmark.json", false, false,
+            {{4096, 10000, 100}, {65536, 1000, 10}, {262181, 100, 10}, {1048576, 100, 10}}, benchmark_q8_8_wide},
+        {"inference", "Inference_Benchmark.json", false, false, powers_of_two, benchmark_inference},
+        {"model_bank", "Model_Bank_Benchmark.json", false, false, {{64, 200, 10}, {256, 200, 10}, {512, 200, 10}}, benchmark_model_bank},
+        {"cold_inference", "Cold_Inference_Benchmark.json", false, false,
+            {{512, 1000, 10}, {4096, 1000, 10}, {32768, 1000, 10}, {262144, 100, 10}}, benchmark_cold_inference},
+        {"allocators", "Allocators_Benchmark.json", false, false,
+            {{64, 1000, 10}, {4096, 1000, 10}, {262144, 200, 10}, {1048576, 100, 10}}, benchmark_allocators},
+        {"hogwild", "Hogwild_Benchmark.json", false, true, {{256, 5, 4}, {4096, 5, 4}, {32768, 5, 4}}, benchmark_hogwild},
+        {"sharded_inference", "Sharded_Inference_Benchmark.json", false, true,
+            {{4096, 1000, 10}, {16384, 1000, 10}, {65536, 1000, 10}, {262144, 100, 10}, {1048576, 100, 10}},
+            benchmark_sharded_inference, sharded_crossover},
+        {"model_load", "Model_Load_Benchmark.json", false, false, {{4096, 1000, 0}, {65536, 1000, 0}, {1048576, 100, 0}},
+            [](size_t size, int iterations, int){ return benchmark_model_load(size, iterations); }},
+        {"dataset_reader", "Dataset_Reader_Benchmark.json", false, true,
+            {{64, 5, 200000}, {512, 5, 20000}, {4096, 5, 2500}}, benchmark_dataset_reader},
+        {"snapshot", "Snapshot_Benchmark.json", false, true, {{512, 100000, 16}, {8192, 100000, 16}, {32768, 10000, 16}}, benchmark_snapshot},
+        {"pipeline", "Pipeline_Benchmark.json", false, true, {{64, 100000, 16}, {512, 100000, 16}, {4096, 20000, 16}}, benchmark_pipeline},
+        {"server", "Server_Benchmark.json", false, true, {{64, 20000, 8}, {512, 20000, 8}, {4096, 5000, 8}}, benchmark_server},
+        {"adamw", "AdamW_Benchmark.json", true, false, powers_of_two, benchmark_adamw},
+        {"sgd_batch", "SGD_Batch_Benchmark.json", true, false,
+            {{512, 1000, 10}, {2048, 1000, 10}, {8192, 1000, 10}, {32768, 1000, 10}}, benchmark_sgd_batch},
+        {"inference_batch", "Inference_Batch_Benchmark.json", true, false,
+            {{512, 1000, 10}, {2048, 1000, 10}, {8192, 1000, 10}, {32768, 1000, 10}}, benchmark_inference_batch},
+        {"sparse", "Sparse_Benchmark.json", true, false,
+            {{8192, 1000, 10}, {32768, 1000, 10}, {262144, 100, 10}, {1048576, 100, 10}}, benchmark_sparse},
+        {"feature_hashing", "Feature_Hashing_Benchmark.json", true, false,
+            {{4096, 1000, 10}, {65536, 500, 5}, {1048576, 100, 1}}, benchmark_feature_hashing},
+        {"softmax", "Softmax_Benchmark.json", true, false,
+            {{64, 1000, 10}, {512, 1000, 10}, {2048, 1000, 10}, {8192, 1000, 10}}, benchmark_softmax},
+        {"sigmoid", "Sigmoid_Benchmark.json", true, false, {{16, 10000, 100}, {256, 10000, 10}, {4096, 1000, 10}}, benchmark_sigmoid},
+        {"online", "Online_Benchmark.json", true, false,
+            {{64, 1000, 10}, {512, 1000, 10}, {2048, 1000, 10}, {8192, 1000, 10}, {32768, 1000, 10}}, benchmark_predict_and_learn},
+        {"fixed_model", "Fixed_Model_Benchmark.json", true, false,
+            {{16, 100000, 100}, {32, 100000, 100}, {64, 100000, 100}, {128, 100000, 100}, {256, 100000, 100}}, benchmark_fixed_model},
+    };
+}
+
+//Sizes outside the defaults borrow the counts of the largest default below them (the smallest if none is)
+static benchCase resolveCase(const benchEntry& entry, size_t size){
+    benchCase resolved= entry.defaults.front();
+    for (const benchCase& candidate: entry.defaults){
+        if (candidate.size <= size){
+            resolved= candidate;
+        }
+    }
+    resolved.size= size;
+    resolved.iterations= settings().iterations > 0? settings().iterations: resolved.iterations;
+    resolved.reps= settings().reps > 0? settings().reps: resolved.reps;
+    return resolved;
+}
+
+int main(int argc, char** argv) {
+    parseBenchArgs(argc, argv);
+    const benchConfig& config= settings();
+    std::vector<benchEntry> entries= benchmarks();
+
+    if (config.list){
+        for (const benchEntry& entry: entries){
+            std::cout << entry.name << (entry.avx2_only? " (AVX2)": "") << ":";
+            for (const benchCase& c: entry.defaults){
+                std::cout << " " << c.size;
+            }
+            std::cout << std::endl;
+        }
+        return 0;
+    }
+    for (const std::string& name: config.benchmarks){
+        if (std::none_of(entries.begin(), entries.end(), [&](const benchEntry& entry){ return entry.name == name; })){
+            std::cerr << "Unknown benchmark " << name << ", see --list" << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "Dispatched ISA: " << isaName(kernels().isa) << " (detected " << isaName(detectISA()) << ")" << std::endl;
+    std::filesystem::create_directories(config.output_dir);
+    pinDriverThread();
+
+    for (const benchEntry& entry: entries){
+        if (!config.benchmarks.empty() && std::find(config.benchmarks.begin(), config.benchmarks.end(), entry.name) == config.benchmarks.end()){
+            continue;
+        }
+        if (entry.avx2_only && kernels().isa < ISA::AVX2){
+            std::cout << "Skipping " << entry.name << ", it needs AVX2" << std::endl;
+            continue;
+        }
+        if (entry.multithreaded){
+            releaseDriverThread();
+        }
+
+        json data;
+        data["ISA"]= isaName(kernels().isa);
+        data["Config"]= configJson();
+        std::vector<size_t> requested= config.sizes;
+        if (requested.empty()){
+            for (const benchCase& c: entry.defaults){
+                requested.push_back(c.size);
+            }
+        }
+
+        std::vector<std::string> sizes;
+        for (size_t size: requested){
+            benchCase c= resolveCase(entry, size);
+            std::cout << entry.name << " " << c.size << ": " << c.iterations << " iterations x " << c.reps << std::endl;
+            //A whole throwaway run: it allocates its own models and buffers (and spawns its own threads or server
+            //clients), so it warms code, branch predictors, clock frequency and the allocator's free lists, while the
+            //measured run's data is first touched by its own early samples
+            if (config.warmup > 0){
+                entry.run(c.size, std::min(config.warmup, c.iterations), c.reps);
+            }
+            sizes.push_back(std::to_string(c.size));
+            data[sizes.back()]= entry.run(c.size, c.iterations, c.reps);
+        }
+        if (entry.crossover){
+            data["Crossover"]= entry.crossover(data, sizes);
+        }
+
+        std::ofstream output(std::filesystem::path(config.output_dir)/ entry.output);
+        output << data.dump(4);
+        output.close();
+
+        if (entry.multithreaded){
+            pinDriverThread();
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include "perf_counters.hh"
+#include "benchmark.hh"
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static const char* PERF_EVENT_NAMES[PERF_EVENT_COUNT]= {"Cycles", "Instructions", "L1D_Misses", "LLC_Misses", "DTLB_Misses"};
+
+static constexpr uint64_t cacheMiss(uint64_t cache){
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+static int openEvent(uint32_t type, uint64_t config, int group_fd){
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size= sizeof(attr);
+    attr.type= type;
+    attr.config= config;
+    attr.disabled= group_fd == -1;
+    attr.exclude_kernel= 1;
+    attr.exclude_hv= 1;
+    attr.read_format= PERF_FORMAT_GROUP | PERF_FORMAT_ID | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+
+PerfCounters::PerfCounters(): leader_m(-1), fds_m{}, ids_m{}, begin_m{}, enabled_m{}{
+    fds_m.fill(-1);
+    if (!settings().perf_counters){
+        return;
+    }
+
+    const std::array<std::pair<uint32_t, uint64_t>, PERF_EVENT_COUNT> events{{
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_L1D)},
+        {PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_LL)},
+        {PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_DTLB)}
+    }};
+
+    leader_m= openEvent(events[0].first, events[0].second, -1);
+    if (leader_m < 0){
+        return;
+    }
+    fds_m[0]= leader_m;
+    for (size_t e= 1; e < PERF_EVENT_COUNT; e++){
+        fds_m[e]= openEvent(events[e].first, events[e].second, leader_m);
+    }
+    for (size_t e= 0; e < PERF_EVENT_COUNT; e++){
+        if (fds_m[e] >= 0 && ioctl(fds_m[e], PERF_EVENT_IOC_ID, &ids_m[e]) == 0){
+            enabled_m[e]= true;
+        }
+    }
+    ioctl(leader_m, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader_m, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+PerfCounters::~PerfCounters(){
+    for (int fd: fds_m){
+        if (fd >= 0){
+            close(fd);
+        }
+    }
+}
+
+bool PerfCounters::available() const{
+    return leader_m >= 0;
+}
+
+//Group layout: nr, time_enabled, time_running, then {value, id} per open event
+bool PerfCounters::read(std::array<double, PERF_EVENT_COUNT>& values) const{
+    uint64_t buffer[3 + 2* PERF_EVENT_COUNT];
+    if (::read(leader_m, buffer, sizeof(buffer)) < static_cast<ssize_t>(3* sizeof(uint64_t))){
+        return false;
+    }
+    //running < enabled means the group shared the PMU, extrapolate to the full window
+    double scale= buffer[2] > 0? static_cast<double>(buffer[1])/ buffer[2]: 0.0;
+    values.fill(0.0);
+    for (uint64_t n= 0; n < buffer[0] && n < PERF_EVENT_COUNT; n++){
+        for (size_t e= 0; e < PERF_EVENT_COUNT; e++){
+            if (enabled_m[e] && ids_m[e] == buffer[4 + 2* n]){
+                values[e]= buffer[3 + 2* n]* scale;
+            }
+        }
+    }
+    return true;
+}
+
+void PerfCounters::begin(){
+    if (available() && !read(begin_m)){
+        begin_m.fill(0.0);
+    }
+}
+
+void PerfCounters::end(perfRegion& region, uint64_t calls){
+    std::array<double, PERF_EVENT_COUNT> end_values;
+    if (!available() || !read(end_values)){
+        return;
+    }
+    for (size_t e= 0; e < PERF_EVENT_COUNT; e++){
+        region.totals[e]+= end_values[e] - begin_m[e];
+    }
+    region.calls+= calls;
+}
+
+json PerfCounters::summary(const perfRegion& region) const{
+    json result;
+    if (!available()){
+        result["error"]= settings().perf_counters? "perf_event_open unavailable (no PMU access or perf_event_paranoid > 2)": "disabled by --no-perf";
+        return result;
+    }
+    if (region.calls == 0){
+        result["error"]= "No measurements";
+        return result;
+    }
+
+    const double calls= static_cast<double>(region.calls);
+    for (size_t e= 0; e < PERF_EVENT_COUNT; e++){
+        if (enabled_m[e]){
+            result[std::string(PERF_EVENT_NAMES[e]) + "_Per_Call"]= region.totals[e]/ calls;
+        }
+    }
+    const double instructions= region.totals[static_cast<size_t>(PerfEvent::Instructions)];
+    if (enabled_m[static_cast<size_t>(PerfEvent::Instructions)] && region.totals[0] > 0.0){
+        result["IPC"]= instructions/ region.totals[0];
+    }
+    if (enabled_m[static_cast<size_t>(PerfEvent::Instructions)] && instructions > 0.0){
+        for (PerfEvent miss: {PerfEvent::L1D_Misses, PerfEvent::LLC_Misses, PerfEvent::DTLB_Misses}){
+            size_t e= static_cast<size_t>(miss);
+            if (enabled_m[e]){
+                result[std::string(PERF_EVENT_NAMES[e]) + "_PKI"]= region.totals[e]* 1000.0/ instructions;
+            }
+        }
+    }
+    return result;
+}
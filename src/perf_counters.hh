@@ -0,0 +1,51 @@
+//In-process hardware counters (perf_event_open) for the calling thread, user space only
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+enum class PerfEvent{
+    Cycles= 0,
+    Instructions,
+    L1D_Misses,
+    LLC_Misses,
+    DTLB_Misses
+};
+
+constexpr size_t PERF_EVENT_COUNT= 5;
+
+//Counter deltas summed over every measurement of one region, scaled up when the kernel multiplexed the group
+struct perfRegion{
+    std::array<double, PERF_EVENT_COUNT> totals{};
+    uint64_t calls= 0;
+};
+
+//One event group led by cycles, events the PMU or kernel refuses are left out
+//Reads happen outside the benchClock timestamps, so the counters never add to the measured latency
+class PerfCounters{
+    private:
+        int leader_m;
+        std::array<int, PERF_EVENT_COUNT> fds_m;
+        std::array<uint64_t, PERF_EVENT_COUNT> ids_m;
+        std::array<double, PERF_EVENT_COUNT> begin_m;
+        std::array<bool, PERF_EVENT_COUNT> enabled_m; //opened and joined the group
+
+        bool read(std::array<double, PERF_EVENT_COUNT>& values) const;
+
+    public:
+        PerfCounters();
+        ~PerfCounters();
+
+        PerfCounters(const PerfCounters&)= delete;
+        PerfCounters& operator=(const PerfCounters&)= delete;
+
+        bool available() const;
+        void begin();
+        //Adds the counts since begin() to region, calls is the number of kernel calls in between
+        void end(perfRegion& region, uint64_t calls);
+        //Per-call counts, IPC and misses per 1k instructions, {"error": ...} when the counters are unavailable
+        json summary(const perfRegion& region) const;
+};
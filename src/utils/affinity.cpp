@@ -0,0 +1,43 @@
+#include "affinity.hh"
+#include <pthread.h>
+#include <sched.h>
+
+int allowedCPUCount(){
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &allowed) != 0){
+        return 0;
+    }
+    return CPU_COUNT(&allowed);
+}
+
+int allowedCPU(size_t n){
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &allowed) != 0){
+        return -1;
+    }
+
+    int count= CPU_COUNT(&allowed);
+    if (count == 0){
+        return -1;
+    }
+    size_t target= n % static_cast<size_t>(count);
+    for (int cpu= 0; cpu < CPU_SETSIZE; cpu++){
+        if (CPU_ISSET(cpu, &allowed) && target-- == 0){
+            return cpu;
+        }
+    }
+    return -1;
+}
+
+bool pinToAllowedCPU(size_t n){
+    int cpu= allowedCPU(n);
+    if (cpu < 0){
+        return false;
+    }
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu, &cpu_set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set) == 0;
+}
@@ -0,0 +1,12 @@
+//Thread placement that respects the process cpuset (taskset, cgroups) instead of assuming CPUs 0..N-1
+#pragma once
+#include <cstddef>
+
+//Number of CPUs in the calling thread's sched_getaffinity mask, 0 if it can't be read
+int allowedCPUCount();
+
+//n-th CPU of the calling thread's sched_getaffinity mask, wrapping around, -1 if the mask can't be read
+int allowedCPU(size_t n);
+
+//Pins the calling thread to allowedCPU(n), false if the CPU is unknown or the kernel refused
+bool pinToAllowedCPU(size_t n);
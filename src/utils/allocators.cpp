@@ -0,0 +1,138 @@
+#include "allocators.hh"
+#include <new>
+#include <sys/mman.h>
+
+constexpr size_t POOL_BLOCK_ALIGN= 4096;
+
+static size_t roundUp(size_t bytes, size_t multiple){
+    return (bytes + multiple - 1)/ multiple* multiple;
+}
+
+HugePageAllocator::HugePageAllocator(size_t min_bytes, bool use_hugetlb):
+    min_bytes_m(min_bytes),
+    use_hugetlb_m(use_hugetlb),
+    hugetlb_bytes_m(0),
+    advised_bytes_m(0),
+    small_bytes_m(0){}
+
+//The fallback maps one extra huge page and trims both ends, so the kept range starts on a 2 MB boundary where THP can
+//use a huge page for every 2 MB of it
+void* HugePageAllocator::allocate(size_t bytes, size_t alignment){
+    assert(alignment <= HUGE_PAGE_BYTES && "Alignment above the huge page size");
+    if (bytes < min_bytes_m){
+        void* ptr= std::aligned_alloc(alignment, bytes);
+        if (!ptr){
+            throw std::bad_alloc();
+        }
+        small_bytes_m.fetch_add(bytes, std::memory_order_relaxed);
+        return ptr;
+    }
+
+    const size_t length= roundUp(bytes, HUGE_PAGE_BYTES);
+    if (use_hugetlb_m){
+        void* ptr= mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (ptr != MAP_FAILED){
+            hugetlb_bytes_m.fetch_add(length, std::memory_order_relaxed);
+            return ptr;
+        }
+    }
+
+    void* mapping= mmap(nullptr, length + HUGE_PAGE_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED){
+        throw std::bad_alloc();
+    }
+    std::byte* base= static_cast<std::byte*>(mapping);
+    std::byte* aligned= reinterpret_cast<std::byte*>(roundUp(reinterpret_cast<uintptr_t>(base), HUGE_PAGE_BYTES));
+    if (aligned != base){
+        munmap(base, aligned - base);
+    }
+    munmap(aligned + length, base + HUGE_PAGE_BYTES - aligned);
+    madvise(aligned, length, MADV_HUGEPAGE);
+    advised_bytes_m.fetch_add(length, std::memory_order_relaxed);
+    return aligned;
+}
+
+//Both mapping paths keep exactly the rounded length, so munmap doesn't need to know which one served the array
+void HugePageAllocator::deallocate(void* ptr, size_t bytes){
+    if (bytes < min_bytes_m){
+        free(ptr);
+        return;
+    }
+    munmap(ptr, roundUp(bytes, HUGE_PAGE_BYTES));
+}
+
+size_t HugePageAllocator::hugetlbBytes() const{
+    return hugetlb_bytes_m.load(std::memory_order_relaxed);
+}
+
+size_t HugePageAllocator::advisedBytes() const{
+    return advised_bytes_m.load(std::memory_order_relaxed);
+}
+
+size_t HugePageAllocator::smallBytes() const{
+    return small_bytes_m.load(std::memory_order_relaxed);
+}
+
+HugePageAllocator* hugePageAllocator(){
+    static HugePageAllocator allocator;
+    return &allocator;
+}
+
+PoolAllocator::PoolAllocator(size_t block_bytes, ArrayAllocator* upstream):
+    block_bytes_m(roundUp(block_bytes, POOL_BLOCK_ALIGN)),
+    upstream_m(upstream),
+    cursor_m(nullptr),
+    end_m(nullptr),
+    used_m(0),
+    reserved_m(0){
+    assert(block_bytes > 0 && "Empty pool blocks");
+}
+
+PoolAllocator::~PoolAllocator(){
+    for (auto [block, bytes]: blocks_m){
+        if (upstream_m){
+            upstream_m->deallocate(block, bytes);
+        }
+        else{
+            free(block);
+        }
+    }
+}
+
+std::byte* PoolAllocator::block(size_t bytes){
+    std::byte* memory= static_cast<std::byte*>(upstream_m? upstream_m->allocate(bytes, POOL_BLOCK_ALIGN): std::aligned_alloc(POOL_BLOCK_ALIGN, bytes));
+    if (!memory){
+        throw std::bad_alloc();
+    }
+    blocks_m.emplace_back(memory, bytes);
+    reserved_m+= bytes;
+    return memory;
+}
+
+//Arrays larger than a block get a block of their own, the current block keeps serving the small ones
+void* PoolAllocator::allocate(size_t bytes, size_t alignment){
+    assert(alignment <= POOL_BLOCK_ALIGN && "Pool alignment above the block alignment");
+    if (bytes > block_bytes_m){
+        used_m+= bytes;
+        return block(roundUp(bytes, POOL_BLOCK_ALIGN));
+    }
+    std::byte* aligned= reinterpret_cast<std::byte*>(roundUp(reinterpret_cast<uintptr_t>(cursor_m), alignment));
+    if (!cursor_m || aligned + bytes > end_m){
+        cursor_m= block(block_bytes_m);
+        end_m= cursor_m + block_bytes_m;
+        aligned= cursor_m;
+    }
+    used_m+= aligned + bytes - cursor_m;
+    cursor_m= aligned + bytes;
+    return aligned;
+}
+
+void PoolAllocator::deallocate(void*, size_t){}
+
+size_t PoolAllocator::usedBytes() const{
+    return used_m;
+}
+
+size_t PoolAllocator::reservedBytes() const{
+    return reserved_m;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "containers.hh"
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+constexpr size_t HUGE_PAGE_BYTES= size_t(2) << 20;
+
+//2 MB pages for large arrays such as a big model's weights: one dTLB entry covers what 512 small pages would.
+//Tries MAP_HUGETLB first (needs pages reserved in /proc/sys/vm/nr_hugepages), then falls back to a 2 MB-aligned
+//anonymous mapping with MADV_HUGEPAGE so transparent huge pages can back it. Mappings are whole huge pages, so arrays
+//below min_bytes go to aligned_alloc instead. Thread-safe, must outlive every array it served
+class HugePageAllocator: public ArrayAllocator{
+    private:
+        const size_t min_bytes_m;
+        const bool use_hugetlb_m;
+        std::atomic<size_t> hugetlb_bytes_m;
+        std::atomic<size_t> advised_bytes_m;
+        std::atomic<size_t> small_bytes_m;
+
+    public:
+        explicit HugePageAllocator(size_t min_bytes= HUGE_PAGE_BYTES/ 4, bool use_hugetlb= true);
+
+        void* allocate(size_t bytes, size_t alignment) override;
+        void deallocate(void* ptr, size_t bytes) override;
+
+        //Bytes served so far per path: reserved huge pages, madvise'd mappings (THP is best effort) and aligned_alloc
+        size_t hugetlbBytes() const;
+        size_t advisedBytes() const;
+        size_t smallBytes() const;
+};
+
+//Process-wide instance with the default settings
+HugePageAllocator* hugePageAllocator();
+
+//Bump arena for many small arrays (e.g. thousands of small models): allocations are carved back to back out of
+//block_bytes blocks, so creating a model costs a few pointer bumps and neighbouring models share pages.
+//deallocate() is a no-op, the blocks go back when the pool is destroyed, which must outlive every array it served.
+//Blocks come from upstream (aligned_alloc when null), a HugePageAllocator packs the arrays into huge pages.
+//Not thread-safe
+class PoolAllocator: public ArrayAllocator{
+    private:
+        const size_t block_bytes_m;
+        ArrayAllocator* upstream_m;
+        std::vector<std::pair<std::byte*, size_t>> blocks_m;
+        std::byte* cursor_m;
+        std::byte* end_m;
+        size_t used_m;
+        size_t reserved_m;
+
+        std::byte* block(size_t bytes);
+
+    public:
+        explicit PoolAllocator(size_t block_bytes= HUGE_PAGE_BYTES, ArrayAllocator* upstream= nullptr);
+        ~PoolAllocator();
+
+        PoolAllocator(const PoolAllocator&)= delete;
+        PoolAllocator& operator=(const PoolAllocator&)= delete;
+
+        void* allocate(size_t bytes, size_t alignment) override;
+        void deallocate(void* ptr, size_t bytes) override;
+
+        size_t usedBytes() const;     //handed out, alignment padding included
+        size_t reservedBytes() const; //held in blocks
+};
@@ -17,15 +17,14 @@ void quantize8_8_inplace(float* v, int16_t* q, size_t size){
         __m256i vec1_pi= _mm256_cvtps_epi32(vec1_fp_scaled);
         __m256i vec2_pi= _mm256_cvtps_epi32(vec2_fp_scaled);
 
-        __m256i vec_pi= _mm256_packs_epi32(vec1_pi, vec2_pi);
+        //packs works per 128-bit lane, restore element order so q[i] stays the quantized v[i]
+        __m256i vec_pi= _mm256_permute4x64_epi64(_mm256_packs_epi32(vec1_pi, vec2_pi), 0xD8);
         _mm256_store_si256(reinterpret_cast<__m256i*>(&q[i]), vec_pi);
     }
 
     for (; i < size; i++) {
         float val= v[i];
-        val= clamp(val, MINQ, MAXQ);
-        val= val * SCALE_FACTOR + ROUND_FACTOR;
-        q[i]= static_cast<int16_t>(val);
+        q[i]= avx_float_to_q8_8(clamp(val, MINQ, MAXQ));
     }
 }
 
@@ -63,6 +62,59 @@ int32_t dotproduct_q8_8(int16_t* w_q8_8, int16_t* x_q8_8, size_t size){
     return sum_q16_16;
 }
 
+//madd gives pair sums in [-2147418112, 2^31], where only 2^31 wraps (to INT32_MIN, from two (-32768)^2 products)
+//r - 1 never wraps, so it is split exactly as hi * 2^16 + lo with lo in [0, 2^16) and the 1 is added back per lane
+//at the end: per-lane hi and lo sums stay inside int32 for a whole Q8_8_WIDE_BLOCK
+static inline void accumulate_wide(__m256i r, __m256i& vec_hi, __m256i& vec_lo){
+    r= _mm256_add_epi32(r, _mm256_set1_epi32(-1));
+    vec_hi= _mm256_add_epi32(vec_hi, _mm256_srai_epi32(r, 16));
+    vec_lo= _mm256_add_epi32(vec_lo, _mm256_and_si256(r, _mm256_set1_epi32(0xFFFF)));
+}
+
+static inline int64_t widen_epi32(__m256i vec_hi, __m256i vec_lo){
+    alignas(32) int32_t hi[8];
+    alignas(32) int32_t lo[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(hi), vec_hi);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lo), vec_lo);
+    int64_t sum= 0;
+    for (size_t k= 0; k < 8; k++){
+        sum+= static_cast<int64_t>(hi[k])* 65536 + lo[k];
+    }
+    return sum;
+}
+
+int64_t dotproduct_q8_8_wide(int16_t* w_q8_8, int16_t* x_q8_8, size_t size){
+    int64_t sum_q16_16= 0;
+    size_t i= 0;
+    while (i + 16 <= size){
+        size_t block_end= std::min(size, i + Q8_8_WIDE_BLOCK);
+        size_t block_begin= i;
+        __m256i vec_hi= _mm256_setzero_si256();
+        __m256i vec_lo= _mm256_setzero_si256();
+
+        for (; i + 32 <= block_end; i += 32){
+            _mm_prefetch(reinterpret_cast<const char*>(&w_q8_8[i+ 64]), _MM_HINT_T0);
+            _mm_prefetch(reinterpret_cast<const char*>(&x_q8_8[i+ 64]), _MM_HINT_T0);
+
+            accumulate_wide(_mm256_madd_epi16(_mm256_load_si256((__m256i*)&w_q8_8[i]), _mm256_load_si256((__m256i*)&x_q8_8[i])), vec_hi, vec_lo);
+            accumulate_wide(_mm256_madd_epi16(_mm256_load_si256((__m256i*)&w_q8_8[i+ 16]), _mm256_load_si256((__m256i*)&x_q8_8[i+ 16])), vec_hi, vec_lo);
+        }
+        if (i + 16 <= block_end){
+            accumulate_wide(_mm256_madd_epi16(_mm256_load_si256((__m256i*)&w_q8_8[i]), _mm256_load_si256((__m256i*)&x_q8_8[i])), vec_hi, vec_lo);
+            i+= 16;
+        }
+
+        //one madd lane per pair of elements
+        sum_q16_16+= widen_epi32(vec_hi, vec_lo) + static_cast<int64_t>((i - block_begin)/ 2);
+    }
+
+    for(; i < size; i++){
+        sum_q16_16+= static_cast<int64_t>(w_q8_8[i])* x_q8_8[i];
+    }
+
+    return sum_q16_16;
+}
+
 float dotproduct_fp(float* w_fp, float* x_fp, size_t size){
     __m256 vec_sum_fp= _mm256_setzero_ps();
     size_t i = 0;
@@ -102,7 +154,7 @@ void sgd_inplace(int16_t y_hat, float y, float* w_fp, float* x_fp, size_t size,
     __m256 vec_neg_coeff= _mm256_broadcast_ss(&neg_coeff); 
 
     size_t i= 0;    
-    for (; i < size ; i += 16){
+    for (; i + 16 <= size ; i += 16){
 
         _mm_prefetch(reinterpret_cast<const char*>(&x_fp[i + 32]), _MM_HINT_T0);
         _mm_prefetch(reinterpret_cast<const char*>(&w_fp[i + 32]), _MM_HINT_T0);
@@ -124,8 +176,857 @@ void sgd_inplace(int16_t y_hat, float y, float* w_fp, float* x_fp, size_t size,
     }
 }
 
+//delta= lr * sum_b (y_hat_b - y_b)x_b^T, the sum of batch_size sgd_inplace steps taken at the same weights
+//Each weight tile is read, updated by every row and written back (with its Q8.8 copy) exactly once
+void sgd_batch_inplace(float* y_hat, float* y, float* w_fp, int16_t* w_q8_8, float* x_fp, size_t batch_size, size_t size, float lr){
+    size_t i= 0;
+    for (; i + 16 <= size; i += 16){
+        _mm_prefetch(reinterpret_cast<const char*>(&w_fp[i + 32]), _MM_HINT_T0);
+
+        __m256 vec1_w_fp= _mm256_load_ps(&w_fp[i]);
+        __m256 vec2_w_fp= _mm256_load_ps(&w_fp[i + 8]);
+
+        for (size_t n= 0; n < batch_size; n++){
+            float* x= &x_fp[n* size];
+            __m256 vec_neg_coeff= _mm256_set1_ps(lr*(y[n] - y_hat[n]));
+
+            vec1_w_fp= _mm256_fmadd_ps(vec_neg_coeff, _mm256_loadu_ps(&x[i]), vec1_w_fp);
+            vec2_w_fp= _mm256_fmadd_ps(vec_neg_coeff, _mm256_loadu_ps(&x[i + 8]), vec2_w_fp);
+        }
+
+        _mm256_store_ps(&w_fp[i], vec1_w_fp);
+        _mm256_store_ps(&w_fp[i + 8], vec2_w_fp);
+
+        __m256i vec1_pi= _mm256_cvtps_epi32(_mm256_fmadd_ps(clamp(vec1_w_fp, MM256_MINQ, MM256_MAXQ), MM256_SCALE, MM256_ROUND));
+        __m256i vec2_pi= _mm256_cvtps_epi32(_mm256_fmadd_ps(clamp(vec2_w_fp, MM256_MINQ, MM256_MAXQ), MM256_SCALE, MM256_ROUND));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(&w_q8_8[i]), _mm256_permute4x64_epi64(_mm256_packs_epi32(vec1_pi, vec2_pi), 0xD8));
+    }
+
+    for (; i < size; i++){
+        float w= w_fp[i];
+        for (size_t n= 0; n < batch_size; n++){
+            w+= lr*(y[n] - y_hat[n])* x_fp[n* size + i];
+        }
+        w_fp[i]= w;
+        w_q8_8[i]= avx_float_to_q8_8(clamp(w, MINQ, MAXQ));
+    }
+}
+
 //refer to pseudocode
+//g= (y_hat - y)x, m= b1*m + (1-b1)g, v= b2*v + (1-b2)g^2, w= decay*w - lr * m_hat / (sqrt(v_hat) + eps)
 void adamW_inplace(int16_t y_hat, float y, float* w_fp, float* x_fp, size_t size, AdamWParams& parmas){
-    return;
+    float coeff= q8_8_to_float(y_hat) - y;
+    float m_correction= 1.0f/ (1.0f - parmas.beta1i);
+    float v_correction= 1.0f/ (1.0f - parmas.beta2i);
+    float neg_lr= -parmas.learning_rate;
+
+    __m256 vec_coeff= _mm256_broadcast_ss(&coeff);
+    __m256 vec_beta1= _mm256_broadcast_ss(&parmas.beta1);
+    __m256 vec_beta2= _mm256_broadcast_ss(&parmas.beta2);
+    __m256 vec_beta1_c= _mm256_broadcast_ss(&parmas.beta1_complement);
+    __m256 vec_beta2_c= _mm256_broadcast_ss(&parmas.beta2_complement);
+    __m256 vec_m_correction= _mm256_broadcast_ss(&m_correction);
+    __m256 vec_v_correction= _mm256_broadcast_ss(&v_correction);
+    __m256 vec_decay= _mm256_broadcast_ss(&parmas.decay);
+    __m256 vec_eps= _mm256_broadcast_ss(&parmas.eps);
+    __m256 vec_neg_lr= _mm256_broadcast_ss(&neg_lr);
+
+    float* m_fp= parmas.moment1.data();
+    float* v_fp= parmas.moment2.data();
+
+    size_t i= 0;
+    for (; i + 8 <= size; i += 8){
+        _mm_prefetch(reinterpret_cast<const char*>(&x_fp[i + 32]), _MM_HINT_T0);
+        _mm_prefetch(reinterpret_cast<const char*>(&w_fp[i + 32]), _MM_HINT_T0);
+        _mm_prefetch(reinterpret_cast<const char*>(&m_fp[i + 32]), _MM_HINT_T0);
+        _mm_prefetch(reinterpret_cast<const char*>(&v_fp[i + 32]), _MM_HINT_T0);
+
+        __m256 vec_g= _mm256_mul_ps(vec_coeff, _mm256_load_ps(&x_fp[i]));
+        __m256 vec_m= _mm256_load_ps(&m_fp[i]);
+        __m256 vec_v= _mm256_load_ps(&v_fp[i]);
+        __m256 vec_w= _mm256_load_ps(&w_fp[i]);
+
+        vec_m= _mm256_fmadd_ps(vec_beta1, vec_m, _mm256_mul_ps(vec_beta1_c, vec_g));
+        vec_v= _mm256_fmadd_ps(vec_beta2, vec_v, _mm256_mul_ps(vec_beta2_c, _mm256_mul_ps(vec_g, vec_g)));
+
+        __m256 vec_m_hat= _mm256_mul_ps(vec_m, vec_m_correction);
+        __m256 vec_v_hat= _mm256_mul_ps(vec_v, vec_v_correction);
+        __m256 vec_step= _mm256_div_ps(vec_m_hat, _mm256_add_ps(_mm256_sqrt_ps(vec_v_hat), vec_eps));
+
+        vec_w= _mm256_fmadd_ps(vec_neg_lr, vec_step, _mm256_mul_ps(vec_decay, vec_w));
+
+        _mm256_store_ps(&m_fp[i], vec_m);
+        _mm256_store_ps(&v_fp[i], vec_v);
+        _mm256_store_ps(&w_fp[i], vec_w);
+    }
+
+    //same fused operations as the vector body, so a weight's update doesn't depend on its index
+    for (; i < size; i++){
+        float g= coeff* x_fp[i];
+        m_fp[i]= std::fma(parmas.beta1, m_fp[i], parmas.beta1_complement* g);
+        v_fp[i]= std::fma(parmas.beta2, v_fp[i], parmas.beta2_complement* (g* g));
+
+        float m_hat= m_fp[i]* m_correction;
+        float v_hat= v_fp[i]* v_correction;
+        w_fp[i]= std::fma(neg_lr, m_hat/ (std::sqrt(v_hat) + parmas.eps), parmas.decay* w_fp[i]);
+    }
+
+    parmas.beta1i*= parmas.beta1;
+    parmas.beta2i*= parmas.beta2;
+}
+
+
+//Rows scored per weight load in the batched kernels (the tile loops are unrolled by hand to match)
+constexpr size_t BATCH_TILE= 4;
+
+static inline float hsum_ps(__m256 v){
+    __m128 lower= _mm256_castps256_ps128(v);
+    __m128 higher= _mm256_extractf128_ps(v, 1);
+    __m128 sum_128= _mm_add_ps(lower, higher);
+    sum_128= _mm_hadd_ps(sum_128, sum_128);
+    sum_128= _mm_hadd_ps(sum_128, sum_128);
+    return _mm_cvtss_f32(sum_128);
+}
+
+//Scores BATCH_TILE rows per pass so every weight register is loaded once and reused across the tile
+void dotproduct_fp_batch(float* w_fp, float* x_fp, float* out, size_t batch_size, size_t size){
+    size_t n= 0;
+    for(; n + BATCH_TILE <= batch_size; n += BATCH_TILE){
+        float* x0= &x_fp[(n + 0)* size];
+        float* x1= &x_fp[(n + 1)* size];
+        float* x2= &x_fp[(n + 2)* size];
+        float* x3= &x_fp[(n + 3)* size];
+
+        __m256 vec_sum0= _mm256_setzero_ps();
+        __m256 vec_sum1= _mm256_setzero_ps();
+        __m256 vec_sum2= _mm256_setzero_ps();
+        __m256 vec_sum3= _mm256_setzero_ps();
+
+        size_t i= 0;
+        for(; i + 16 <= size; i += 16){
+            _mm_prefetch(reinterpret_cast<const char*>(&w_fp[i+ 32]), _MM_HINT_T0);
+
+            __m256 vec1_w_fp= _mm256_load_ps(&w_fp[i]);
+            __m256 vec2_w_fp= _mm256_load_ps(&w_fp[i+ 8]);
+
+            vec_sum0= _mm256_fmadd_ps(vec1_w_fp, _mm256_loadu_ps(&x0[i]), vec_sum0);
+            vec_sum1= _mm256_fmadd_ps(vec1_w_fp, _mm256_loadu_ps(&x1[i]), vec_sum1);
+            vec_sum2= _mm256_fmadd_ps(vec1_w_fp, _mm256_loadu_ps(&x2[i]), vec_sum2);
+            vec_sum3= _mm256_fmadd_ps(vec1_w_fp, _mm256_loadu_ps(&x3[i]), vec_sum3);
+
+            vec_sum0= _mm256_fmadd_ps(vec2_w_fp, _mm256_loadu_ps(&x0[i+ 8]), vec_sum0);
+            vec_sum1= _mm256_fmadd_ps(vec2_w_fp, _mm256_loadu_ps(&x1[i+ 8]), vec_sum1);
+            vec_sum2= _mm256_fmadd_ps(vec2_w_fp, _mm256_loadu_ps(&x2[i+ 8]), vec_sum2);
+            vec_sum3= _mm256_fmadd_ps(vec2_w_fp, _mm256_loadu_ps(&x3[i+ 8]), vec_sum3);
+        }
+
+        float sum0= hsum_ps(vec_sum0);
+        float sum1= hsum_ps(vec_sum1);
+        float sum2= hsum_ps(vec_sum2);
+        float sum3= hsum_ps(vec_sum3);
+
+        for(; i < size; i++){
+            sum0 += w_fp[i] * x0[i];
+            sum1 += w_fp[i] * x1[i];
+            sum2 += w_fp[i] * x2[i];
+            sum3 += w_fp[i] * x3[i];
+        }
+
+        out[n + 0]= sum0;
+        out[n + 1]= sum1;
+        out[n + 2]= sum2;
+        out[n + 3]= sum3;
+    }
+
+    for(; n < batch_size; n++){
+        float* x= &x_fp[n* size];
+        __m256 vec_sum= _mm256_setzero_ps();
+
+        size_t i= 0;
+        for(; i + 8 <= size; i += 8){
+            vec_sum= _mm256_fmadd_ps(_mm256_load_ps(&w_fp[i]), _mm256_loadu_ps(&x[i]), vec_sum);
+        }
+
+        float sum= hsum_ps(vec_sum);
+        for(; i < size; i++){
+            sum += w_fp[i] * x[i];
+        }
+        out[n]= sum;
+    }
+}
+
+//Rows are read unaligned and written to a padded stride so the batched kernel can use aligned loads
+void quantize8_8_rows(float* v, int16_t* q, size_t batch_size, size_t size, size_t stride){
+    for(size_t n= 0; n < batch_size; n++){
+        float* v_row= &v[n* size];
+        int16_t* q_row= &q[n* stride];
+
+        size_t i= 0;
+        for(; i + 16 <= size; i+= 16){
+            __m256 vec1_fp= _mm256_loadu_ps(&v_row[i]);
+            __m256 vec2_fp= _mm256_loadu_ps(&v_row[i + 8]);
+
+            vec1_fp= clamp(vec1_fp, MM256_MINQ, MM256_MAXQ);
+            vec2_fp= clamp(vec2_fp, MM256_MINQ, MM256_MAXQ);
+
+            __m256i vec1_pi= _mm256_cvtps_epi32(_mm256_fmadd_ps(vec1_fp, MM256_SCALE, MM256_ROUND));
+            __m256i vec2_pi= _mm256_cvtps_epi32(_mm256_fmadd_ps(vec2_fp, MM256_SCALE, MM256_ROUND));
+
+            _mm256_store_si256(reinterpret_cast<__m256i*>(&q_row[i]), _mm256_permute4x64_epi64(_mm256_packs_epi32(vec1_pi, vec2_pi), 0xD8));
+        }
+
+        for(; i < size; i++){
+            float val= clamp(v_row[i], MINQ, MAXQ);
+            q_row[i]= avx_float_to_q8_8(val);
+        }
+    }
+}
+
+void dotproduct_q8_8_batch(int16_t* w_q8_8, int16_t* x_q8_8, int32_t* out, size_t batch_size, size_t size, size_t stride){
+    size_t n= 0;
+    for(; n + BATCH_TILE <= batch_size; n += BATCH_TILE){
+        int16_t* x0= &x_q8_8[(n + 0)* stride];
+        int16_t* x1= &x_q8_8[(n + 1)* stride];
+        int16_t* x2= &x_q8_8[(n + 2)* stride];
+        int16_t* x3= &x_q8_8[(n + 3)* stride];
+
+        __m256i vec_sum0= _mm256_setzero_si256();
+        __m256i vec_sum1= _mm256_setzero_si256();
+        __m256i vec_sum2= _mm256_setzero_si256();
+        __m256i vec_sum3= _mm256_setzero_si256();
+
+        size_t i= 0;
+        for(; i + 32 <= size; i += 32){
+            _mm_prefetch(reinterpret_cast<const char*>(&w_q8_8[i+ 64]), _MM_HINT_T0);
+
+            __m256i vec1_w_q8_8= _mm256_load_si256((__m256i*)&w_q8_8[i]);
+            __m256i vec2_w_q8_8= _mm256_load_si256((__m256i*)&w_q8_8[i+ 16]);
+
+            __m256i dot0= _mm256_add_epi32(_mm256_madd_epi16(vec1_w_q8_8, _mm256_load_si256((__m256i*)&x0[i])),
+                                           _mm256_madd_epi16(vec2_w_q8_8, _mm256_load_si256((__m256i*)&x0[i+ 16])));
+            __m256i dot1= _mm256_add_epi32(_mm256_madd_epi16(vec1_w_q8_8, _mm256_load_si256((__m256i*)&x1[i])),
+                                           _mm256_madd_epi16(vec2_w_q8_8, _mm256_load_si256((__m256i*)&x1[i+ 16])));
+            __m256i dot2= _mm256_add_epi32(_mm256_madd_epi16(vec1_w_q8_8, _mm256_load_si256((__m256i*)&x2[i])),
+                                           _mm256_madd_epi16(vec2_w_q8_8, _mm256_load_si256((__m256i*)&x2[i+ 16])));
+            __m256i dot3= _mm256_add_epi32(_mm256_madd_epi16(vec1_w_q8_8, _mm256_load_si256((__m256i*)&x3[i])),
+                                           _mm256_madd_epi16(vec2_w_q8_8, _mm256_load_si256((__m256i*)&x3[i+ 16])));
+
+            vec_sum0= _mm256_add_epi32(vec_sum0, dot0);
+            vec_sum1= _mm256_add_epi32(vec_sum1, dot1);
+            vec_sum2= _mm256_add_epi32(vec_sum2, dot2);
+            vec_sum3= _mm256_add_epi32(vec_sum3, dot3);
+        }
+
+        int32_t sum0= hsum_epi32(vec_sum0);
+        int32_t sum1= hsum_epi32(vec_sum1);
+        int32_t sum2= hsum_epi32(vec_sum2);
+        int32_t sum3= hsum_epi32(vec_sum3);
+
+        for(; i < size; i++){
+            sum0 += w_q8_8[i] * x0[i];
+            sum1 += w_q8_8[i] * x1[i];
+            sum2 += w_q8_8[i] * x2[i];
+            sum3 += w_q8_8[i] * x3[i];
+        }
+
+        out[n + 0]= sum0;
+        out[n + 1]= sum1;
+        out[n + 2]= sum2;
+        out[n + 3]= sum3;
+    }
+
+    for(; n < batch_size; n++){
+        int16_t* x= &x_q8_8[n* stride];
+        __m256i vec_sum= _mm256_setzero_si256();
+
+        size_t i= 0;
+        for(; i + 16 <= size; i += 16){
+            __m256i dot= _mm256_madd_epi16(_mm256_load_si256((__m256i*)&w_q8_8[i]), _mm256_load_si256((__m256i*)&x[i]));
+            vec_sum= _mm256_add_epi32(vec_sum, dot);
+        }
+
+        int32_t sum= hsum_epi32(vec_sum);
+        for(; i < size; i++){
+            sum += w_q8_8[i] * x[i];
+        }
+        out[n]= sum;
+    }
+}
+
+float dotproduct_sparse_fp(float* w_fp, int32_t* indices, float* values, size_t nnz){
+    __m256 vec1_sum_fp= _mm256_setzero_ps();
+    __m256 vec2_sum_fp= _mm256_setzero_ps();
+
+    size_t i= 0;
+    for(; i + 16 <= nnz; i += 16){
+        __m256i vec1_idx= _mm256_loadu_si256((__m256i*)&indices[i]);
+        __m256i vec2_idx= _mm256_loadu_si256((__m256i*)&indices[i+ 8]);
+
+        __m256 vec1_w_fp= _mm256_i32gather_ps(w_fp, vec1_idx, 4);
+        __m256 vec2_w_fp= _mm256_i32gather_ps(w_fp, vec2_idx, 4);
+
+        vec1_sum_fp= _mm256_fmadd_ps(vec1_w_fp, _mm256_loadu_ps(&values[i]), vec1_sum_fp);
+        vec2_sum_fp= _mm256_fmadd_ps(vec2_w_fp, _mm256_loadu_ps(&values[i+ 8]), vec2_sum_fp);
+    }
+
+    float sum_fp= hsum_ps(_mm256_add_ps(vec1_sum_fp, vec2_sum_fp));
+    for(; i < nnz; i++){
+        sum_fp += w_fp[indices[i]] * values[i];
+    }
+    return sum_fp;
+}
+
+//AVX2 has no 16-bit gather: fetch 32 bits at each index and let madd_epi16 multiply the high half by zero
+int32_t dotproduct_sparse_q8_8(int16_t* w_q8_8, int32_t* indices, float* values, size_t nnz){
+    const __m256i vec_low_mask= _mm256_set1_epi32(0xFFFF);
+    __m256i vec_sum_q16_16= _mm256_setzero_si256();
+
+    size_t i= 0;
+    for(; i + 8 <= nnz; i += 8){
+        __m256i vec_idx= _mm256_loadu_si256((__m256i*)&indices[i]);
+        __m256i vec_w_q8_8= _mm256_i32gather_epi32(reinterpret_cast<const int*>(w_q8_8), vec_idx, 2);
+
+        __m256 vec_x_fp= clamp(_mm256_loadu_ps(&values[i]), MM256_MINQ, MM256_MAXQ);
+        __m256i vec_x_q8_8= _mm256_cvtps_epi32(_mm256_fmadd_ps(vec_x_fp, MM256_SCALE, MM256_ROUND));
+        vec_x_q8_8= _mm256_and_si256(vec_x_q8_8, vec_low_mask);
+
+        vec_sum_q16_16= _mm256_add_epi32(vec_sum_q16_16, _mm256_madd_epi16(vec_w_q8_8, vec_x_q8_8));
+    }
+
+    int32_t sum_q16_16= hsum_epi32(vec_sum_q16_16);
+    //rounds like the cvtps above and the dense quantize, so negative tail values match the dense dot product
+    for(; i < nnz; i++){
+        float val= clamp(values[i], MINQ, MAXQ);
+        sum_q16_16 += w_q8_8[indices[i]] * avx_float_to_q8_8(val);
+    }
+    return sum_q16_16;
+}
+
+void dotproduct_sparse_fp_batch(float* w_fp, size_t* row_offsets, int32_t* indices, float* values, float* out, size_t batch_size){
+    for(size_t n= 0; n < batch_size; n++){
+        size_t offset= row_offsets[n];
+        out[n]= dotproduct_sparse_fp(w_fp, &indices[offset], &values[offset], row_offsets[n + 1] - offset);
+    }
+}
+
+void dotproduct_sparse_q8_8_batch(int16_t* w_q8_8, size_t* row_offsets, int32_t* indices, float* values, int32_t* out, size_t batch_size){
+    for(size_t n= 0; n < batch_size; n++){
+        size_t offset= row_offsets[n];
+        out[n]= dotproduct_sparse_q8_8(w_q8_8, &indices[offset], &values[offset], row_offsets[n + 1] - offset);
+    }
+}
+
+//Gathers the active weights, applies the update in-register and scatters them (and their Q8.8 copy) back
+void sgd_sparse_inplace(int16_t y_hat, float y, float* w_fp, int16_t* w_q8_8, int32_t* indices, float* values, size_t nnz, float lr){
+    float neg_coeff= lr*(y- q8_8_to_float(y_hat));
+    __m256 vec_neg_coeff= _mm256_broadcast_ss(&neg_coeff);
+
+    alignas(32) float w_new[8];
+    alignas(32) int32_t q_new[8];
+
+    size_t i= 0;
+    for(; i + 8 <= nnz; i += 8){
+        __m256i vec_idx= _mm256_loadu_si256((__m256i*)&indices[i]);
+        __m256 vec_w_fp= _mm256_i32gather_ps(w_fp, vec_idx, 4);
+
+        vec_w_fp= _mm256_fmadd_ps(vec_neg_coeff, _mm256_loadu_ps(&values[i]), vec_w_fp);
+        __m256i vec_w_q8_8= _mm256_cvtps_epi32(_mm256_fmadd_ps(clamp(vec_w_fp, MM256_MINQ, MM256_MAXQ), MM256_SCALE, MM256_ROUND));
+
+        _mm256_store_ps(w_new, vec_w_fp);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(q_new), vec_w_q8_8);
+
+        for(size_t k= 0; k < 8; k++){
+            w_fp[indices[i + k]]= w_new[k];
+            w_q8_8[indices[i + k]]= static_cast<int16_t>(q_new[k]);
+        }
+    }
+
+    //rounds like the cvtps above and the dense update, truncating would leave negative tail weights a step off
+    for(; i < nnz; i++){
+        float w= w_fp[indices[i]] + neg_coeff*values[i];
+        w_fp[indices[i]]= w;
+        w_q8_8[indices[i]]= avx_float_to_q8_8(clamp(w, MINQ, MAXQ));
+    }
+}
+
+//AVX2 has no 64-bit multiply, b is a constant so its halves are split once by the caller
+static inline __m256i mullo_epi64(__m256i a, __m256i b_lo, __m256i b_hi){
+    __m256i cross= _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b_lo), _mm256_mul_epu32(a, b_hi));
+    return _mm256_add_epi64(_mm256_mul_epu32(a, b_lo), _mm256_slli_epi64(cross, 32));
+}
+
+static inline __m256i hash_feature_ids(__m256i h, __m256i seed){
+    const __m256i k1_lo= _mm256_set1_epi64x(0xED558CCDull);
+    const __m256i k1_hi= _mm256_set1_epi64x(0xFF51AFD7ull);
+    const __m256i k2_lo= _mm256_set1_epi64x(0x1A85EC53ull);
+    const __m256i k2_hi= _mm256_set1_epi64x(0xC4CEB9FEull);
+
+    h= _mm256_xor_si256(h, seed);
+    h= _mm256_xor_si256(h, _mm256_srli_epi64(h, 33));
+    h= mullo_epi64(h, k1_lo, k1_hi);
+    h= _mm256_xor_si256(h, _mm256_srli_epi64(h, 33));
+    h= mullo_epi64(h, k2_lo, k2_hi);
+    return _mm256_xor_si256(h, _mm256_srli_epi64(h, 33));
+}
+
+//Eight ids per step: the index (high half of hi32 * size) and the sign bit are built in the low 32 bits of each
+//64-bit lane, the two halves are interleaved with a blend and put back in order with one permute
+void hash_features(const uint64_t* ids, const float* values, size_t count, uint64_t seed, uint32_t size, int32_t* indices, float* out_values){
+    const __m256i vec_seed= _mm256_set1_epi64x(static_cast<long long>(seed));
+    const __m256i vec_size= _mm256_set1_epi64x(size);
+    const __m256i vec_one= _mm256_set1_epi64x(1);
+    const __m256i vec_order= _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+
+    size_t i= 0;
+    for(; i + 8 <= count; i+= 8){
+        __m256i h1= hash_feature_ids(_mm256_loadu_si256((const __m256i*)&ids[i]), vec_seed);
+        __m256i h2= hash_feature_ids(_mm256_loadu_si256((const __m256i*)&ids[i + 4]), vec_seed);
+
+        __m256i idx1= _mm256_srli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(h1, 32), vec_size), 32);
+        __m256i idx2= _mm256_mul_epu32(_mm256_srli_epi64(h2, 32), vec_size);
+        __m256i vec_idx= _mm256_permutevar8x32_epi32(_mm256_blend_epi32(idx1, idx2, 0xAA), vec_order);
+
+        __m256i sign1= _mm256_slli_epi64(_mm256_and_si256(h1, vec_one), 31);
+        __m256i sign2= _mm256_slli_epi64(_mm256_and_si256(h2, vec_one), 63);
+        __m256i vec_sign= _mm256_permutevar8x32_epi32(_mm256_blend_epi32(sign1, sign2, 0xAA), vec_order);
+
+        __m256 vec_x_fp= values? _mm256_loadu_ps(&values[i]): _mm256_set1_ps(1.0f);
+        _mm256_storeu_si256((__m256i*)&indices[i], vec_idx);
+        _mm256_storeu_ps(&out_values[i], _mm256_xor_ps(vec_x_fp, _mm256_castsi256_ps(vec_sign)));
+    }
+
+    for(; i < count; i++){
+        uint64_t h= hash_feature_id(ids[i], seed);
+        indices[i]= hashed_index(h, size);
+        out_values[i]= (values? values[i]: 1.0f)* hashed_sign(h);
+    }
+}
+
+//Class blocks of up to SOFTMAX_BLOCK * 8 logits stay in registers while the input streams past once
+constexpr size_t SOFTMAX_BLOCK= 4;
+
+template <size_t R>
+static inline void softmax_logits_fp_block(float* w_fp, float* x_fp, float* logits, size_t class_stride, size_t size){
+    __m256 vec_sum[R];
+    for(size_t r= 0; r < R; r++){
+        vec_sum[r]= _mm256_setzero_ps();
+    }
+
+    for(size_t f= 0; f < size; f++){
+        float* row= &w_fp[f* class_stride];
+        _mm_prefetch(reinterpret_cast<const char*>(row + 4* class_stride), _MM_HINT_T0);
+
+        __m256 vec_x= _mm256_broadcast_ss(&x_fp[f]);
+        for(size_t r= 0; r < R; r++){
+            vec_sum[r]= _mm256_fmadd_ps(vec_x, _mm256_load_ps(&row[8* r]), vec_sum[r]);
+        }
+    }
+
+    for(size_t r= 0; r < R; r++){
+        _mm256_store_ps(&logits[8* r], vec_sum[r]);
+    }
+}
+
+void softmax_logits_fp(float* w_fp, float* x_fp, float* logits, size_t class_stride, size_t size){
+    size_t k= 0;
+    for(; k + 8* SOFTMAX_BLOCK <= class_stride; k += 8* SOFTMAX_BLOCK){
+        softmax_logits_fp_block<SOFTMAX_BLOCK>(&w_fp[k], x_fp, &logits[k], class_stride, size);
+    }
+
+    switch((class_stride - k)/ 8){
+        case 3: softmax_logits_fp_block<3>(&w_fp[k], x_fp, &logits[k], class_stride, size); break;
+        case 2: softmax_logits_fp_block<2>(&w_fp[k], x_fp, &logits[k], class_stride, size); break;
+        case 1: softmax_logits_fp_block<1>(&w_fp[k], x_fp, &logits[k], class_stride, size); break;
+        default: break;
+    }
+}
+
+//Each 32-bit lane holds one class's weights for features (2p, 2p + 1), so madd_epi16 covers two features per instruction
+template <size_t R>
+static inline void softmax_logits_q8_8_block(int16_t* w_q8_8, int16_t* x_q8_8, int32_t* logits, size_t class_stride, size_t pairs){
+    __m256i vec_sum[R];
+    for(size_t r= 0; r < R; r++){
+        vec_sum[r]= _mm256_setzero_si256();
+    }
+
+    for(size_t p= 0; p < pairs; p++){
+        int16_t* row= &w_q8_8[2* p* class_stride];
+        _mm_prefetch(reinterpret_cast<const char*>(row + 8* class_stride), _MM_HINT_T0);
+
+        int32_t x_pair;
+        std::memcpy(&x_pair, &x_q8_8[2* p], sizeof(int32_t));
+        __m256i vec_x= _mm256_set1_epi32(x_pair);
+        for(size_t r= 0; r < R; r++){
+            __m256i vec_w= _mm256_load_si256((__m256i*)&row[16* r]);
+            vec_sum[r]= _mm256_add_epi32(vec_sum[r], _mm256_madd_epi16(vec_w, vec_x));
+        }
+    }
+
+    for(size_t r= 0; r < R; r++){
+        _mm256_store_si256((__m256i*)&logits[8* r], vec_sum[r]);
+    }
+}
+
+void softmax_logits_q8_8(int16_t* w_q8_8, int16_t* x_q8_8, int32_t* logits, size_t class_stride, size_t size){
+    size_t pairs= (size + 1)/ 2;
+    size_t k= 0;
+    for(; k + 8* SOFTMAX_BLOCK <= class_stride; k += 8* SOFTMAX_BLOCK){
+        softmax_logits_q8_8_block<SOFTMAX_BLOCK>(&w_q8_8[2* k], x_q8_8, &logits[k], class_stride, pairs);
+    }
+
+    switch((class_stride - k)/ 8){
+        case 3: softmax_logits_q8_8_block<3>(&w_q8_8[2* k], x_q8_8, &logits[k], class_stride, pairs); break;
+        case 2: softmax_logits_q8_8_block<2>(&w_q8_8[2* k], x_q8_8, &logits[k], class_stride, pairs); break;
+        case 1: softmax_logits_q8_8_block<1>(&w_q8_8[2* k], x_q8_8, &logits[k], class_stride, pairs); break;
+        default: break;
+    }
+}
+
+void softmax_inplace(float* logits, size_t num_classes, size_t class_stride){
+    for(size_t k= num_classes; k < class_stride; k++){
+        logits[k]= -INFINITY;
+    }
+
+    __m256 vec_max= _mm256_set1_ps(-INFINITY);
+    for(size_t k= 0; k < class_stride; k += 8){
+        vec_max= _mm256_max_ps(vec_max, _mm256_load_ps(&logits[k]));
+    }
+    __m128 max_128= _mm_max_ps(_mm256_castps256_ps128(vec_max), _mm256_extractf128_ps(vec_max, 1));
+    max_128= _mm_max_ps(max_128, _mm_movehl_ps(max_128, max_128));
+    max_128= _mm_max_ss(max_128, _mm_shuffle_ps(max_128, max_128, 1));
+    vec_max= _mm256_broadcastss_ps(max_128);
+
+    __m256 vec_sum= _mm256_setzero_ps();
+    for(size_t k= 0; k < class_stride; k += 8){
+        __m256 vec_exp= exp_ps(_mm256_sub_ps(_mm256_load_ps(&logits[k]), vec_max));
+        _mm256_store_ps(&logits[k], vec_exp);
+        vec_sum= _mm256_add_ps(vec_sum, vec_exp);
+    }
+
+    __m256 vec_inv_sum= _mm256_set1_ps(1.0f/ hsum_ps(vec_sum));
+    for(size_t k= 0; k < class_stride; k += 8){
+        _mm256_store_ps(&logits[k], _mm256_mul_ps(_mm256_load_ps(&logits[k]), vec_inv_sum));
+    }
+
+    for(size_t k= num_classes; k < class_stride; k++){
+        logits[k]= 0.0f;
+    }
+}
+
+template <size_t R>
+static inline void softmax_sgd_fp_block(float* neg_coeff, float* w_fp, float* x_fp, size_t class_stride, size_t size){
+    __m256 vec_neg_coeff[R];
+    for(size_t r= 0; r < R; r++){
+        vec_neg_coeff[r]= _mm256_load_ps(&neg_coeff[8* r]);
+    }
+
+    for(size_t f= 0; f < size; f++){
+        float* row= &w_fp[f* class_stride];
+        _mm_prefetch(reinterpret_cast<const char*>(row + 4* class_stride), _MM_HINT_T0);
+
+        __m256 vec_x= _mm256_broadcast_ss(&x_fp[f]);
+        for(size_t r= 0; r < R; r++){
+            _mm256_store_ps(&row[8* r], _mm256_fmadd_ps(vec_neg_coeff[r], vec_x, _mm256_load_ps(&row[8* r])));
+        }
+    }
+}
+
+void softmax_sgd_inplace(float* neg_coeff, float* w_fp, float* x_fp, size_t class_stride, size_t size){
+    size_t k= 0;
+    for(; k + 8* SOFTMAX_BLOCK <= class_stride; k += 8* SOFTMAX_BLOCK){
+        softmax_sgd_fp_block<SOFTMAX_BLOCK>(&neg_coeff[k], &w_fp[k], x_fp, class_stride, size);
+    }
+
+    switch((class_stride - k)/ 8){
+        case 3: softmax_sgd_fp_block<3>(&neg_coeff[k], &w_fp[k], x_fp, class_stride, size); break;
+        case 2: softmax_sgd_fp_block<2>(&neg_coeff[k], &w_fp[k], x_fp, class_stride, size); break;
+        case 1: softmax_sgd_fp_block<1>(&neg_coeff[k], &w_fp[k], x_fp, class_stride, size); break;
+        default: break;
+    }
+}
+
+//Same update as softmax_sgd_inplace, refreshing the pair-interleaved Q8.8 weights in the same pass
+template <size_t R>
+static inline void softmax_sgd_q8_8_block(float* neg_coeff, float* w_fp, int16_t* w_q8_8, float* x_fp, size_t class_stride, size_t size){
+    const __m256i vec_low_mask= _mm256_set1_epi32(0xFFFF);
+    __m256 vec_neg_coeff[R];
+    for(size_t r= 0; r < R; r++){
+        vec_neg_coeff[r]= _mm256_load_ps(&neg_coeff[8* r]);
+    }
+
+    for(size_t f= 0; f < size; f += 2){
+        float* row0= &w_fp[f* class_stride];
+        float* row1= &w_fp[(f + 1)* class_stride];
+        int16_t* row_q8_8= &w_q8_8[f* class_stride];
+
+        __m256 vec_x0= _mm256_broadcast_ss(&x_fp[f]);
+        __m256 vec_x1= (f + 1 < size)? _mm256_broadcast_ss(&x_fp[f + 1]): _mm256_setzero_ps();
+        for(size_t r= 0; r < R; r++){
+            __m256 vec_w0= _mm256_fmadd_ps(vec_neg_coeff[r], vec_x0, _mm256_load_ps(&row0[8* r]));
+            __m256 vec_w1= _mm256_fmadd_ps(vec_neg_coeff[r], vec_x1, _mm256_load_ps(&row1[8* r]));
+            _mm256_store_ps(&row0[8* r], vec_w0);
+            _mm256_store_ps(&row1[8* r], vec_w1);
+
+            __m256i vec_pair= _mm256_or_si256(_mm256_and_si256(quantize8_8_epi32(vec_w0), vec_low_mask),
+                                              _mm256_slli_epi32(quantize8_8_epi32(vec_w1), 16));
+            _mm256_store_si256((__m256i*)&row_q8_8[16* r], vec_pair);
+        }
+    }
+}
+
+void softmax_sgd_q8_8_inplace(float* neg_coeff, float* w_fp, int16_t* w_q8_8, float* x_fp, size_t class_stride, size_t size){
+    size_t k= 0;
+    for(; k + 8* SOFTMAX_BLOCK <= class_stride; k += 8* SOFTMAX_BLOCK){
+        softmax_sgd_q8_8_block<SOFTMAX_BLOCK>(&neg_coeff[k], &w_fp[k], &w_q8_8[2* k], x_fp, class_stride, size);
+    }
+
+    switch((class_stride - k)/ 8){
+        case 3: softmax_sgd_q8_8_block<3>(&neg_coeff[k], &w_fp[k], &w_q8_8[2* k], x_fp, class_stride, size); break;
+        case 2: softmax_sgd_q8_8_block<2>(&neg_coeff[k], &w_fp[k], &w_q8_8[2* k], x_fp, class_stride, size); break;
+        case 1: softmax_sgd_q8_8_block<1>(&neg_coeff[k], &w_fp[k], &w_q8_8[2* k], x_fp, class_stride, size); break;
+        default: break;
+    }
+}
+
+static inline int8_t quantize_int8_scalar(float v, float inv_scale){
+    return static_cast<int8_t>(clamp(std::nearbyint(v* inv_scale), -127.0f, 127.0f));
+}
+
+static inline float absmax_ps(__m256 v){
+    __m128 max_128= _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    max_128= _mm_max_ps(max_128, _mm_movehl_ps(max_128, max_128));
+    max_128= _mm_max_ss(max_128, _mm_shuffle_ps(max_128, max_128, 1));
+    return _mm_cvtss_f32(max_128);
+}
+
+float absmax_scale_int8(float* v, size_t size){
+    const __m256 vec_abs_mask= _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    __m256 vec1_max= _mm256_setzero_ps();
+    __m256 vec2_max= _mm256_setzero_ps();
+
+    size_t i= 0;
+    for(; i + 16 <= size; i += 16){
+        vec1_max= _mm256_max_ps(vec1_max, _mm256_and_ps(_mm256_loadu_ps(&v[i]), vec_abs_mask));
+        vec2_max= _mm256_max_ps(vec2_max, _mm256_and_ps(_mm256_loadu_ps(&v[i+ 8]), vec_abs_mask));
+    }
+
+    float max_fp= absmax_ps(_mm256_max_ps(vec1_max, vec2_max));
+    for(; i < size; i++){
+        max_fp= std::fmaxf(max_fp, std::fabs(v[i]));
+    }
+    //floor keeps 1/scale finite for all-zero inputs (which then quantize to 0) without inflating calibration maxima
+    return std::fmaxf(max_fp, 1e-30f)/ INT8_MAXQ;
+}
+
+//Four float vectors to 32 int8 in element order, saturated to the symmetric range [-127, 127]
+static inline __m256i pack_int8(__m256 a, __m256 b, __m256 c, __m256 d, __m256 inv_scale){
+    __m256i ab= _mm256_packs_epi32(_mm256_cvtps_epi32(_mm256_mul_ps(a, inv_scale)), _mm256_cvtps_epi32(_mm256_mul_ps(b, inv_scale)));
+    __m256i cd= _mm256_packs_epi32(_mm256_cvtps_epi32(_mm256_mul_ps(c, inv_scale)), _mm256_cvtps_epi32(_mm256_mul_ps(d, inv_scale)));
+    __m256i abcd= _mm256_permutevar8x32_epi32(_mm256_packs_epi16(ab, cd), _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+    return _mm256_max_epi8(abcd, _mm256_set1_epi8(-127));
+}
+
+void quantize_int8(float* v, int8_t* q, size_t size, float scale){
+    float inv_scale= 1.0f/ scale;
+    __m256 vec_inv_scale= _mm256_set1_ps(inv_scale);
+
+    size_t i= 0;
+    for(; i + 32 <= size; i += 32){
+        _mm_prefetch(reinterpret_cast<const char*>(&v[i+ 64]), _MM_HINT_T0);
+        __m256i vec_q= pack_int8(_mm256_loadu_ps(&v[i]), _mm256_loadu_ps(&v[i+ 8]), _mm256_loadu_ps(&v[i+ 16]), _mm256_loadu_ps(&v[i+ 24]), vec_inv_scale);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&q[i]), vec_q);
+    }
+
+    for(; i < size; i++){
+        q[i]= quantize_int8_scalar(v[i], inv_scale);
+    }
+}
+
+//maddubs needs an unsigned operand: |x| * (w with x's sign) keeps the signed product, 2 * 127 * 127 fits int16
+static inline __m256i dot_int8_epi32(__m256i w, __m256i x){
+    __m256i prod_16= _mm256_maddubs_epi16(_mm256_abs_epi8(x), _mm256_sign_epi8(w, x));
+    return _mm256_madd_epi16(prod_16, _mm256_set1_epi16(1));
+}
+
+int32_t dotproduct_int8(int8_t* w_int8, int8_t* x_int8, size_t size){
+    __m256i vec_sum= _mm256_setzero_si256();
+    size_t i= 0;
+    for(; i + 64 <= size; i += 64){
+        _mm_prefetch(reinterpret_cast<const char*>(&w_int8[i+ 128]), _MM_HINT_T0);
+        _mm_prefetch(reinterpret_cast<const char*>(&x_int8[i+ 128]), _MM_HINT_T0);
+
+        __m256i dot1= dot_int8_epi32(_mm256_loadu_si256((__m256i*)&w_int8[i]), _mm256_loadu_si256((__m256i*)&x_int8[i]));
+        __m256i dot2= dot_int8_epi32(_mm256_loadu_si256((__m256i*)&w_int8[i+ 32]), _mm256_loadu_si256((__m256i*)&x_int8[i+ 32]));
+        vec_sum= _mm256_add_epi32(vec_sum, _mm256_add_epi32(dot1, dot2));
+    }
+
+    for(; i + 32 <= size; i += 32){
+        vec_sum= _mm256_add_epi32(vec_sum, dot_int8_epi32(_mm256_loadu_si256((__m256i*)&w_int8[i]), _mm256_loadu_si256((__m256i*)&x_int8[i])));
+    }
+
+    int32_t sum= hsum_epi32(vec_sum);
+    for(; i < size; i++){
+        sum += w_int8[i] * x_int8[i];
+    }
+    return sum;
+}
+
+void absmax_scales_int8_blocked(float* v, float* scales, size_t size){
+    for(size_t i= 0, b= 0; i < size; i += INT8_BLOCK, b++){
+        scales[b]= absmax_scale_int8(&v[i], std::min<size_t>(INT8_BLOCK, size - i));
+    }
+}
+
+void quantize_int8_blocked(float* v, int8_t* q, float* scales, size_t size){
+    size_t i= 0, b= 0;
+    for(; i + INT8_BLOCK <= size; i += INT8_BLOCK, b++){
+        __m256 vec_inv_scale= _mm256_set1_ps(1.0f/ scales[b]);
+        __m256i vec_q= pack_int8(_mm256_loadu_ps(&v[i]), _mm256_loadu_ps(&v[i+ 8]), _mm256_loadu_ps(&v[i+ 16]), _mm256_loadu_ps(&v[i+ 24]), vec_inv_scale);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&q[i]), vec_q);
+    }
+
+    if(i < size){
+        float inv_scale= 1.0f/ scales[b];
+        for(; i < size; i++){
+            q[i]= quantize_int8_scalar(v[i], inv_scale);
+        }
+    }
+}
+
+float dotproduct_int8_blocked(int8_t* w_int8, float* w_scales, int8_t* x_int8, float* x_scales, size_t size){
+    __m256 vec_sum_fp= _mm256_setzero_ps();
+    size_t i= 0, b= 0;
+    for(; i + INT8_BLOCK <= size; i += INT8_BLOCK, b++){
+        _mm_prefetch(reinterpret_cast<const char*>(&w_int8[i+ 128]), _MM_HINT_T0);
+        __m256i dot= dot_int8_epi32(_mm256_loadu_si256((__m256i*)&w_int8[i]), _mm256_loadu_si256((__m256i*)&x_int8[i]));
+        __m256 vec_scale= _mm256_set1_ps(w_scales[b]* x_scales[b]);
+        vec_sum_fp= _mm256_fmadd_ps(_mm256_cvtepi32_ps(dot), vec_scale, vec_sum_fp);
+    }
+
+    float sum_fp= hsum_ps(vec_sum_fp);
+    if(i < size){
+        int32_t tail= 0;
+        for(; i < size; i++){
+            tail += w_int8[i] * x_int8[i];
+        }
+        sum_fp += tail* w_scales[b]* x_scales[b];
+    }
+    return sum_fp;
+}
+
+//Same quantization as quantize8_8_inplace, consumed in-register instead of stored
+int32_t dotproduct_q8_8_quantize(int16_t* w_q8_8, float* x_fp, size_t size){
+    __m256i vec_sum_q16_16= _mm256_setzero_si256();
+    size_t i= 0;
+    for(; i + 16 <= size; i += 16){
+        _mm_prefetch(reinterpret_cast<const char*>(&x_fp[i + 64]), _MM_HINT_T0);
+
+        __m256i vec1_x_pi= quantize8_8_epi32(_mm256_load_ps(&x_fp[i]));
+        __m256i vec2_x_pi= quantize8_8_epi32(_mm256_load_ps(&x_fp[i + 8]));
+        __m256i vec_x_q8_8= _mm256_permute4x64_epi64(_mm256_packs_epi32(vec1_x_pi, vec2_x_pi), 0xD8);
+        __m256i vec_w_q8_8= _mm256_load_si256((__m256i*)&w_q8_8[i]);
+
+        vec_sum_q16_16= _mm256_add_epi32(vec_sum_q16_16, _mm256_madd_epi16(vec_w_q8_8, vec_x_q8_8));
+    }
+
+    int32_t sum_q16_16= hsum_epi32(vec_sum_q16_16);
+    for(; i < size; i++){
+        sum_q16_16+= w_q8_8[i]* avx_float_to_q8_8(clamp(x_fp[i], MINQ, MAXQ));
+    }
+    return sum_q16_16;
 }
 
+//sgd_inplace followed by quantize8_8_inplace, in one pass over w
+//Blocks where x is all zero keep both copies as they are, so neither is read nor written
+void sgd_q8_8_inplace(int16_t y_hat, float y, float* w_fp, int16_t* w_q8_8, float* x_fp, size_t size, float lr){
+    const __m256i vec_abs_mask= _mm256_set1_epi32(0x7FFFFFFF);
+    float neg_coeff= lr*(y- q8_8_to_float(y_hat));
+    __m256 vec_neg_coeff= _mm256_broadcast_ss(&neg_coeff);
+
+    size_t i= 0;
+    for (; i + 16 <= size; i += 16){
+        _mm_prefetch(reinterpret_cast<const char*>(&x_fp[i + 32]), _MM_HINT_T0);
+        _mm_prefetch(reinterpret_cast<const char*>(&w_fp[i + 32]), _MM_HINT_T0);
+
+        __m256 vec1_x_fp= _mm256_load_ps(&x_fp[i]);
+        __m256 vec2_x_fp= _mm256_load_ps(&x_fp[i + 8]);
+        if (_mm256_testz_si256(_mm256_castps_si256(_mm256_or_ps(vec1_x_fp, vec2_x_fp)), vec_abs_mask)){
+            continue;
+        }
+
+        __m256 vec1_w_fp= _mm256_fmadd_ps(vec_neg_coeff, vec1_x_fp, _mm256_load_ps(&w_fp[i]));
+        __m256 vec2_w_fp= _mm256_fmadd_ps(vec_neg_coeff, vec2_x_fp, _mm256_load_ps(&w_fp[i + 8]));
+        _mm256_store_ps(&w_fp[i], vec1_w_fp);
+        _mm256_store_ps(&w_fp[i + 8], vec2_w_fp);
+
+        __m256i vec_w_q8_8= _mm256_packs_epi32(quantize8_8_epi32(vec1_w_fp), quantize8_8_epi32(vec2_w_fp));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(&w_q8_8[i]), _mm256_permute4x64_epi64(vec_w_q8_8, 0xD8));
+    }
+
+    for (; i < size; i++){
+        float w= w_fp[i] + neg_coeff*x_fp[i];
+        w_fp[i]= w;
+        w_q8_8[i]= avx_float_to_q8_8(clamp(w, MINQ, MAXQ));
+    }
+}
+
+//min_ps returns its second operand on NaN, so x goes first and a NaN logit lands on +range like the scalar
+//fminf clamp, instead of reaching cvttps as INT_MIN and gathering outside the table
+template <size_t range, size_t steps>
+static inline __m256 sigmoid_interp_ps(const float* lut, __m256 x){
+    const __m256 vec_range= _mm256_set1_ps(static_cast<float>(range));
+    x= _mm256_max_ps(_mm256_sub_ps(_mm256_setzero_ps(), vec_range), _mm256_min_ps(x, vec_range));
+    __m256 t= _mm256_mul_ps(_mm256_add_ps(x, vec_range), _mm256_set1_ps(static_cast<float>(steps)));
+    __m256i idx= _mm256_cvttps_epi32(t);
+    __m256 frac= _mm256_sub_ps(t, _mm256_cvtepi32_ps(idx));
+
+    __m256 lo= _mm256_i32gather_ps(lut, idx, 4);
+    __m256 hi= _mm256_i32gather_ps(lut + 1, idx, 4);
+    return _mm256_fmadd_ps(frac, _mm256_sub_ps(hi, lo), lo);
+}
+
+template <size_t range, size_t steps, size_t N>
+static void sigmoid_batch_lut(const std::array<float, N>& lut, float* logits, float* out, size_t size){
+    size_t i= 0;
+    for (; i + 16 <= size; i+= 16){
+        __m256 vec1= sigmoid_interp_ps<range, steps>(lut.data(), _mm256_loadu_ps(&logits[i]));
+        __m256 vec2= sigmoid_interp_ps<range, steps>(lut.data(), _mm256_loadu_ps(&logits[i + 8]));
+        _mm256_storeu_ps(&out[i], vec1);
+        _mm256_storeu_ps(&out[i + 8], vec2);
+    }
+
+    for (; i < size; i++){
+        out[i]= sigmoidInterp<range, steps>(lut, logits[i]);
+    }
+}
+
+void sigmoid_batch_fp(float* logits, float* out, size_t size, SigmoidPrecision precision){
+    if (precision == SigmoidPrecision::Q8_8){
+        sigmoid_batch_lut<SIGMOID_LUT_Q8_8_RANGE, SIGMOID_LUT_Q8_8_STEPS>(SIGMOID_LUT_Q8_8, logits, out, size);
+    }
+    else{
+        sigmoid_batch_lut<SIGMOID_LUT_FP32_RANGE, SIGMOID_LUT_FP32_STEPS>(SIGMOID_LUT_FP32, logits, out, size);
+    }
+}
+
+void sigmoid_batch_q16_16_to_q8_8(int32_t* logits, int16_t* out, size_t size){
+    const __m256 vec_q16_16_scale= _mm256_set1_ps(1.0f/ 65536.0f);
+
+    size_t i= 0;
+    for (; i + 16 <= size; i+= 16){
+        __m256 vec1_x= _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<__m256i*>(&logits[i]))), vec_q16_16_scale);
+        __m256 vec2_x= _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<__m256i*>(&logits[i + 8]))), vec_q16_16_scale);
+        __m256 vec1_p= sigmoid_interp_ps<SIGMOID_LUT_Q8_8_RANGE, SIGMOID_LUT_Q8_8_STEPS>(SIGMOID_LUT_Q8_8.data(), vec1_x);
+        __m256 vec2_p= sigmoid_interp_ps<SIGMOID_LUT_Q8_8_RANGE, SIGMOID_LUT_Q8_8_STEPS>(SIGMOID_LUT_Q8_8.data(), vec2_x);
+
+        //truncating after + 0.5 like float_to_q8_8, p is never negative
+        __m256i vec1_pi= _mm256_cvttps_epi32(_mm256_fmadd_ps(vec1_p, MM256_SCALE, MM256_ROUND));
+        __m256i vec2_pi= _mm256_cvttps_epi32(_mm256_fmadd_ps(vec2_p, MM256_SCALE, MM256_ROUND));
+        __m256i vec_q8_8= _mm256_permute4x64_epi64(_mm256_packs_epi32(vec1_pi, vec2_pi), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&out[i]), vec_q8_8);
+    }
+
+    for (; i < size; i++){
+        out[i]= sigmoidInterp_q16_16_to_q8_8(logits[i]);
+    }
+}
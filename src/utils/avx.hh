@@ -1,14 +1,94 @@
 #pragma once
 #include <immintrin.h>
 #include "containers.hh"
+#include "tools.hh"
+
+constexpr size_t INT8_BLOCK= 32;
 
 //Use when size%32 != 0 for the best preformance
 void quantize8_8_inplace(float* v, int16_t* q, size_t size);
 
 int32_t dotproduct_q8_8(int16_t* w_q8_8, int16_t* x_q8_8, size_t size);
 
+//Exact Q16.16 sum for any values and size, partial sums are widened to int64 every Q8_8_WIDE_BLOCK elements
+int64_t dotproduct_q8_8_wide(int16_t* w_q8_8, int16_t* x_q8_8, size_t size);
+
+//Quantizes x on the fly, bit-identical to quantize8_8_inplace followed by dotproduct_q8_8
+int32_t dotproduct_q8_8_quantize(int16_t* w_q8_8, float* x_fp, size_t size);
+
 float dotproduct_fp(float* w_fp, float* x_fp, size_t size);
 
 void sgd_inplace(int16_t y_hat, float y, float* w_fp, float* x_fp, size_t size, float lr);
 
-void adamW_inplace(int16_t y_hat, float y, float* w_fp, float* x_fp, size_t size, AdamWParams& parmas);
\ No newline at end of file
+//sgd_inplace that also refreshes w_q8_8, bit-identical to sgd_inplace + quantize8_8_inplace
+//when w_q8_8 was up to date: 16-element blocks where x is all zero are neither read nor written
+void sgd_q8_8_inplace(int16_t y_hat, float y, float* w_fp, int16_t* w_q8_8, float* x_fp, size_t size, float lr);
+
+//x is batch_size row-major samples of length size, w_q8_8 is refreshed in the same pass
+void sgd_batch_inplace(float* y_hat, float* y, float* w_fp, int16_t* w_q8_8, float* x_fp, size_t batch_size, size_t size, float lr);
+
+void adamW_inplace(int16_t y_hat, float y, float* w_fp, float* x_fp, size_t size, AdamWParams& parmas);
+
+//x is batch_size row-major samples of length size, rows need not be aligned
+void dotproduct_fp_batch(float* w_fp, float* x_fp, float* out, size_t batch_size, size_t size);
+
+//Quantizes row-major float rows (any alignment) into q rows of stride elements, stride%16 == 0
+void quantize8_8_rows(float* v, int16_t* q, size_t batch_size, size_t size, size_t stride);
+
+//x rows must come from quantize8_8_rows with the same stride
+void dotproduct_q8_8_batch(int16_t* w_q8_8, int16_t* x_q8_8, int32_t* out, size_t batch_size, size_t size, size_t stride);
+
+//Interpolated sigmoid, 16 logits per step through two gathers on the SigmoidPrecision table, any alignment
+//Matches sigmoidInterp_fp up to the rounding of one fma, out may alias logits
+void sigmoid_batch_fp(float* logits, float* out, size_t size, SigmoidPrecision precision= SigmoidPrecision::FP32);
+
+//Q16.16 logits (e.g. from dotproduct_q8_8_batch) to Q8.8 probabilities on the Q8_8 table, all 16 fractional bits are used
+void sigmoid_batch_q16_16_to_q8_8(int32_t* logits, int16_t* out, size_t size);
+
+//Sparse kernels gather the weights at indices, O(nnz) instead of O(size)
+float dotproduct_sparse_fp(float* w_fp, int32_t* indices, float* values, size_t nnz);
+
+//Quantizes values on the fly, w_q8_8 must have one readable element past the last feature
+int32_t dotproduct_sparse_q8_8(int16_t* w_q8_8, int32_t* indices, float* values, size_t nnz);
+
+void dotproduct_sparse_fp_batch(float* w_fp, size_t* row_offsets, int32_t* indices, float* values, float* out, size_t batch_size);
+
+void dotproduct_sparse_q8_8_batch(int16_t* w_q8_8, size_t* row_offsets, int32_t* indices, float* values, int32_t* out, size_t batch_size);
+
+//Indices must be unique, w_q8_8 is refreshed only at the touched indices
+void sgd_sparse_inplace(int16_t y_hat, float y, float* w_fp, int16_t* w_q8_8, int32_t* indices, float* values, size_t nnz, float lr);
+
+//Hashes count ids into [0, size) indices and signed values (see hash_feature_id), values null means every value is 1
+//Indices are not deduplicated
+void hash_features(const uint64_t* ids, const float* values, size_t count, uint64_t seed, uint32_t size, int32_t* indices, float* out_values);
+
+//Softmax weights are feature-major: w_fp[f * class_stride + k], class_stride%8 == 0
+void softmax_logits_fp(float* w_fp, float* x_fp, float* logits, size_t class_stride, size_t size);
+
+//w_q8_8 interleaves feature pairs per class: w_q8_8[2p * class_stride + 2k + (f&1)], x_q8_8 is zero padded to an even size
+void softmax_logits_q8_8(int16_t* w_q8_8, int16_t* x_q8_8, int32_t* logits, size_t class_stride, size_t size);
+
+//Padding classes in [num_classes, class_stride) come out as 0
+void softmax_inplace(float* logits, size_t num_classes, size_t class_stride);
+
+//neg_coeff[k]= lr * (y_k - p_k), zero for padding classes
+void softmax_sgd_inplace(float* neg_coeff, float* w_fp, float* x_fp, size_t class_stride, size_t size);
+
+//w_fp must hold an even number of feature rows
+void softmax_sgd_q8_8_inplace(float* neg_coeff, float* w_fp, int16_t* w_q8_8, float* x_fp, size_t class_stride, size_t size);
+
+//Symmetric INT8: q= round(v / scale) in [-127, 127], real value ~ q * scale
+//absmax_scale_int8 returns max|v| / 127
+float absmax_scale_int8(float* v, size_t size);
+
+void quantize_int8(float* v, int8_t* q, size_t size, float scale);
+
+//Exact for size < ~1M, multiply by both tensors' scales to get back to real units
+int32_t dotproduct_int8(int8_t* w_int8, int8_t* x_int8, size_t size);
+
+//Per-block variants, one scale per INT8_BLOCK elements (the last block may be partial)
+void absmax_scales_int8_blocked(float* v, float* scales, size_t size);
+
+void quantize_int8_blocked(float* v, int8_t* q, float* scales, size_t size);
+
+float dotproduct_int8_blocked(int8_t* w_int8, float* w_scales, int8_t* x_int8, float* x_scales, size_t size);
\ No newline at end of file
@@ -0,0 +1,233 @@
+#include "tools.hh"
+#include "avx512.hh"
+
+//Tails use masked loads/stores instead of scalar loops
+static inline __mmask16 tail_mask16(size_t remaining){
+    return static_cast<__mmask16>((1u << remaining) - 1);
+}
+
+static inline __mmask32 tail_mask32(size_t remaining){
+    return static_cast<__mmask32>((1ull << remaining) - 1);
+}
+
+//Unmasked forms of these ops pass an _mm512_undefined_* source that GCC 12 flags as
+//maybe-uninitialized, zero-masked forms with a full mask emit the same instructions
+static constexpr __mmask16 FULL_MASK16= 0xFFFF;
+static constexpr __mmask8 FULL_MASK8= 0xFF;
+
+static inline __m256i lower_si256(__m512i v){
+    return _mm512_maskz_extracti64x4_epi64(0xF, v, 0);
+}
+
+static inline __m256i upper_si256(__m512i v){
+    return _mm512_maskz_extracti64x4_epi64(0xF, v, 1);
+}
+
+static inline int32_t reduce_add_epi32_avx512(__m512i v){
+    return hsum_epi32(_mm256_add_epi32(lower_si256(v), upper_si256(v)));
+}
+
+static inline int64_t reduce_add_epi64_avx512(__m512i v){
+    __m256i sum= _mm256_add_epi64(lower_si256(v), upper_si256(v));
+    __m128i sum128= _mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    return _mm_cvtsi128_si64(sum128) + _mm_extract_epi64(sum128, 1);
+}
+
+static inline float reduce_add_ps_avx512(__m512 v){
+    __m512i vi= _mm512_castps_si512(v);
+    __m256 sum= _mm256_add_ps(_mm256_castsi256_ps(lower_si256(vi)), _mm256_castsi256_ps(upper_si256(vi)));
+    __m128 sum128= _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+    sum128= _mm_add_ps(sum128, _mm_movehl_ps(sum128, sum128));
+    return _mm_cvtss_f32(_mm_add_ss(sum128, _mm_movehdup_ps(sum128)));
+}
+
+static inline __m512i quantize8_8_epi32_avx512(__m512 v){
+    v= _mm512_maskz_max_ps(FULL_MASK16, _mm512_set1_ps(MINQ), _mm512_maskz_min_ps(FULL_MASK16, _mm512_set1_ps(MAXQ), v));
+    return _mm512_maskz_cvtps_epi32(FULL_MASK16, _mm512_fmadd_ps(v, _mm512_set1_ps(SCALE_FACTOR), _mm512_set1_ps(ROUND_FACTOR)));
+}
+
+static inline __m256i cvtsepi32_epi16_avx512(__m512i v){
+    return _mm512_maskz_cvtsepi32_epi16(FULL_MASK16, v);
+}
+
+void quantize8_8_inplace_avx512(float* v, int16_t* q, size_t size){
+    size_t i= 0;
+    for(; i + 32 <= size; i+= 32){
+        _mm_prefetch(reinterpret_cast<const char*>(&v[i+ 128]), _MM_HINT_T0);
+        __m512i vec1_pi= quantize8_8_epi32_avx512(_mm512_loadu_ps(&v[i]));
+        __m512i vec2_pi= quantize8_8_epi32_avx512(_mm512_loadu_ps(&v[i + 16]));
+
+        //cvtsepi32 narrows in element order, no lane fix-up needed
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&q[i]), cvtsepi32_epi16_avx512(vec1_pi));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&q[i + 16]), cvtsepi32_epi16_avx512(vec2_pi));
+    }
+
+    //one more 16-wide step so the vector/scalar split matches the AVX2 kernel
+    if(i + 16 <= size){
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&q[i]), cvtsepi32_epi16_avx512(quantize8_8_epi32_avx512(_mm512_loadu_ps(&v[i]))));
+        i+= 16;
+    }
+
+    for (; i < size; i++) {
+        float val= v[i];
+        q[i]= avx_float_to_q8_8(clamp(val, MINQ, MAXQ));
+    }
+}
+
+int32_t dotproduct_q8_8_avx512(int16_t* w_q8_8, int16_t* x_q8_8, size_t size){
+    __m512i vec_sum_q16_16= _mm512_setzero_si512();
+    size_t i= 0;
+    for(; i + 64 <= size; i += 64){
+        _mm_prefetch(reinterpret_cast<const char*>(&w_q8_8[i+ 128]), _MM_HINT_T0);
+        _mm_prefetch(reinterpret_cast<const char*>(&x_q8_8[i+ 128]), _MM_HINT_T0);
+
+        __m512i dot1= _mm512_madd_epi16(_mm512_loadu_si512(&w_q8_8[i]), _mm512_loadu_si512(&x_q8_8[i]));
+        __m512i dot2= _mm512_madd_epi16(_mm512_loadu_si512(&w_q8_8[i+ 32]), _mm512_loadu_si512(&x_q8_8[i+ 32]));
+
+        vec_sum_q16_16= _mm512_add_epi32(vec_sum_q16_16, _mm512_add_epi32(dot1, dot2));
+    }
+
+    for(; i < size; i += 32){
+        __mmask32 mask= tail_mask32(std::min<size_t>(32, size - i));
+        __m512i dot= _mm512_madd_epi16(_mm512_maskz_loadu_epi16(mask, &w_q8_8[i]), _mm512_maskz_loadu_epi16(mask, &x_q8_8[i]));
+        vec_sum_q16_16= _mm512_add_epi32(vec_sum_q16_16, dot);
+    }
+
+    return reduce_add_epi32_avx512(vec_sum_q16_16);
+}
+
+//Same hi/lo split as the AVX2 kernel, masked-off lanes contribute madd 0 and are counted like any other lane
+static inline void accumulate_wide_avx512(__m512i r, __m512i& vec_hi, __m512i& vec_lo){
+    r= _mm512_add_epi32(r, _mm512_set1_epi32(-1));
+    vec_hi= _mm512_add_epi32(vec_hi, _mm512_maskz_srai_epi32(FULL_MASK16, r, 16));
+    vec_lo= _mm512_add_epi32(vec_lo, _mm512_and_si512(r, _mm512_set1_epi32(0xFFFF)));
+}
+
+int64_t dotproduct_q8_8_wide_avx512(int16_t* w_q8_8, int16_t* x_q8_8, size_t size){
+    int64_t sum_q16_16= 0;
+    size_t i= 0;
+    while (i < size){
+        size_t block_end= std::min(size, i + Q8_8_WIDE_BLOCK);
+        size_t lanes= 0;
+        __m512i vec_hi= _mm512_setzero_si512();
+        __m512i vec_lo= _mm512_setzero_si512();
+
+        for (; i + 64 <= block_end; i += 64){
+            _mm_prefetch(reinterpret_cast<const char*>(&w_q8_8[i+ 128]), _MM_HINT_T0);
+            _mm_prefetch(reinterpret_cast<const char*>(&x_q8_8[i+ 128]), _MM_HINT_T0);
+
+            accumulate_wide_avx512(_mm512_madd_epi16(_mm512_loadu_si512(&w_q8_8[i]), _mm512_loadu_si512(&x_q8_8[i])), vec_hi, vec_lo);
+            accumulate_wide_avx512(_mm512_madd_epi16(_mm512_loadu_si512(&w_q8_8[i+ 32]), _mm512_loadu_si512(&x_q8_8[i+ 32])), vec_hi, vec_lo);
+            lanes+= 32;
+        }
+
+        for (; i < block_end; i += 32){
+            __mmask32 mask= tail_mask32(std::min<size_t>(32, block_end - i));
+            accumulate_wide_avx512(_mm512_madd_epi16(_mm512_maskz_loadu_epi16(mask, &w_q8_8[i]), _mm512_maskz_loadu_epi16(mask, &x_q8_8[i])), vec_hi, vec_lo);
+            lanes+= 16;
+        }
+        i= block_end;
+
+        //hi and lo sums of 16 lanes fit int64 directly
+        sum_q16_16+= reduce_add_epi64_avx512(_mm512_maskz_cvtepi32_epi64(FULL_MASK8, lower_si256(vec_hi)))* 65536
+            + reduce_add_epi64_avx512(_mm512_maskz_cvtepi32_epi64(FULL_MASK8, upper_si256(vec_hi)))* 65536
+            + reduce_add_epi64_avx512(_mm512_maskz_cvtepi32_epi64(FULL_MASK8, lower_si256(vec_lo)))
+            + reduce_add_epi64_avx512(_mm512_maskz_cvtepi32_epi64(FULL_MASK8, upper_si256(vec_lo)))
+            + static_cast<int64_t>(lanes);
+    }
+
+    return sum_q16_16;
+}
+
+float dotproduct_fp_avx512(float* w_fp, float* x_fp, size_t size){
+    __m512 vec1_sum_fp= _mm512_setzero_ps();
+    __m512 vec2_sum_fp= _mm512_setzero_ps();
+    size_t i= 0;
+    for(; i + 32 <= size; i += 32){
+        _mm_prefetch(reinterpret_cast<const char*>(&w_fp[i+ 64]), _MM_HINT_T0);
+        _mm_prefetch(reinterpret_cast<const char*>(&x_fp[i+ 64]), _MM_HINT_T0);
+
+        vec1_sum_fp= _mm512_fmadd_ps(_mm512_loadu_ps(&w_fp[i]), _mm512_loadu_ps(&x_fp[i]), vec1_sum_fp);
+        vec2_sum_fp= _mm512_fmadd_ps(_mm512_loadu_ps(&w_fp[i+ 16]), _mm512_loadu_ps(&x_fp[i+ 16]), vec2_sum_fp);
+    }
+
+    for(; i < size; i += 16){
+        __mmask16 mask= tail_mask16(std::min<size_t>(16, size - i));
+        vec1_sum_fp= _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, &w_fp[i]), _mm512_maskz_loadu_ps(mask, &x_fp[i]), vec1_sum_fp);
+    }
+
+    return reduce_add_ps_avx512(_mm512_add_ps(vec1_sum_fp, vec2_sum_fp));
+}
+
+void sgd_inplace_avx512(int16_t y_hat, float y, float* w_fp, float* x_fp, size_t size, float lr){
+    float neg_coeff= lr*(y- q8_8_to_float(y_hat));
+    __m512 vec_neg_coeff= _mm512_set1_ps(neg_coeff);
+
+    size_t i= 0;
+    for (; i + 32 <= size; i += 32){
+        _mm_prefetch(reinterpret_cast<const char*>(&x_fp[i + 64]), _MM_HINT_T0);
+        _mm_prefetch(reinterpret_cast<const char*>(&w_fp[i + 64]), _MM_HINT_T0);
+
+        __m512 vec1_w_fp= _mm512_fmadd_ps(vec_neg_coeff, _mm512_loadu_ps(&x_fp[i]), _mm512_loadu_ps(&w_fp[i]));
+        __m512 vec2_w_fp= _mm512_fmadd_ps(vec_neg_coeff, _mm512_loadu_ps(&x_fp[i+ 16]), _mm512_loadu_ps(&w_fp[i+ 16]));
+
+        _mm512_storeu_ps(&w_fp[i], vec1_w_fp);
+        _mm512_storeu_ps(&w_fp[i + 16], vec2_w_fp);
+    }
+
+    for (; i < size; i += 16){
+        __mmask16 mask= tail_mask16(std::min<size_t>(16, size - i));
+        __m512 vec_w_fp= _mm512_fmadd_ps(vec_neg_coeff, _mm512_maskz_loadu_ps(mask, &x_fp[i]), _mm512_maskz_loadu_ps(mask, &w_fp[i]));
+        _mm512_mask_storeu_ps(&w_fp[i], mask, vec_w_fp);
+    }
+}
+
+//16 per step so the vector/scalar split of the Q8.8 refresh matches quantize8_8_inplace_avx512
+void sgd_q8_8_inplace_avx512(int16_t y_hat, float y, float* w_fp, int16_t* w_q8_8, float* x_fp, size_t size, float lr){
+    const __m512i vec_abs_mask= _mm512_set1_epi32(0x7FFFFFFF);
+    float neg_coeff= lr*(y- q8_8_to_float(y_hat));
+    __m512 vec_neg_coeff= _mm512_set1_ps(neg_coeff);
+
+    size_t i= 0;
+    for (; i + 16 <= size; i += 16){
+        _mm_prefetch(reinterpret_cast<const char*>(&x_fp[i + 64]), _MM_HINT_T0);
+        _mm_prefetch(reinterpret_cast<const char*>(&w_fp[i + 64]), _MM_HINT_T0);
+
+        __m512 vec_x_fp= _mm512_loadu_ps(&x_fp[i]);
+        if (!_mm512_test_epi32_mask(_mm512_castps_si512(vec_x_fp), vec_abs_mask)){
+            continue;
+        }
+
+        __m512 vec_w_fp= _mm512_fmadd_ps(vec_neg_coeff, vec_x_fp, _mm512_loadu_ps(&w_fp[i]));
+        _mm512_storeu_ps(&w_fp[i], vec_w_fp);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&w_q8_8[i]), cvtsepi32_epi16_avx512(quantize8_8_epi32_avx512(vec_w_fp)));
+    }
+
+    if (i < size){
+        __mmask16 mask= tail_mask16(size - i);
+        __m512 vec_w_fp= _mm512_fmadd_ps(vec_neg_coeff, _mm512_maskz_loadu_ps(mask, &x_fp[i]), _mm512_maskz_loadu_ps(mask, &w_fp[i]));
+        _mm512_mask_storeu_ps(&w_fp[i], mask, vec_w_fp);
+        for (; i < size; i++){
+            w_q8_8[i]= avx_float_to_q8_8(clamp(w_fp[i], MINQ, MAXQ));
+        }
+    }
+}
+
+//No sign_epi8 in AVX-512: negate w where x is negative with a byte mask instead
+int32_t dotproduct_int8_avx512(int8_t* w_int8, int8_t* x_int8, size_t size){
+    const __m512i vec_ones= _mm512_set1_epi16(1);
+    __m512i vec_sum= _mm512_setzero_si512();
+
+    size_t i= 0;
+    for(; i < size; i += 64){
+        __mmask64 mask= (size - i >= 64)? ~__mmask64(0): (__mmask64(1) << (size - i)) - 1;
+        __m512i x= _mm512_maskz_loadu_epi8(mask, &x_int8[i]);
+        __m512i w= _mm512_maskz_loadu_epi8(mask, &w_int8[i]);
+
+        __m512i w_signed= _mm512_mask_sub_epi8(w, _mm512_movepi8_mask(x), _mm512_setzero_si512(), w);
+        __m512i prod_16= _mm512_maddubs_epi16(_mm512_abs_epi8(x), w_signed);
+        vec_sum= _mm512_add_epi32(vec_sum, _mm512_madd_epi16(prod_16, vec_ones));
+    }
+
+    return reduce_add_epi32_avx512(vec_sum);
+}
@@ -0,0 +1,19 @@
+//AVX-512 (F + BW) variants of the core kernels, same contracts as avx.hh
+#pragma once
+#include <immintrin.h>
+#include <cstdint>
+#include <cstddef>
+
+void quantize8_8_inplace_avx512(float* v, int16_t* q, size_t size);
+
+int32_t dotproduct_q8_8_avx512(int16_t* w_q8_8, int16_t* x_q8_8, size_t size);
+
+int64_t dotproduct_q8_8_wide_avx512(int16_t* w_q8_8, int16_t* x_q8_8, size_t size);
+
+float dotproduct_fp_avx512(float* w_fp, float* x_fp, size_t size);
+
+void sgd_inplace_avx512(int16_t y_hat, float y, float* w_fp, float* x_fp, size_t size, float lr);
+
+void sgd_q8_8_inplace_avx512(int16_t y_hat, float y, float* w_fp, int16_t* w_q8_8, float* x_fp, size_t size, float lr);
+
+int32_t dotproduct_int8_avx512(int8_t* w_int8, int8_t* x_int8, size_t size);
\ No newline at end of file
@@ -1,50 +1,91 @@
 #pragma once
 
 #include <stdlib.h>
+#include <algorithm>
 #include <cstring>
 #include <stdexcept>
 #include <cassert>
 
+//Default alignment of alignedArray: one cache line, so 256/512-bit loads of a row never split across two lines
+constexpr size_t ARRAY_DEFAULT_ALIGNMENT= 64;
+
+//Where an alignedArray gets its memory, arrays without one use aligned_alloc/free (see allocators.hh)
+class ArrayAllocator{
+    public:
+        virtual ~ArrayAllocator()= default;
+        //bytes is a non-zero multiple of alignment, throws std::bad_alloc when out of memory
+        virtual void* allocate(size_t bytes, size_t alignment)= 0;
+        virtual void deallocate(void* ptr, size_t bytes)= 0;
+};
+
 template <typename T> 
 class alignedArray{
     private: 
         size_t size_m;
         T* ptr_m;
+        bool owner_m;
+        ArrayAllocator* allocator_m;
+        size_t bytes_m; //allocated bytes, size rounded up to the alignment
 
-    public:
-        explicit alignedArray(size_t size): size_m(size), ptr_m(nullptr){
-            ptr_m= static_cast<T*>(std::aligned_alloc(32, size*sizeof(T)));
-            if(!ptr_m){
-                throw std::bad_alloc();
+        alignedArray(T* ptr, size_t size, bool owner): size_m(size), ptr_m(ptr), owner_m(owner), allocator_m(nullptr), bytes_m(0){};
+
+        void release(){
+            if (!owner_m || !ptr_m){
+                return;
+            }
+            if (allocator_m){
+                allocator_m->deallocate(ptr_m, bytes_m);
+            }
+            else{
+                free(ptr_m);
             }
         }
-        
-        alignedArray(size_t alignment, size_t size): size_m(size), ptr_m(nullptr){
-            ptr_m= static_cast<T*>(std::aligned_alloc(alignment, size*sizeof(T)));
+
+    public:
+        explicit alignedArray(size_t size): alignedArray(ARRAY_DEFAULT_ALIGNMENT, size){}
+
+        //aligned_alloc wants a size that is a multiple of the alignment, empty arrays still get one aligned block
+        alignedArray(size_t alignment, size_t size, ArrayAllocator* allocator= nullptr):
+            size_m(size), ptr_m(nullptr), owner_m(true), allocator_m(allocator),
+            bytes_m(std::max<size_t>((size* sizeof(T) + alignment - 1)/ alignment* alignment, alignment)){
+            ptr_m= static_cast<T*>(allocator? allocator->allocate(bytes_m, alignment): std::aligned_alloc(alignment, bytes_m));
             if (!ptr_m){
                 throw std::bad_alloc();
             }
         }
 
-        alignedArray(): size_m(0), ptr_m(nullptr){};
+        alignedArray(): size_m(0), ptr_m(nullptr), owner_m(true), allocator_m(nullptr), bytes_m(0){};
+
+        //Non-owning view over memory someone else keeps alive (e.g. a mapped model file)
+        static alignedArray<T> view(T* ptr, size_t size){
+            return alignedArray<T>(ptr, size, false);
+        }
 
         alignedArray(const alignedArray&)= delete;
         alignedArray& operator=(const alignedArray&)= delete;
 
-        alignedArray(alignedArray&& other) noexcept: size_m(other.size_m), ptr_m(other.ptr_m){
+        alignedArray(alignedArray&& other) noexcept: size_m(other.size_m), ptr_m(other.ptr_m), owner_m(other.owner_m),
+            allocator_m(other.allocator_m), bytes_m(other.bytes_m){
             other.ptr_m= nullptr;
             other.size_m= 0;
+            other.owner_m= true;
+            other.allocator_m= nullptr;
+            other.bytes_m= 0;
         }
 
         alignedArray& operator=(alignedArray&& other) noexcept {
             if (this != &other){
-                if (ptr_m){
-                    free(ptr_m);
-                }
+                release();
                 ptr_m= other.ptr_m;
                 size_m= other.size_m;
+                owner_m= other.owner_m;
+                allocator_m= other.allocator_m;
+                bytes_m= other.bytes_m;
                 other.ptr_m= nullptr;
                 other.size_m= 0;
+                other.owner_m= true;
+                other.allocator_m= nullptr;
+                other.bytes_m= 0;
             }
             return *this;
         }
@@ -56,7 +97,12 @@ class alignedArray{
         }        
 
         ~alignedArray(){
-            free(ptr_m);
+            release();
+        }
+
+        //null when the memory comes from aligned_alloc
+        ArrayAllocator* allocator() const {
+            return allocator_m;
         }
 
         T* data() const {
@@ -79,6 +125,54 @@ class alignedArray{
 
 };
 
+//Index/value pairs of one sample, indices must be unique within a sample
+struct sparseArray{
+    alignedArray<int32_t> indices;
+    alignedArray<float> values;
+    size_t nnz;
+
+    explicit sparseArray(size_t capacity): indices(capacity), values(capacity), nnz(0){};
+
+    void push_back(int32_t index, float value){
+        assert(nnz < indices.size() && "Sparse capacity exceeded");
+        indices[nnz]= index;
+        values[nnz]= value;
+        nnz++;
+    }
+
+    void clear(){
+        nnz= 0;
+    }
+};
+
+//CSR batch: row n owns indices/values in [row_offsets[n], row_offsets[n + 1])
+struct sparseBatch{
+    alignedArray<size_t> row_offsets;
+    alignedArray<int32_t> indices;
+    alignedArray<float> values;
+    size_t rows;
+
+    sparseBatch(size_t max_rows, size_t capacity): row_offsets(max_rows + 1), indices(capacity), values(capacity), rows(0){
+        row_offsets[0]= 0;
+    };
+
+    size_t nnz() const {
+        return row_offsets[rows];
+    }
+
+    void push_row(const sparseArray& row){
+        assert(rows + 1 < row_offsets.size() && "Sparse batch rows exceeded");
+        size_t offset= row_offsets[rows];
+        assert(offset + row.nnz <= indices.size() && "Sparse capacity exceeded");
+        std::memcpy(indices.data() + offset, row.indices.data(), row.nnz* sizeof(int32_t));
+        std::memcpy(values.data() + offset, row.values.data(), row.nnz* sizeof(float));
+        row_offsets[++rows]= offset + row.nnz;
+    }
+
+    void clear(){
+        rows= 0;
+    }
+};
 
 struct AdamWParams{
     const float learning_rate;
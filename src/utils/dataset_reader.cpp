@@ -0,0 +1,245 @@
+#include "dataset_reader.hh"
+#include <charconv>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+DatasetReader::DatasetReader(const std::string& path, DatasetFormat format, size_t feature_size, size_t num_threads, size_t chunk_bytes):
+    format_m(format),
+    feature_size_m(feature_size),
+    row_stride_m((feature_size + 7) & ~size_t(7)),
+    chunk_bytes_m(std::max<size_t>(chunk_bytes, 4096)),
+    num_threads_m(std::max<size_t>(num_threads, 1)),
+    data_m(nullptr),
+    length_m(0),
+    num_chunks_m(0),
+    stop_m(false),
+    next_chunk_m(0),
+    current_m(nullptr),
+    skipped_rows_m(0),
+    dropped_features_m(0){
+    int fd= open(path.c_str(), O_RDONLY);
+    if (fd < 0){
+        throw std::runtime_error("Cannot open " + path);
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0){
+        close(fd);
+        throw std::runtime_error("Cannot stat " + path);
+    }
+    length_m= file_stat.st_size;
+
+    if (length_m > 0){
+        void* data= mmap(nullptr, length_m, PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED){
+            close(fd);
+            throw std::runtime_error("Cannot map " + path);
+        }
+        madvise(data, length_m, MADV_SEQUENTIAL);
+        data_m= static_cast<const char*>(data);
+    }
+    close(fd);
+    num_chunks_m= (length_m + chunk_bytes_m - 1)/ chunk_bytes_m;
+
+    //a chunk of n bytes holds at most n/2 + 1 rows, start at a typical size and grow on demand
+    slots_m.resize(2* num_threads_m);
+    for (datasetBatch& slot: slots_m){
+        slot.rows= 0;
+        slot.capacity= 0;
+        slot.chunk= SIZE_MAX;
+        reserveRows(slot, std::max<size_t>(64, chunk_bytes_m/ std::max<size_t>(8* feature_size_m, 64)));
+    }
+
+    for (size_t t= 0; t < num_threads_m; t++){
+        workers_m.emplace_back(&DatasetReader::worker, this, t);
+    }
+}
+
+DatasetReader::~DatasetReader(){
+    {
+        std::lock_guard<std::mutex> lock(mutex_m);
+        stop_m= true;
+    }
+    slot_freed_m.notify_all();
+    for (std::thread& worker: workers_m){
+        worker.join();
+    }
+    if (data_m){
+        munmap(const_cast<char*>(data_m), length_m);
+    }
+}
+
+size_t DatasetReader::rowStride() const{
+    return row_stride_m;
+}
+
+size_t DatasetReader::skippedRows() const{
+    return skipped_rows_m.load(std::memory_order_relaxed);
+}
+
+size_t DatasetReader::droppedFeatures() const{
+    return dropped_features_m.load(std::memory_order_relaxed);
+}
+
+//Only called by the slot's owner while the slot is free, so no lock is needed
+void DatasetReader::reserveRows(datasetBatch& batch, size_t rows){
+    if (rows <= batch.capacity){
+        return;
+    }
+    size_t capacity= std::max(rows, 2* batch.capacity);
+    alignedArray<float> inputs(32, capacity* row_stride_m);
+    alignedArray<float> labels(32, capacity);
+    if (batch.rows > 0){
+        std::memcpy(inputs.data(), batch.inputs.data(), batch.rows* row_stride_m* sizeof(float));
+        std::memcpy(labels.data(), batch.labels.data(), batch.rows* sizeof(float));
+    }
+    batch.inputs= std::move(inputs);
+    batch.labels= std::move(labels);
+    batch.capacity= capacity;
+}
+
+bool DatasetReader::parseLine(const char* begin, const char* end, float* row, float& label){
+    while (end > begin && (end[-1] == '\r' || end[-1] == ' ')){
+        end--;
+    }
+    if (begin == end){
+        return false;
+    }
+
+    const char* p= (*begin == '+')? begin + 1: begin; //from_chars rejects libsvm's "+1"
+    float value;
+    auto [label_end, label_error]= std::from_chars(p, end, value);
+    if (label_error != std::errc()){
+        return false;
+    }
+    label= value > 0.0f;
+    p= label_end;
+    std::memset(row, 0, row_stride_m* sizeof(float));
+
+    if (format_m == DatasetFormat::CSV){
+        size_t column= 0;
+        while (p < end){
+            if (*p != ','){
+                return false;
+            }
+            auto [value_end, value_error]= std::from_chars(p + 1, end, value);
+            if (value_error != std::errc()){
+                return false;
+            }
+            if (column < feature_size_m){
+                row[column]= value;
+            }
+            else{
+                dropped_features_m.fetch_add(1, std::memory_order_relaxed);
+            }
+            column++;
+            p= value_end;
+        }
+        return true;
+    }
+
+    while (p < end){
+        while (p < end && (*p == ' ' || *p == '\t')){
+            p++;
+        }
+        if (p == end || *p == '#'){
+            break;
+        }
+        size_t index;
+        auto [index_end, index_error]= std::from_chars(p, end, index);
+        if (index_error != std::errc() || index_end == end || *index_end != ':' || index == 0){
+            return false;
+        }
+        auto [value_end, value_error]= std::from_chars(index_end + 1, end, value);
+        if (value_error != std::errc()){
+            return false;
+        }
+        if (index <= feature_size_m){
+            row[index - 1]= value;
+        }
+        else{
+            dropped_features_m.fetch_add(1, std::memory_order_relaxed);
+        }
+        p= value_end;
+    }
+    return true;
+}
+
+//Chunk c covers the lines that start in [c * chunk_bytes, (c + 1) * chunk_bytes)
+void DatasetReader::parseChunk(size_t chunk, datasetBatch& batch){
+    const char* file_end= data_m + length_m;
+    auto lineStart= [&](size_t offset){
+        if (offset == 0){
+            return data_m;
+        }
+        if (offset >= length_m){
+            return file_end;
+        }
+        const char* newline= static_cast<const char*>(std::memchr(data_m + offset - 1, '\n', length_m - offset + 1));
+        return newline? newline + 1: file_end;
+    };
+
+    const char* p= lineStart(chunk* chunk_bytes_m);
+    const char* end= lineStart((chunk + 1)* chunk_bytes_m);
+    batch.rows= 0;
+    size_t skipped= 0;
+    while (p < end){
+        const char* newline= static_cast<const char*>(std::memchr(p, '\n', end - p));
+        const char* eol= newline? newline: end;
+        reserveRows(batch, batch.rows + 1);
+        if (parseLine(p, eol, &batch.inputs[batch.rows* row_stride_m], batch.labels[batch.rows])){
+            batch.rows++;
+        }
+        else{
+            skipped++;
+        }
+        p= eol + 1;
+    }
+    skipped_rows_m.fetch_add(skipped, std::memory_order_relaxed);
+}
+
+void DatasetReader::worker(size_t thread_id){
+    for (size_t chunk= thread_id; chunk < num_chunks_m; chunk+= num_threads_m){
+        datasetBatch& slot= slots_m[chunk % slots_m.size()];
+        {
+            std::unique_lock<std::mutex> lock(mutex_m);
+            slot_freed_m.wait(lock, [&]{ return stop_m || slot.chunk == SIZE_MAX; });
+            if (stop_m){
+                return;
+            }
+        }
+
+        parseChunk(chunk, slot);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_m);
+            slot.chunk= chunk;
+        }
+        slot_filled_m.notify_all();
+    }
+}
+
+const datasetBatch* DatasetReader::next(){
+    std::unique_lock<std::mutex> lock(mutex_m);
+    if (current_m){
+        current_m->chunk= SIZE_MAX;
+        current_m= nullptr;
+        slot_freed_m.notify_all();
+    }
+
+    //empty chunks (e.g. a single very long line spanning several chunks) are skipped
+    while (next_chunk_m < num_chunks_m){
+        datasetBatch& slot= slots_m[next_chunk_m % slots_m.size()];
+        slot_filled_m.wait(lock, [&]{ return slot.chunk == next_chunk_m; });
+        next_chunk_m++;
+        if (slot.rows > 0){
+            current_m= &slot;
+            return current_m;
+        }
+        slot.chunk= SIZE_MAX;
+        slot_freed_m.notify_all();
+    }
+    return nullptr;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include "containers.hh"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class DatasetFormat{
+    LibSVM, //label idx:value ..., 1-based indices
+    CSV     //label,x1,...,xN
+};
+
+//Parsed rows of one chunk of the file, dense and row-major with rowStride() floats per row (32-byte aligned rows)
+//Labels are 1 for positive values and 0 otherwise, so libsvm's -1/+1 and CSV's 0/1 both map to {0, 1}
+struct datasetBatch{
+    alignedArray<float> inputs;
+    alignedArray<float> labels;
+    size_t rows;
+    size_t capacity;
+    size_t chunk; //index of the chunk held, SIZE_MAX while the slot is free
+};
+
+//Streams a libsvm or CSV file through mmap: the file is cut into ~chunk_bytes pieces on line boundaries, worker t parses
+//chunks t, t + T, ... into its two slots while the caller consumes earlier chunks in file order
+class DatasetReader{
+    private:
+        const DatasetFormat format_m;
+        const size_t feature_size_m;
+        const size_t row_stride_m;
+        const size_t chunk_bytes_m;
+        const size_t num_threads_m;
+
+        const char* data_m;
+        size_t length_m;
+        size_t num_chunks_m;
+
+        std::vector<datasetBatch> slots_m; //2 per worker, chunk c lives in slot c % slots_m.size()
+        std::vector<std::thread> workers_m;
+        std::mutex mutex_m;
+        std::condition_variable slot_freed_m;
+        std::condition_variable slot_filled_m;
+        bool stop_m;
+
+        size_t next_chunk_m;
+        datasetBatch* current_m;
+
+        std::atomic<size_t> skipped_rows_m;
+        std::atomic<size_t> dropped_features_m;
+
+        void worker(size_t thread_id);
+        void parseChunk(size_t chunk, datasetBatch& batch);
+        bool parseLine(const char* begin, const char* end, float* row, float& label);
+        void reserveRows(datasetBatch& batch, size_t rows);
+
+    public:
+        DatasetReader(const std::string& path, DatasetFormat format, size_t feature_size, size_t num_threads= 4, size_t chunk_bytes= size_t(1) << 22);
+        ~DatasetReader();
+
+        DatasetReader(const DatasetReader&)= delete;
+        DatasetReader& operator=(const DatasetReader&)= delete;
+
+        //Blocks until the next chunk in file order is parsed, nullptr once the file is exhausted
+        //The batch stays valid until the following call, which hands its slot back to the parsers
+        const datasetBatch* next();
+
+        size_t rowStride() const;
+        size_t skippedRows() const;     //blank or malformed lines, e.g. a CSV header
+        size_t droppedFeatures() const; //indices or columns beyond feature_size
+};
@@ -0,0 +1,109 @@
+#include "dispatch.hh"
+#include "avx.hh"
+#include "avx512.hh"
+#include "sse.hh"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+static const KernelTable SSE42_KERNELS{
+    ISA::SSE42,
+    quantize8_8_inplace_sse42,
+    dotproduct_q8_8_sse42,
+    dotproduct_q8_8_wide_sse42,
+    dotproduct_fp_sse42,
+    sgd_inplace_sse42,
+    sgd_q8_8_inplace_sse42,
+    absmax_scale_int8_sse42,
+    quantize_int8_sse42,
+    dotproduct_int8_sse42
+};
+
+static const KernelTable AVX2_KERNELS{
+    ISA::AVX2,
+    quantize8_8_inplace,
+    dotproduct_q8_8,
+    dotproduct_q8_8_wide,
+    dotproduct_fp,
+    sgd_inplace,
+    sgd_q8_8_inplace,
+    absmax_scale_int8,
+    quantize_int8,
+    dotproduct_int8
+};
+
+static const KernelTable AVX512_KERNELS{
+    ISA::AVX512,
+    quantize8_8_inplace_avx512,
+    dotproduct_q8_8_avx512,
+    dotproduct_q8_8_wide_avx512,
+    dotproduct_fp_avx512,
+    sgd_inplace_avx512,
+    sgd_q8_8_inplace_avx512,
+    absmax_scale_int8, //memory bound, the AVX2 versions already saturate bandwidth
+    quantize_int8,
+    dotproduct_int8_avx512
+};
+
+ISA detectISA(){
+    __builtin_cpu_init();
+    //avx512.cpp is built with -mavx512vl too, so every flag it is compiled for has to be present
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl")){
+        return ISA::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")){
+        return ISA::AVX2;
+    }
+    return ISA::SSE42;
+}
+
+const char* isaName(ISA isa){
+    switch(isa){
+        case ISA::AVX512: return "avx512";
+        case ISA::AVX2: return "avx2";
+        default: return "sse4.2";
+    }
+}
+
+const KernelTable& kernelTable(ISA isa){
+    switch(isa){
+        case ISA::AVX512: return AVX512_KERNELS;
+        case ISA::AVX2: return AVX2_KERNELS;
+        default: return SSE42_KERNELS;
+    }
+}
+
+static ISA selectISA(){
+    ISA isa= detectISA();
+
+    const char* forced= std::getenv("AVX_LR_ISA");
+    if (!forced){
+        return isa;
+    }
+
+    for (ISA candidate: {ISA::SSE42, ISA::AVX2, ISA::AVX512}){
+        if (std::strcmp(forced, isaName(candidate)) == 0){
+            if (candidate > isa){
+                std::cerr << "AVX_LR_ISA=" << forced << " not supported, using " << isaName(isa) << std::endl;
+                return isa;
+            }
+            return candidate;
+        }
+    }
+
+    std::cerr << "AVX_LR_ISA=" << forced << " unknown, using " << isaName(isa) << std::endl;
+    return isa;
+}
+
+const KernelTable& kernels(){
+    static const KernelTable& selected= kernelTable(selectISA());
+    return selected;
+}
+
+void requireISA(ISA isa, const char* what){
+    if (kernels().isa < isa){
+        throw std::logic_error(std::string(what) + " requires " + isaName(isa) + ", selected " + isaName(kernels().isa));
+    }
+}
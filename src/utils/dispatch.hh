@@ -0,0 +1,36 @@
+//Runtime selection of the core kernels, resolved once from CPUID
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+enum class ISA{
+    SSE42= 0,
+    AVX2= 1,
+    AVX512= 2
+};
+
+struct KernelTable{
+    ISA isa;
+    void (*quantize8_8_inplace)(float* v, int16_t* q, size_t size);
+    int32_t (*dotproduct_q8_8)(int16_t* w_q8_8, int16_t* x_q8_8, size_t size);
+    int64_t (*dotproduct_q8_8_wide)(int16_t* w_q8_8, int16_t* x_q8_8, size_t size);
+    float (*dotproduct_fp)(float* w_fp, float* x_fp, size_t size);
+    void (*sgd_inplace)(int16_t y_hat, float y, float* w_fp, float* x_fp, size_t size, float lr);
+    void (*sgd_q8_8_inplace)(int16_t y_hat, float y, float* w_fp, int16_t* w_q8_8, float* x_fp, size_t size, float lr);
+    float (*absmax_scale_int8)(float* v, size_t size);
+    void (*quantize_int8)(float* v, int8_t* q, size_t size, float scale);
+    int32_t (*dotproduct_int8)(int8_t* w_int8, int8_t* x_int8, size_t size);
+};
+
+//Highest tier the CPU (and OS) supports
+ISA detectISA();
+
+const char* isaName(ISA isa);
+
+const KernelTable& kernelTable(ISA isa);
+
+//Best supported tier, AVX_LR_ISA=sse4.2|avx2|avx512 forces a lower one
+const KernelTable& kernels();
+
+//Throws std::logic_error when the selected tier is below isa, for code that calls a tier's kernels directly
+void requireISA(ISA isa, const char* what);
@@ -0,0 +1,223 @@
+#include "event_pipeline.hh"
+#include "affinity.hh"
+#include <algorithm>
+#include <bit>
+#include <immintrin.h>
+
+//Polls back to back while events flow, yields after a long idle stretch so a shared core still lets producers run
+constexpr size_t PIPELINE_IDLE_SPINS= 4096;
+
+InferencePipeline::InferencePipeline(size_t feature_size, PipelineMode mode, size_t capacity, size_t label_history, int cpu, float learning_rate):
+    feature_size_m(feature_size),
+    feature_stride_m(ringRecordBytes(feature_size* sizeof(float))),
+    mode_m(mode),
+    history_size_m(label_history? std::bit_ceil(label_history): 0),
+    cpu_m(cpu),
+    model_m(feature_size, learning_rate),
+    results_m(capacity, sizeof(pipelineResult)),
+    history_inputs_m(RING_RECORD_ALIGN, std::max<size_t>(history_size_m, 1)* feature_stride_m/ sizeof(float)),
+    history_ids_m(std::max<size_t>(history_size_m, 1)),
+    history_predictions_m(std::max<size_t>(history_size_m, 1)),
+    stop_m(true),
+    processed_m(0),
+    learned_m(0),
+    expired_labels_m(0),
+    output_stalls_m(0),
+    pinned_m(false){
+    const size_t event_bytes= RING_RECORD_ALIGN + feature_stride_m;
+    if (mode == PipelineMode::SPSC){
+        spsc_events_m= std::make_unique<SPSCRing>(capacity, event_bytes);
+        spsc_labels_m= std::make_unique<SPSCRing>(capacity, sizeof(pipelineLabel));
+    }
+    else{
+        mpsc_events_m= std::make_unique<MPSCRing>(capacity, event_bytes);
+        mpsc_labels_m= std::make_unique<MPSCRing>(capacity, sizeof(pipelineLabel));
+    }
+    for (size_t i= 0; i < history_ids_m.size(); i++){
+        history_ids_m[i]= UINT64_MAX;
+    }
+}
+
+InferencePipeline::~InferencePipeline(){
+    stop();
+}
+
+SGDLogisticRegression& InferencePipeline::model(){
+    return model_m;
+}
+
+void InferencePipeline::start(){
+    if (worker_m.joinable()){
+        return;
+    }
+    stop_m.store(false, std::memory_order_relaxed);
+    worker_m= std::thread(&InferencePipeline::worker, this);
+}
+
+void InferencePipeline::stop(){
+    if (!worker_m.joinable()){
+        return;
+    }
+    stop_m.store(true, std::memory_order_relaxed);
+    worker_m.join();
+}
+
+template <typename Ring>
+bool InferencePipeline::submitTo(Ring& ring, uint64_t id, const float* features, uint64_t timestamp){
+    std::byte* record= static_cast<std::byte*>(ring.claim());
+    if (!record){
+        return false;
+    }
+    pipelineEvent* event= reinterpret_cast<pipelineEvent*>(record);
+    event->id= id;
+    event->timestamp= timestamp;
+    std::memcpy(record + RING_RECORD_ALIGN, features, feature_size_m* sizeof(float));
+    ring.push(record);
+    return true;
+}
+
+template <typename Ring>
+bool InferencePipeline::labelTo(Ring& ring, uint64_t id, float label){
+    pipelineLabel* record= static_cast<pipelineLabel*>(ring.claim());
+    if (!record){
+        return false;
+    }
+    record->id= id;
+    record->label= label;
+    ring.push(record);
+    return true;
+}
+
+bool InferencePipeline::trySubmit(uint64_t id, const float* features, uint64_t timestamp){
+    if (mode_m == PipelineMode::SPSC){
+        return submitTo(*spsc_events_m, id, features, timestamp);
+    }
+    return submitTo(*mpsc_events_m, id, features, timestamp);
+}
+
+bool InferencePipeline::tryLabel(uint64_t id, float label){
+    if (history_size_m == 0){
+        return true;
+    }
+    if (mode_m == PipelineMode::SPSC){
+        return labelTo(*spsc_labels_m, id, label);
+    }
+    return labelTo(*mpsc_labels_m, id, label);
+}
+
+bool InferencePipeline::tryResult(pipelineResult& result){
+    const pipelineResult* record= static_cast<const pipelineResult*>(results_m.front());
+    if (!record){
+        return false;
+    }
+    result= *record;
+    results_m.pop();
+    return true;
+}
+
+//Scores straight out of the ring slot, the features only get copied when a history keeps them for a later label
+void InferencePipeline::score(pipelineEvent* event){
+    float* features= reinterpret_cast<float*>(reinterpret_cast<std::byte*>(event) + RING_RECORD_ALIGN);
+    alignedArray<float> inputs= alignedArray<float>::view(features, feature_size_m);
+    float probability= model_m.inference_q8_8_to_fp(inputs);
+
+    if (history_size_m){
+        size_t slot= event->id & (history_size_m - 1);
+        history_ids_m[slot]= event->id;
+        history_predictions_m[slot]= probability;
+        std::memcpy(&history_inputs_m[slot* feature_stride_m/ sizeof(float)], features, feature_size_m* sizeof(float));
+    }
+
+    pipelineResult* result= static_cast<pipelineResult*>(results_m.claim());
+    if (!result){
+        output_stalls_m.fetch_add(1, std::memory_order_relaxed);
+        for (size_t spins= 0; !(result= static_cast<pipelineResult*>(results_m.claim())); spins++){
+            if (stop_m.load(std::memory_order_relaxed)){
+                return;
+            }
+            if (spins < PIPELINE_IDLE_SPINS){
+                _mm_pause();
+            }
+            else{
+                std::this_thread::yield();
+            }
+        }
+    }
+    result->id= event->id;
+    result->timestamp= event->timestamp;
+    result->probability= probability;
+    results_m.push(result);
+    processed_m.fetch_add(1, std::memory_order_relaxed);
+}
+
+void InferencePipeline::learn(const pipelineLabel* label){
+    size_t slot= label->id & (history_size_m - 1);
+    if (history_ids_m[slot] != label->id){
+        expired_labels_m.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    model_m.setInputs(&history_inputs_m[slot* feature_stride_m/ sizeof(float)]);
+    model_m.update_weights(history_predictions_m[slot], label->label);
+    history_ids_m[slot]= UINT64_MAX;
+    learned_m.fetch_add(1, std::memory_order_relaxed);
+}
+
+//Pending labels go first so the next event is scored with every update that has arrived
+template <typename Ring>
+void InferencePipeline::run(Ring& events, Ring& labels){
+    size_t idle= 0;
+    while (!stop_m.load(std::memory_order_relaxed)){
+        bool busy= false;
+        while (const pipelineLabel* label= static_cast<const pipelineLabel*>(labels.front())){
+            learn(label);
+            labels.pop();
+            busy= true;
+        }
+        if (pipelineEvent* event= static_cast<pipelineEvent*>(events.front())){
+            score(event);
+            events.pop();
+            busy= true;
+        }
+
+        idle= busy? 0: idle + 1;
+        if (idle > PIPELINE_IDLE_SPINS){
+            std::this_thread::yield();
+        }
+        else if (idle){
+            _mm_pause();
+        }
+    }
+}
+
+void InferencePipeline::worker(){
+    if (cpu_m >= 0){
+        pinned_m.store(pinToAllowedCPU(cpu_m), std::memory_order_relaxed);
+    }
+
+    if (mode_m == PipelineMode::SPSC){
+        run(*spsc_events_m, *spsc_labels_m);
+    }
+    else{
+        run(*mpsc_events_m, *mpsc_labels_m);
+    }
+}
+
+uint64_t InferencePipeline::processed() const{
+    return processed_m.load(std::memory_order_relaxed);
+}
+
+uint64_t InferencePipeline::learned() const{
+    return learned_m.load(std::memory_order_relaxed);
+}
+
+uint64_t InferencePipeline::expiredLabels() const{
+    return expired_labels_m.load(std::memory_order_relaxed);
+}
+
+uint64_t InferencePipeline::outputStalls() const{
+    return output_stalls_m.load(std::memory_order_relaxed);
+}
+
+bool InferencePipeline::pinned() const{
+    return pinned_m.load(std::memory_order_relaxed);
+}
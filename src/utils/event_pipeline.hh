@@ -0,0 +1,100 @@
+#pragma once
+#include "logistic_regession.hh"
+#include "ring_buffer.hh"
+#include <atomic>
+#include <memory>
+#include <thread>
+
+enum class PipelineMode{
+    SPSC, //one thread submits events and labels
+    MPSC  //any number of threads submit events and labels
+};
+
+//Input record header, the features follow at the next cache line
+struct pipelineEvent{
+    uint64_t id;
+    uint64_t timestamp;
+};
+
+struct pipelineLabel{
+    uint64_t id;
+    float label;
+};
+
+struct pipelineResult{
+    uint64_t id;
+    uint64_t timestamp; //echoed from the event, so callers can time queue-to-result with their own clock
+    float probability;
+};
+
+//Moves model work off the caller's thread: producers drop fixed-size feature records into a lock-free ring and never
+//block, one pinned worker busy-polls it, scores each event (Q8.8) and writes the result to an SPSC output ring
+//With a label history the worker keeps the last label_history events and learns from labels that arrive later;
+//labels for events that already fell out of the history are counted and dropped
+class InferencePipeline{
+    private:
+        const size_t feature_size_m;
+        const size_t feature_stride_m; //bytes of features per record, whole cache lines
+        const PipelineMode mode_m;
+        const size_t history_size_m;   //events kept for delayed labels, 0 without learning
+        const int cpu_m;
+
+        SGDLogisticRegression model_m;
+        std::unique_ptr<SPSCRing> spsc_events_m;
+        std::unique_ptr<SPSCRing> spsc_labels_m;
+        std::unique_ptr<MPSCRing> mpsc_events_m;
+        std::unique_ptr<MPSCRing> mpsc_labels_m;
+        SPSCRing results_m;
+
+        alignedArray<float> history_inputs_m; //one feature_stride_m row per slot
+        alignedArray<uint64_t> history_ids_m;
+        alignedArray<float> history_predictions_m;
+
+        std::thread worker_m;
+        alignas(64) std::atomic<bool> stop_m;
+        alignas(64) std::atomic<uint64_t> processed_m;
+        std::atomic<uint64_t> learned_m;
+        std::atomic<uint64_t> expired_labels_m;
+        std::atomic<uint64_t> output_stalls_m;
+        std::atomic<bool> pinned_m;
+
+        template <typename Ring>
+        bool submitTo(Ring& ring, uint64_t id, const float* features, uint64_t timestamp);
+        template <typename Ring>
+        bool labelTo(Ring& ring, uint64_t id, float label);
+        template <typename Ring>
+        void run(Ring& events, Ring& labels);
+        void worker();
+        void score(pipelineEvent* event);
+        void learn(const pipelineLabel* label);
+
+    public:
+        //capacity (rounded up to a power of two) applies to the event, label and result rings, label_history 0 disables
+        //learning, otherwise it is rounded up to a power of two. cpu indexes the allowed CPUs (allowedCPU), -1 leaves the worker unpinned
+        InferencePipeline(size_t feature_size, PipelineMode mode= PipelineMode::SPSC, size_t capacity= 1024, size_t label_history= 0, int cpu= -1, float learning_rate= 0.01f);
+        ~InferencePipeline();
+
+        InferencePipeline(const InferencePipeline&)= delete;
+        InferencePipeline& operator=(const InferencePipeline&)= delete;
+
+        //Only touch the model before start() or after stop()
+        SGDLogisticRegression& model();
+
+        void start();
+        //Events still queued are left unprocessed
+        void stop();
+
+        //Producer side, false when the ring is full (the caller decides whether to drop or retry)
+        //SPSC mode allows one producer thread for events and one for labels
+        bool trySubmit(uint64_t id, const float* features, uint64_t timestamp= 0);
+        bool tryLabel(uint64_t id, float label);
+
+        //Consumer side, one thread
+        bool tryResult(pipelineResult& result);
+
+        uint64_t processed() const;
+        uint64_t learned() const;
+        uint64_t expiredLabels() const;
+        uint64_t outputStalls() const; //times the worker found the result ring full and had to wait
+        bool pinned() const; //whether the worker got its CPU, false until it has started
+};
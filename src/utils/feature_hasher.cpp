@@ -0,0 +1,69 @@
+#include "feature_hasher.hh"
+#include "tools.hh"
+#include <algorithm>
+#include <cstdint>
+
+FeatureHasher::FeatureHasher(size_t feature_size, uint64_t seed, size_t capacity)
+    :kernels_m(kernels()),
+    feature_size_m(static_cast<uint32_t>(feature_size)),
+    seed_m(seed),
+    features_m(std::max<size_t>(capacity, 8)),
+    stamps_m(feature_size),
+    slots_m(feature_size),
+    generation_m(0){
+    assert(feature_size > 0 && feature_size <= INT32_MAX && "Hashed indices are int32");
+    std::memset(stamps_m.data(), 0, stamps_m.size()* sizeof(uint32_t));
+}
+
+size_t FeatureHasher::featureSize() const{
+    return feature_size_m;
+}
+
+uint64_t FeatureHasher::seed() const{
+    return seed_m;
+}
+
+void FeatureHasher::reserve(size_t count){
+    if (count > features_m.indices.size()){
+        features_m= sparseArray(std::max(count, 2* features_m.indices.size()));
+    }
+}
+
+//Hashes into features_m, then compacts it in place: the first id of each index keeps its slot, later ones add to it
+sparseArray& FeatureHasher::hash(const uint64_t* ids, const float* values, size_t count){
+    reserve(count);
+    int32_t* indices= features_m.indices.data();
+    float* hashed_values= features_m.values.data();
+
+    if (kernels_m.isa >= ISA::AVX2){
+        hash_features(ids, values, count, seed_m, feature_size_m, indices, hashed_values);
+    }
+    else{
+        for (size_t i= 0; i < count; i++){
+            uint64_t h= hash_feature_id(ids[i], seed_m);
+            indices[i]= hashed_index(h, feature_size_m);
+            hashed_values[i]= (values? values[i]: 1.0f)* hashed_sign(h);
+        }
+    }
+
+    if (++generation_m == 0){
+        std::memset(stamps_m.data(), 0, stamps_m.size()* sizeof(uint32_t));
+        generation_m= 1;
+    }
+
+    size_t nnz= 0;
+    for (size_t i= 0; i < count; i++){
+        int32_t index= indices[i];
+        if (stamps_m[index] == generation_m){
+            hashed_values[slots_m[index]]+= hashed_values[i];
+            continue;
+        }
+        stamps_m[index]= generation_m;
+        slots_m[index]= static_cast<int32_t>(nnz);
+        indices[nnz]= index;
+        hashed_values[nnz]= hashed_values[i];
+        nnz++;
+    }
+    features_m.nnz= nnz;
+    return features_m;
+}
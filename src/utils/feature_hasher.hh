@@ -0,0 +1,31 @@
+#pragma once
+#include "avx.hh"
+#include "containers.hh"
+#include "dispatch.hh"
+
+//Hashing trick for high-cardinality categorical features: raw 64-bit ids (user, item, crosses) go straight into a
+//fixed feature_size model as a sparseArray, no dense input is built. Ids that land on the same index are summed into
+//one entry, so the result feeds inference_sparse_* and update_weights_sparse as is
+class FeatureHasher{
+    private:
+        const KernelTable& kernels_m;
+        const uint32_t feature_size_m;
+        const uint64_t seed_m;
+
+        sparseArray features_m;
+        alignedArray<uint32_t> stamps_m; //generation that last wrote each index
+        alignedArray<int32_t> slots_m;   //position of that index in features_m for the stamped generation
+        uint32_t generation_m;
+
+        void reserve(size_t count);
+
+    public:
+        //Different seeds give independent hash functions (e.g. one per namespace or per model)
+        FeatureHasher(size_t feature_size, uint64_t seed= 0, size_t capacity= 256);
+
+        size_t featureSize() const;
+        uint64_t seed() const;
+
+        //values null means every id has value 1, the result stays valid until the next call
+        sparseArray& hash(const uint64_t* ids, const float* values, size_t count);
+};
@@ -0,0 +1,179 @@
+#include "fixed_logistic_regression.hh"
+#include "dispatch.hh"
+#include <random>
+#include <utility>
+
+//Calls step(i) for every full 16-element block of an N-element array as straight-line code
+template <size_t N, typename Step>
+static inline void unroll16(Step&& step){
+    [&]<size_t... B>(std::index_sequence<B...>){
+        (step(B* 16), ...);
+    }(std::make_index_sequence<N/ 16>{});
+}
+
+template <size_t N>
+static inline void quantize8_8_fixed(const float* v, int16_t* q){
+    unroll16<N>([&](size_t i){
+        __m256i vec_pi= _mm256_packs_epi32(quantize8_8_epi32(_mm256_load_ps(&v[i])), quantize8_8_epi32(_mm256_load_ps(&v[i + 8])));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(&q[i]), _mm256_permute4x64_epi64(vec_pi, 0xD8));
+    });
+}
+
+template <size_t N>
+static inline int32_t dotproduct_q8_8_fixed(const int16_t* w_q8_8, const int16_t* x_q8_8){
+    __m256i vec_sum_q16_16= _mm256_setzero_si256();
+    unroll16<N>([&](size_t i){
+        vec_sum_q16_16= _mm256_add_epi32(vec_sum_q16_16, _mm256_madd_epi16(_mm256_load_si256((const __m256i*)&w_q8_8[i]), _mm256_load_si256((const __m256i*)&x_q8_8[i])));
+    });
+    return hsum_epi32(vec_sum_q16_16);
+}
+
+//Same operation order as dotproduct_fp, so the sums match it exactly
+template <size_t N>
+static inline float dotproduct_fp_fixed(const float* w_fp, const float* x_fp){
+    __m256 vec_sum_fp= _mm256_setzero_ps();
+    unroll16<N>([&](size_t i){
+        __m256 dot1= _mm256_fmadd_ps(_mm256_load_ps(&w_fp[i]), _mm256_load_ps(&x_fp[i]), _mm256_setzero_ps());
+        __m256 dot2= _mm256_fmadd_ps(_mm256_load_ps(&w_fp[i + 8]), _mm256_load_ps(&x_fp[i + 8]), _mm256_setzero_ps());
+        vec_sum_fp= _mm256_add_ps(vec_sum_fp, _mm256_add_ps(dot1, dot2));
+    });
+
+    __m128 sum_fp_128= _mm_add_ps(_mm256_castps256_ps128(vec_sum_fp), _mm256_extractf128_ps(vec_sum_fp, 1));
+    sum_fp_128= _mm_hadd_ps(sum_fp_128, sum_fp_128);
+    sum_fp_128= _mm_hadd_ps(sum_fp_128, sum_fp_128);
+    return _mm_cvtss_f32(sum_fp_128);
+}
+
+//Quantizes x in-register like dotproduct_q8_8_quantize
+template <size_t N>
+static inline int32_t dotproduct_q8_8_quantize_fixed(const int16_t* w_q8_8, const float* x_fp){
+    __m256i vec_sum_q16_16= _mm256_setzero_si256();
+    unroll16<N>([&](size_t i){
+        __m256i vec_x_q8_8= _mm256_permute4x64_epi64(_mm256_packs_epi32(quantize8_8_epi32(_mm256_load_ps(&x_fp[i])), quantize8_8_epi32(_mm256_load_ps(&x_fp[i + 8]))), 0xD8);
+        vec_sum_q16_16= _mm256_add_epi32(vec_sum_q16_16, _mm256_madd_epi16(_mm256_load_si256((const __m256i*)&w_q8_8[i]), vec_x_q8_8));
+    });
+    return hsum_epi32(vec_sum_q16_16);
+}
+
+//Branch-free sgd_q8_8_inplace: a zero x leaves w unchanged anyway, so skipping those blocks only saves memory traffic,
+//which doesn't pay at these sizes. Q8 false updates the float weights only
+template <size_t N, bool Q8>
+static inline void sgd_fixed(int16_t y_hat, float y, float* w_fp, int16_t* w_q8_8, const float* x_fp, float lr){
+    float neg_coeff= lr*(y- q8_8_to_float(y_hat));
+    __m256 vec_neg_coeff= _mm256_set1_ps(neg_coeff);
+    unroll16<N>([&](size_t i){
+        __m256 vec1_w_fp= _mm256_fmadd_ps(vec_neg_coeff, _mm256_load_ps(&x_fp[i]), _mm256_load_ps(&w_fp[i]));
+        __m256 vec2_w_fp= _mm256_fmadd_ps(vec_neg_coeff, _mm256_load_ps(&x_fp[i + 8]), _mm256_load_ps(&w_fp[i + 8]));
+        _mm256_store_ps(&w_fp[i], vec1_w_fp);
+        _mm256_store_ps(&w_fp[i + 8], vec2_w_fp);
+        if constexpr (Q8){
+            __m256i vec_w_q8_8= _mm256_packs_epi32(quantize8_8_epi32(vec1_w_fp), quantize8_8_epi32(vec2_w_fp));
+            _mm256_store_si256(reinterpret_cast<__m256i*>(&w_q8_8[i]), _mm256_permute4x64_epi64(vec_w_q8_8, 0xD8));
+        }
+    });
+}
+
+template <size_t N, WeightFormat Format>
+FixedLogisticRegression<N, Format>::FixedLogisticRegression(float learning_rate, float threshold):
+    weights_m{},
+    inputs_m{},
+    weights_q8_8_m{},
+    inputs_q8_8_m{},
+    learning_rate_m(learning_rate),
+    threshold_m(threshold){
+    requireISA(ISA::AVX2, "Fixed-size models");
+    initWeights();
+}
+
+//xavier init, same distribution as SGDLogisticRegression
+template <size_t N, WeightFormat Format>
+void FixedLogisticRegression<N, Format>::initWeights(){
+    std::random_device rd;
+    std::mt19937 gen(rd());
+
+    float limit= sqrt(6.0f / N);
+    std::uniform_real_distribution<float> dist(-limit, limit);
+    for (size_t i= 0; i < N; i++){
+        weights_m[i]= dist(gen);
+    }
+    if constexpr (Format == WeightFormat::Q8_8){
+        quantize8_8_fixed<N>(weights_m.data(), weights_q8_8_m.data());
+    }
+}
+
+template <size_t N, WeightFormat Format>
+void FixedLogisticRegression<N, Format>::setThreshold(float threshold){
+    threshold_m= threshold;
+}
+
+template <size_t N, WeightFormat Format>
+void FixedLogisticRegression<N, Format>::setLearningRate(float learning_rate){
+    learning_rate_m= learning_rate;
+}
+
+template <size_t N, WeightFormat Format>
+void FixedLogisticRegression<N, Format>::setInputs(float* x){
+    std::memcpy(inputs_m.data(), x, N* sizeof(float));
+}
+
+template <size_t N, WeightFormat Format>
+void FixedLogisticRegression<N, Format>::setWeights(float* w){
+    std::memcpy(weights_m.data(), w, N* sizeof(float));
+    if constexpr (Format == WeightFormat::Q8_8){
+        quantize8_8_fixed<N>(weights_m.data(), weights_q8_8_m.data());
+    }
+}
+
+template <size_t N, WeightFormat Format>
+const float* FixedLogisticRegression<N, Format>::weights() const{
+    return weights_m.data();
+}
+
+template <size_t N, WeightFormat Format>
+const int16_t* FixedLogisticRegression<N, Format>::weights_q8_8() const requires (Format == WeightFormat::Q8_8){
+    return weights_q8_8_m.data();
+}
+
+template <size_t N, WeightFormat Format>
+float FixedLogisticRegression<N, Format>::inference_fp(alignedArray<float>& inputs){
+    assert(inputs.size() >= N && "Inputs shorter than the model");
+    return q8_8_to_float(sigmoid_fp_to_q8_8(dotproduct_fp_fixed<N>(weights_m.data(), inputs.data())));
+}
+
+template <size_t N, WeightFormat Format>
+float FixedLogisticRegression<N, Format>::inference_q8_8_to_fp(alignedArray<float>& inputs) requires (Format == WeightFormat::Q8_8){
+    assert(inputs.size() >= N && "Inputs shorter than the model");
+    quantize8_8_fixed<N>(inputs.data(), inputs_q8_8_m.data());
+    return q8_8_to_float(sigmoidApprox_q16_16_to_q8_8(dotproduct_q8_8_fixed<N>(weights_q8_8_m.data(), inputs_q8_8_m.data())));
+}
+
+template <size_t N, WeightFormat Format>
+void FixedLogisticRegression<N, Format>::update_weights(float prediction, float label){
+    sgd_fixed<N, Format == WeightFormat::Q8_8>(float_to_q8_8(prediction), label, weights_m.data(), weights_q8_8_m.data(), inputs_m.data(), learning_rate_m);
+}
+
+template <size_t N, WeightFormat Format>
+float FixedLogisticRegression<N, Format>::predict_and_learn(alignedArray<float>& inputs, float label){
+    assert(inputs.size() >= N && "Inputs shorter than the model");
+    if constexpr (Format == WeightFormat::Q8_8){
+        int16_t prediction= sigmoidApprox_q16_16_to_q8_8(dotproduct_q8_8_quantize_fixed<N>(weights_q8_8_m.data(), inputs.data()));
+        sgd_fixed<N, true>(prediction, label, weights_m.data(), weights_q8_8_m.data(), inputs.data(), learning_rate_m);
+        return q8_8_to_float(prediction);
+    }
+    else{
+        int16_t prediction= sigmoid_fp_to_q8_8(dotproduct_fp_fixed<N>(weights_m.data(), inputs.data()));
+        sgd_fixed<N, false>(prediction, label, weights_m.data(), nullptr, inputs.data(), learning_rate_m);
+        return q8_8_to_float(prediction);
+    }
+}
+
+template class FixedLogisticRegression<16, WeightFormat::FP32>;
+template class FixedLogisticRegression<32, WeightFormat::FP32>;
+template class FixedLogisticRegression<64, WeightFormat::FP32>;
+template class FixedLogisticRegression<128, WeightFormat::FP32>;
+template class FixedLogisticRegression<256, WeightFormat::FP32>;
+template class FixedLogisticRegression<16, WeightFormat::Q8_8>;
+template class FixedLogisticRegression<32, WeightFormat::Q8_8>;
+template class FixedLogisticRegression<64, WeightFormat::Q8_8>;
+template class FixedLogisticRegression<128, WeightFormat::Q8_8>;
+template class FixedLogisticRegression<256, WeightFormat::Q8_8>;
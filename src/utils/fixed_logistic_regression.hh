@@ -0,0 +1,54 @@
+#pragma once
+#include "containers.hh"
+#include "tools.hh"
+#include <array>
+#include <cstddef>
+
+enum class WeightFormat{
+    FP32, //float weights only, inference_fp
+    Q8_8  //float weights plus the Q8.8 copy every update refreshes, inference_q8_8_to_fp
+};
+
+//SGDLogisticRegression with the feature count fixed at compile time, for small models scored a few ns at a time.
+//Weights live inline in the object and every kernel is straight-line AVX2 code over whole 16-element blocks: no loop
+//counter and no tail, so N has to be a multiple of 16. Results match the dynamic model on the AVX2 tier bit for bit.
+//Needs the AVX2 tier (throws logic_error otherwise); the kernels are compiled in fixed_logistic_regression.cpp, which
+//instantiates N = 16, 32, 64, 128 and 256 in both formats
+template <size_t N, WeightFormat Format= WeightFormat::Q8_8>
+class FixedLogisticRegression{
+    //any other N would compile against this header and only fail at link time, new sizes are added to the .cpp first
+    static_assert(N == 16 || N == 32 || N == 64 || N == 128 || N == 256,
+        "FixedLogisticRegression is instantiated for N = 16, 32, 64, 128 and 256 in fixed_logistic_regression.cpp");
+
+    private:
+        alignas(64) std::array<float, N> weights_m;
+        alignas(64) std::array<float, N> inputs_m;
+        alignas(64) std::array<int16_t, Format == WeightFormat::Q8_8? N: 0> weights_q8_8_m;
+        alignas(64) std::array<int16_t, Format == WeightFormat::Q8_8? N: 0> inputs_q8_8_m;
+        float learning_rate_m;
+        float threshold_m;
+
+        void initWeights();
+
+    public:
+        explicit FixedLogisticRegression(float learning_rate= 0.01f, float threshold= 0.0f);
+
+        void setThreshold(float val);
+        void setLearningRate(float val);
+        void setInputs(float* x);
+        //Copies N weights in and refreshes the quantized copy
+        void setWeights(float* w);
+        const float* weights() const;
+        const int16_t* weights_q8_8() const requires (Format == WeightFormat::Q8_8);
+        static constexpr size_t featureSize(){
+            return N;
+        }
+
+        //inputs must hold N floats
+        float inference_fp(alignedArray<float>& inputs);
+        float inference_q8_8_to_fp(alignedArray<float>& inputs) requires (Format == WeightFormat::Q8_8);
+        //SGD step on the inputs from setInputs
+        void update_weights(float prediction, float label);
+        //One online step, same result as setInputs + inference + update_weights (Q8.8 inference for the Q8_8 format)
+        float predict_and_learn(alignedArray<float>& inputs, float label);
+};
@@ -0,0 +1,125 @@
+#include "hogwild.hh"
+#include "tools.hh"
+#include "affinity.hh"
+#include <thread>
+#include <random>
+
+HogwildTrainer::HogwildTrainer(size_t feature_size, size_t num_threads, float learning_rate, size_t merge_interval):
+    kernels_m(kernels()),
+    feature_size_m(feature_size),
+    row_stride_m((feature_size + 15) & ~size_t(15)),
+    num_threads_m(num_threads),
+    learning_rate_m(learning_rate),
+    merge_interval_m(merge_interval),
+    pin_threads_m(true),
+    weights_m(64, row_stride_m){
+    assert(num_threads > 0 && "Need at least one worker");
+    //separate 64-byte aligned allocations, so no two threads' buffers share a cache line
+    for (size_t t= 0; t < num_threads_m; t++){
+        gradients_m.emplace_back(64, row_stride_m);
+    }
+    initWeights();
+}
+
+void HogwildTrainer::setLearningRate(float learning_rate){
+    learning_rate_m= learning_rate;
+}
+
+void HogwildTrainer::setMergeInterval(size_t merge_interval){
+    merge_interval_m= merge_interval;
+}
+
+void HogwildTrainer::setPinning(bool pin_threads){
+    pin_threads_m= pin_threads;
+}
+
+size_t HogwildTrainer::rowStride() const{
+    return row_stride_m;
+}
+
+size_t HogwildTrainer::numThreads() const{
+    return num_threads_m;
+}
+
+float* HogwildTrainer::weights() const{
+    return weights_m.data();
+}
+
+float HogwildTrainer::inference_fp(alignedArray<float>& inputs){
+    return q8_8_to_float(sigmoid_fp_to_q8_8(kernels_m.dotproduct_fp(weights_m.data(), inputs.data(), feature_size_m)));
+}
+
+//Unsynchronised on purpose, concurrent merges may lose a few increments
+void HogwildTrainer::merge(float* gradient){
+    float* w= weights_m.data();
+    for (size_t i= 0; i < feature_size_m; i++){
+        w[i]+= gradient[i];
+        gradient[i]= 0.0f;
+    }
+}
+
+//Predictions always read the shared weights, in buffered mode they lag this thread's own unmerged steps
+void HogwildTrainer::worker(size_t thread_id, alignedArray<float>& samples, float* labels, size_t begin, size_t end, size_t epochs){
+    if (pin_threads_m){
+        pinToAllowedCPU(thread_id);
+    }
+
+    float* w= weights_m.data();
+    float* gradient= gradients_m[thread_id].data();
+    size_t pending= 0;
+
+    for (size_t e= 0; e < epochs; e++){
+        for (size_t n= begin; n < end; n++){
+            float* x= &samples[n* row_stride_m];
+            int16_t y_hat= sigmoid_fp_to_q8_8(kernels_m.dotproduct_fp(w, x, feature_size_m));
+
+            if (merge_interval_m == 0){
+                kernels_m.sgd_inplace(y_hat, labels[n], w, x, feature_size_m, learning_rate_m);
+                continue;
+            }
+
+            kernels_m.sgd_inplace(y_hat, labels[n], gradient, x, feature_size_m, learning_rate_m);
+            if (++pending == merge_interval_m){
+                merge(gradient);
+                pending= 0;
+            }
+        }
+    }
+
+    if (pending > 0){
+        merge(gradient);
+    }
+}
+
+void HogwildTrainer::train(alignedArray<float>& samples, float* labels, size_t sample_count, size_t epochs){
+    assert(samples.size() >= sample_count* row_stride_m && "Samples must hold sample_count rows of rowStride()");
+    for (size_t t= 0; t < num_threads_m; t++){
+        std::memset(gradients_m[t].data(), 0, row_stride_m* sizeof(float));
+    }
+
+    size_t shard= (sample_count + num_threads_m - 1)/ num_threads_m;
+    std::vector<std::thread> workers;
+    workers.reserve(num_threads_m);
+    for (size_t t= 0; t < num_threads_m; t++){
+        size_t begin= std::min(t* shard, sample_count);
+        size_t end= std::min(begin + shard, sample_count);
+        workers.emplace_back(&HogwildTrainer::worker, this, t, std::ref(samples), labels, begin, end, epochs);
+    }
+    for (std::thread& worker: workers){
+        worker.join();
+    }
+}
+
+//xavier init, padding past feature_size stays 0
+void HogwildTrainer::initWeights(){
+    std::random_device rd;
+    std::mt19937 gen(rd());
+
+    float limit= sqrt(6.0f / feature_size_m);
+    std::uniform_real_distribution<float> dist(-limit, limit);
+
+    std::memset(weights_m.data(), 0, row_stride_m* sizeof(float));
+    for (size_t i= 0; i < feature_size_m; i++){
+        weights_m[i]= dist(gen);
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "containers.hh"
+#include "dispatch.hh"
+#include <vector>
+
+//Lock-free (Hogwild) SGD over one shared weight vector, one pinned worker per shard of the samples
+class HogwildTrainer{
+    private:
+        const KernelTable& kernels_m;
+        const size_t feature_size_m;
+        const size_t row_stride_m;
+        const size_t num_threads_m;
+
+        float learning_rate_m;
+        size_t merge_interval_m; //0 writes every step straight into weights_m
+        bool pin_threads_m;
+
+        alignedArray<float> weights_m;
+        std::vector<alignedArray<float>> gradients_m; //one per thread, only used when merge_interval_m > 0
+
+        void initWeights();
+        void worker(size_t thread_id, alignedArray<float>& samples, float* labels, size_t begin, size_t end, size_t epochs);
+        void merge(float* gradient);
+
+    public:
+        HogwildTrainer(size_t feature_size, size_t num_threads, float learning_rate= 0.01f, size_t merge_interval= 0);
+
+        void setLearningRate(float learning_rate);
+        //Each thread accumulates merge_interval steps in a private buffer before adding it to the shared weights
+        void setMergeInterval(size_t merge_interval);
+        void setPinning(bool pin_threads);
+
+        //Samples are row-major with rowStride() floats per row so every row stays 64-byte aligned
+        size_t rowStride() const;
+        size_t numThreads() const;
+
+        void train(alignedArray<float>& samples, float* labels, size_t sample_count, size_t epochs= 1);
+
+        //Hand off with SGDLogisticRegression::setWeights for the quantized inference paths
+        float* weights() const;
+        float inference_fp(alignedArray<float>& inputs);
+};
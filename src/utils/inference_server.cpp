@@ -0,0 +1,501 @@
+#include "inference_server.hh"
+#include "tools.hh"
+#include "affinity.hh"
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <fcntl.h>
+#include <immintrin.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+//Same idle policy as the event pipeline: poll back to back while requests flow, yield after a long idle stretch
+constexpr size_t SERVER_IDLE_SPINS= 4096;
+constexpr int SERVER_CONTROL_POLL_MS= 100;
+
+static sockaddr_un socketAddress(const std::string& path){
+    sockaddr_un address{};
+    address.sun_family= AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)){
+        throw std::runtime_error("Socket path too long: " + path);
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+}
+
+InferenceServer::InferenceServer(const std::string& socket_path, size_t max_clients, size_t capacity, size_t max_batch, int cpu):
+    socket_path_m(socket_path),
+    capacity_m(std::bit_ceil(capacity)),
+    max_batch_m(max_batch),
+    cpu_m(cpu),
+    slots_m(max_clients),
+    request_bytes_m(0),
+    response_offset_m(0),
+    mapping_bytes_m(0),
+    listen_m(-1),
+    channels_opened_m(0),
+    stop_m(false),
+    served_m(0),
+    batches_run_m(0),
+    pinned_m(false){
+    assert(max_clients > 0 && capacity > 0 && max_batch > 0 && "Server needs clients, ring slots and a batch size");
+    for (clientSlot& slot: slots_m){
+        slot.state.store(SlotState::Free, std::memory_order_relaxed);
+        slot.socket= -1;
+        slot.mapping= nullptr;
+        slot.taken= 0;
+    }
+}
+
+InferenceServer::~InferenceServer(){
+    stop();
+}
+
+size_t InferenceServer::addModel(std::unique_ptr<SGDLogisticRegression> model){
+    if (listen_m >= 0){
+        throw std::logic_error("Models must be added before start()");
+    }
+    if (models_m.size() == SERVER_MAX_MODELS){
+        throw std::logic_error("Server already holds SERVER_MAX_MODELS models");
+    }
+    models_m.push_back(std::move(model));
+    return models_m.size() - 1;
+}
+
+size_t InferenceServer::addModel(size_t feature_size){
+    return addModel(std::make_unique<SGDLogisticRegression>(feature_size));
+}
+
+size_t InferenceServer::loadModel(const std::string& path){
+    return addModel(std::make_unique<SGDLogisticRegression>(std::make_shared<modelMapping>(path)));
+}
+
+SGDLogisticRegression& InferenceServer::model(size_t id){
+    return *models_m.at(id);
+}
+
+//Every channel is sized for the largest model, so one mapping layout serves any request
+void InferenceServer::start(){
+    if (listen_m >= 0){
+        return;
+    }
+    if (models_m.empty()){
+        throw std::logic_error("Server has no models");
+    }
+
+    size_t max_features= 0;
+    for (auto& model: models_m){
+        max_features= std::max(max_features, model->featureSize());
+    }
+    request_bytes_m= RING_RECORD_ALIGN + ringRecordBytes(max_features* sizeof(float));
+    response_offset_m= SPSCRing::sharedBytes(capacity_m, request_bytes_m);
+    const size_t page= sysconf(_SC_PAGESIZE);
+    mapping_bytes_m= (response_offset_m + SPSCRing::sharedBytes(capacity_m, sizeof(inferenceResponse)) + page - 1)/ page* page;
+
+    batches_m.clear();
+    for (auto& model: models_m){
+        batches_m.push_back({alignedArray<float>(64, max_batch_m* model->featureSize()), alignedArray<float>(64, max_batch_m), {}});
+        batches_m.back().owners.reserve(max_batch_m);
+    }
+
+    sockaddr_un address= socketAddress(socket_path_m);
+    listen_m= socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (listen_m < 0){
+        throw std::runtime_error("Cannot create a control socket");
+    }
+    unlink(socket_path_m.c_str());
+    if (bind(listen_m, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listen_m, static_cast<int>(slots_m.size())) != 0){
+        close(listen_m);
+        listen_m= -1;
+        throw std::runtime_error("Cannot listen on " + socket_path_m);
+    }
+
+    stop_m.store(false, std::memory_order_relaxed);
+    control_m= std::thread(&InferenceServer::control, this);
+    worker_m= std::thread(&InferenceServer::worker, this);
+}
+
+void InferenceServer::stop(){
+    if (listen_m < 0){
+        return;
+    }
+    stop_m.store(true, std::memory_order_relaxed);
+    control_m.join();
+    worker_m.join();
+
+    for (clientSlot& slot: slots_m){
+        if (slot.socket >= 0){
+            close(slot.socket);
+            slot.socket= -1;
+        }
+        //a restarted server must see every slot free, poll() only skips Free slots
+        if (slot.state.load(std::memory_order_relaxed) != SlotState::Free){
+            release(slot);
+            slot.state.store(SlotState::Free, std::memory_order_relaxed);
+        }
+        slot.taken= 0;
+    }
+    close(listen_m);
+    listen_m= -1;
+    unlink(socket_path_m.c_str());
+}
+
+//Accepts connections and watches the open ones, a hang-up hands the slot to the worker for release
+void InferenceServer::control(){
+    std::vector<pollfd> fds;
+    std::vector<size_t> fd_slots;
+    while (!stop_m.load(std::memory_order_relaxed)){
+        fds.assign(1, pollfd{listen_m, POLLIN, 0});
+        fd_slots.assign(1, SIZE_MAX);
+        for (size_t s= 0; s < slots_m.size(); s++){
+            if (slots_m[s].socket >= 0){
+                fds.push_back(pollfd{slots_m[s].socket, POLLIN, 0});
+                fd_slots.push_back(s);
+            }
+        }
+
+        if (::poll(fds.data(), fds.size(), SERVER_CONTROL_POLL_MS) <= 0){
+            continue;
+        }
+        for (size_t i= 1; i < fds.size(); i++){
+            if (!fds[i].revents){
+                continue;
+            }
+            //clients send nothing after the handshake, anything readable is either stray data or the hang-up
+            char discard[64];
+            if (recv(fds[i].fd, discard, sizeof(discard), MSG_DONTWAIT) > 0){
+                continue;
+            }
+            clientSlot& slot= slots_m[fd_slots[i]];
+            close(slot.socket);
+            slot.socket= -1;
+            slot.state.store(SlotState::Closing, std::memory_order_release);
+        }
+        if (fds[0].revents & POLLIN){
+            accept();
+        }
+    }
+}
+
+//The shm object is unlinked as soon as it is mapped, the client gets it only through the passed fd
+void InferenceServer::accept(){
+    int client= ::accept4(listen_m, nullptr, nullptr, SOCK_CLOEXEC);
+    if (client < 0){
+        return;
+    }
+
+    serverHello hello{};
+    clientSlot* free_slot= nullptr;
+    for (clientSlot& slot: slots_m){
+        if (slot.socket < 0 && slot.state.load(std::memory_order_acquire) == SlotState::Free){
+            free_slot= &slot;
+            break;
+        }
+    }
+    if (!free_slot){
+        send(client, &hello, sizeof(hello), MSG_NOSIGNAL);
+        close(client);
+        return;
+    }
+
+    const std::string name= "/avx_lr_" + std::to_string(getpid()) + "_" + std::to_string(channels_opened_m++);
+    int shm= shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+    if (shm < 0){
+        close(client);
+        return;
+    }
+    shm_unlink(name.c_str());
+    void* mapping= MAP_FAILED;
+    if (ftruncate(shm, mapping_bytes_m) == 0){
+        mapping= mmap(nullptr, mapping_bytes_m, PROT_READ | PROT_WRITE, MAP_SHARED, shm, 0);
+    }
+    if (mapping == MAP_FAILED){
+        close(shm);
+        close(client);
+        return;
+    }
+    free_slot->mapping= mapping;
+    free_slot->requests= std::make_unique<SPSCRing>(mapping, capacity_m, request_bytes_m, true);
+    free_slot->responses= std::make_unique<SPSCRing>(static_cast<std::byte*>(mapping) + response_offset_m, capacity_m, sizeof(inferenceResponse), true);
+    free_slot->taken= 0;
+
+    hello.accepted= 1;
+    hello.num_models= static_cast<uint32_t>(models_m.size());
+    hello.capacity= capacity_m;
+    hello.request_bytes= request_bytes_m;
+    hello.response_offset= response_offset_m;
+    hello.mapping_bytes= mapping_bytes_m;
+    for (size_t m= 0; m < models_m.size(); m++){
+        hello.feature_sizes[m]= models_m[m]->featureSize();
+    }
+
+    iovec payload{&hello, sizeof(hello)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))]{};
+    msghdr message{};
+    message.msg_iov= &payload;
+    message.msg_iovlen= 1;
+    message.msg_control= control;
+    message.msg_controllen= sizeof(control);
+    cmsghdr* rights= CMSG_FIRSTHDR(&message);
+    rights->cmsg_level= SOL_SOCKET;
+    rights->cmsg_type= SCM_RIGHTS;
+    rights->cmsg_len= CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(rights), &shm, sizeof(int));
+
+    bool sent= sendmsg(client, &message, MSG_NOSIGNAL) == static_cast<ssize_t>(sizeof(hello));
+    close(shm);
+    if (!sent){
+        release(*free_slot);
+        close(client);
+        return;
+    }
+    free_slot->socket= client;
+    free_slot->state.store(SlotState::Active, std::memory_order_release);
+}
+
+//Runs again when the control thread sees the hang-up of a channel the worker already dropped
+void InferenceServer::release(clientSlot& slot){
+    if (!slot.mapping){
+        return;
+    }
+    slot.requests.reset();
+    slot.responses.reset();
+    munmap(slot.mapping, mapping_bytes_m);
+    slot.mapping= nullptr;
+}
+
+void InferenceServer::worker(){
+    if (cpu_m >= 0){
+        pinned_m.store(pinToAllowedCPU(cpu_m), std::memory_order_relaxed);
+    }
+
+    size_t idle= 0;
+    while (!stop_m.load(std::memory_order_relaxed)){
+        idle= poll()? 0: idle + 1;
+        if (idle > SERVER_IDLE_SPINS){
+            std::this_thread::yield();
+        }
+        else if (idle){
+            _mm_pause();
+        }
+    }
+}
+
+void InferenceServer::respond(size_t slot, uint64_t request_id, float probability, ResponseStatus status){
+    SPSCRing& responses= *slots_m[slot].responses;
+    inferenceResponse* response= static_cast<inferenceResponse*>(responses.claim());
+    if (!response){
+        //taken never exceeds the free records, so only a client that rewrote its ring indices gets here
+        slots_m[slot].state.store(SlotState::Closing, std::memory_order_release);
+        return;
+    }
+    response->request_id= request_id;
+    response->probability= probability;
+    response->status= status;
+    responses.push(response);
+    served_m.fetch_add(1, std::memory_order_relaxed);
+}
+
+void InferenceServer::flush(size_t model){
+    modelBatch& batch= batches_m[model];
+    models_m[model]->inference_batch_q8_8_to_fp(batch.inputs, batch.outputs.data(), batch.owners.size());
+    for (size_t row= 0; row < batch.owners.size(); row++){
+        auto [slot, request_id]= batch.owners[row];
+        slots_m[slot].taken--;
+        respond(slot, request_id, batch.outputs[row], ResponseStatus::Ok);
+    }
+    batch.owners.clear();
+    batches_run_m.fetch_add(1, std::memory_order_relaxed);
+}
+
+//One round over every channel. A request is only taken while its channel has a response record left for it, so a
+//client that stops reading responses stalls itself, never the server. Below AVX2 requests are scored one at a time
+//straight from the ring
+bool InferenceServer::poll(){
+    const bool batched= kernels().isa >= ISA::AVX2;
+    bool busy= false;
+    for (size_t s= 0; s < slots_m.size(); s++){
+        clientSlot& slot= slots_m[s];
+        SlotState state= slot.state.load(std::memory_order_acquire);
+        if (state == SlotState::Closing){
+            release(slot);
+            slot.state.store(SlotState::Free, std::memory_order_release);
+            continue;
+        }
+        if (state != SlotState::Active){
+            continue;
+        }
+        //both rings' indices live in client-writable memory, a channel that breaks them is dropped like a hang-up
+        if (!slot.requests->consistent() || !slot.responses->consistent()){
+            slot.state.store(SlotState::Closing, std::memory_order_release);
+            continue;
+        }
+
+        while (slot.taken < slot.responses->available()){
+            std::byte* record= static_cast<std::byte*>(slot.requests->front());
+            if (!record){
+                break;
+            }
+            busy= true;
+            const inferenceRequest* request= reinterpret_cast<const inferenceRequest*>(record);
+            float* features= reinterpret_cast<float*>(record + RING_RECORD_ALIGN);
+            if (request->model >= models_m.size()){
+                respond(s, request->request_id, 0.0f, ResponseStatus::BadModel);
+            }
+            else if (!batched){
+                alignedArray<float> inputs= alignedArray<float>::view(features, models_m[request->model]->featureSize());
+                respond(s, request->request_id, models_m[request->model]->inference_interp_q8_8_to_fp(inputs), ResponseStatus::Ok);
+            }
+            else{
+                modelBatch& batch= batches_m[request->model];
+                const size_t feature_size= models_m[request->model]->featureSize();
+                std::memcpy(&batch.inputs[batch.owners.size()* feature_size], features, feature_size* sizeof(float));
+                batch.owners.emplace_back(s, request->request_id);
+                slot.taken++;
+                if (batch.owners.size() == max_batch_m){
+                    slot.requests->pop();
+                    flush(request->model);
+                    continue;
+                }
+            }
+            slot.requests->pop();
+        }
+    }
+
+    for (size_t m= 0; m < batches_m.size(); m++){
+        if (!batches_m[m].owners.empty()){
+            flush(m);
+        }
+    }
+    return busy;
+}
+
+uint64_t InferenceServer::served() const{
+    return served_m.load(std::memory_order_relaxed);
+}
+
+uint64_t InferenceServer::batches() const{
+    return batches_run_m.load(std::memory_order_relaxed);
+}
+
+bool InferenceServer::pinned() const{
+    return pinned_m.load(std::memory_order_relaxed);
+}
+
+InferenceClient::InferenceClient(const std::string& socket_path):
+    socket_m(-1),
+    mapping_m(MAP_FAILED),
+    mapping_bytes_m(0),
+    next_id_m(0){
+    sockaddr_un address= socketAddress(socket_path);
+    socket_m= socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (socket_m < 0 || connect(socket_m, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0){
+        if (socket_m >= 0){
+            close(socket_m);
+        }
+        throw std::runtime_error("Cannot connect to " + socket_path);
+    }
+
+    serverHello hello{};
+    iovec payload{&hello, sizeof(hello)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))]{};
+    msghdr message{};
+    message.msg_iov= &payload;
+    message.msg_iovlen= 1;
+    message.msg_control= control;
+    message.msg_controllen= sizeof(control);
+
+    int shm= -1;
+    ssize_t received= recvmsg(socket_m, &message, MSG_CMSG_CLOEXEC);
+    cmsghdr* rights= CMSG_FIRSTHDR(&message);
+    if (rights && rights->cmsg_level == SOL_SOCKET && rights->cmsg_type == SCM_RIGHTS){
+        std::memcpy(&shm, CMSG_DATA(rights), sizeof(int));
+    }
+    if (received != static_cast<ssize_t>(sizeof(hello)) || !hello.accepted || shm < 0){
+        if (shm >= 0){
+            close(shm);
+        }
+        close(socket_m);
+        if (received == static_cast<ssize_t>(sizeof(hello)) && !hello.accepted){
+            throw std::runtime_error(socket_path + " has no free client slots");
+        }
+        throw std::runtime_error("Bad handshake from " + socket_path);
+    }
+
+    mapping_bytes_m= hello.mapping_bytes;
+    mapping_m= mmap(nullptr, mapping_bytes_m, PROT_READ | PROT_WRITE, MAP_SHARED, shm, 0);
+    close(shm);
+    if (mapping_m == MAP_FAILED){
+        close(socket_m);
+        throw std::runtime_error("Cannot map the channel from " + socket_path);
+    }
+    feature_sizes_m.assign(hello.feature_sizes, hello.feature_sizes + hello.num_models);
+    requests_m= std::make_unique<SPSCRing>(mapping_m, hello.capacity, hello.request_bytes, false);
+    responses_m= std::make_unique<SPSCRing>(static_cast<std::byte*>(mapping_m) + hello.response_offset, hello.capacity, sizeof(inferenceResponse), false);
+}
+
+InferenceClient::~InferenceClient(){
+    requests_m.reset();
+    responses_m.reset();
+    munmap(mapping_m, mapping_bytes_m);
+    close(socket_m);
+}
+
+size_t InferenceClient::numModels() const{
+    return feature_sizes_m.size();
+}
+
+size_t InferenceClient::featureSize(size_t model) const{
+    return feature_sizes_m.at(model);
+}
+
+size_t InferenceClient::capacity() const{
+    return requests_m->capacity();
+}
+
+bool InferenceClient::trySubmit(uint32_t model, const float* features, uint64_t request_id){
+    assert(model < feature_sizes_m.size() && "Unknown model");
+    std::byte* record= static_cast<std::byte*>(requests_m->claim());
+    if (!record){
+        return false;
+    }
+    inferenceRequest* request= reinterpret_cast<inferenceRequest*>(record);
+    request->request_id= request_id;
+    request->model= model;
+    std::memcpy(record + RING_RECORD_ALIGN, features, feature_sizes_m[model]* sizeof(float));
+    requests_m->push(record);
+    return true;
+}
+
+bool InferenceClient::tryResult(inferenceResponse& response){
+    const inferenceResponse* record= static_cast<const inferenceResponse*>(responses_m->front());
+    if (!record){
+        return false;
+    }
+    response= *record;
+    responses_m->pop();
+    return true;
+}
+
+float InferenceClient::score(uint32_t model, const float* features){
+    const uint64_t request_id= next_id_m++;
+    while (!trySubmit(model, features, request_id)){
+        _mm_pause();
+    }
+    inferenceResponse response;
+    for (size_t spins= 0; !tryResult(response); spins++){
+        if (spins < SERVER_IDLE_SPINS){
+            _mm_pause();
+        }
+        else{
+            std::this_thread::yield();
+        }
+    }
+    if (response.status != ResponseStatus::Ok){
+        throw std::logic_error("Server rejected model " + std::to_string(model));
+    }
+    return response.probability;
+}
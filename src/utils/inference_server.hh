@@ -0,0 +1,154 @@
+#pragma once
+#include "logistic_regession.hh"
+#include "ring_buffer.hh"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr size_t SERVER_MAX_MODELS= 64;
+
+enum class ResponseStatus: uint32_t{
+    Ok= 0,
+    BadModel
+};
+
+//Request record header, the features follow at the next cache line
+struct inferenceRequest{
+    uint64_t request_id;
+    uint32_t model;
+    uint32_t reserved;
+};
+
+struct inferenceResponse{
+    uint64_t request_id;
+    float probability;
+    ResponseStatus status;
+};
+
+//Sent over the control socket on connect, together with the channel's shared-memory fd (SCM_RIGHTS)
+//The mapping holds the request ring (client to server) followed by the response ring, both SPSCRing layouts
+struct serverHello{
+    uint32_t accepted;       //0 when every client slot is taken, no fd follows
+    uint32_t num_models;
+    uint64_t capacity;
+    uint64_t request_bytes;  //record size of the request ring, header line plus the largest model's features
+    uint64_t response_offset;
+    uint64_t mapping_bytes;
+    uint64_t feature_sizes[SERVER_MAX_MODELS];
+};
+
+//Serves the models it owns to local processes. Control runs over a Unix-domain SOCK_SEQPACKET socket: each connection
+//gets a private shared-memory channel (a request and a response SPSC ring) and closing the socket releases it.
+//One worker busy-polls every channel, groups the waiting requests by model and scores each group with one batched pass
+//over the weights (AVX2, single requests otherwise). Single requests use the same interpolated sigmoid as batches, so a
+//request gets the same result whether or not it shared a batch
+class InferenceServer{
+    private:
+        enum class SlotState: uint32_t{
+            Free,
+            Active,
+            Closing //socket closed or the ring indices corrupted, the worker unmaps it and frees the slot
+        };
+
+        struct alignas(64) clientSlot{
+            std::atomic<SlotState> state;
+            int socket;
+            void* mapping;
+            std::unique_ptr<SPSCRing> requests;
+            std::unique_ptr<SPSCRing> responses;
+            size_t taken; //requests taken this round, each one holds a response record
+        };
+
+        //Requests for one model waiting for the next flush, features copied row-major for the batch kernel
+        struct modelBatch{
+            alignedArray<float> inputs;
+            alignedArray<float> outputs;
+            std::vector<std::pair<size_t, uint64_t>> owners; //(slot, request id) per row
+        };
+
+        const std::string socket_path_m;
+        const size_t capacity_m;
+        const size_t max_batch_m;
+        const int cpu_m;
+
+        std::vector<std::unique_ptr<SGDLogisticRegression>> models_m;
+        std::vector<modelBatch> batches_m;
+        std::vector<clientSlot> slots_m;
+        size_t request_bytes_m;
+        size_t response_offset_m;
+        size_t mapping_bytes_m;
+        int listen_m;
+        uint64_t channels_opened_m;
+
+        std::thread control_m;
+        std::thread worker_m;
+        std::atomic<bool> stop_m;
+        alignas(64) std::atomic<uint64_t> served_m;
+        std::atomic<uint64_t> batches_run_m;
+        std::atomic<bool> pinned_m;
+
+        size_t addModel(std::unique_ptr<SGDLogisticRegression> model);
+        void control();
+        void accept();
+        void worker();
+        bool poll();
+        void flush(size_t model);
+        void respond(size_t slot, uint64_t request_id, float probability, ResponseStatus status);
+        void release(clientSlot& slot);
+
+    public:
+        //capacity is per ring (rounded up to a power of two), max_batch caps the requests scored in one pass, cpu indexes
+        //the allowed CPUs (allowedCPU) and -1 leaves the worker unpinned
+        InferenceServer(const std::string& socket_path, size_t max_clients= 16, size_t capacity= 256, size_t max_batch= 16, int cpu= -1);
+        ~InferenceServer();
+
+        InferenceServer(const InferenceServer&)= delete;
+        InferenceServer& operator=(const InferenceServer&)= delete;
+
+        //Models are added before start(), ids follow the order they were added in
+        size_t addModel(size_t feature_size);
+        size_t loadModel(const std::string& path);
+        //Only touch a model before start() or after stop()
+        SGDLogisticRegression& model(size_t id);
+
+        //Binds the socket (replacing a stale one) and starts the control and worker threads, throws on socket errors
+        void start();
+        void stop();
+
+        uint64_t served() const;
+        uint64_t batches() const;
+        bool pinned() const; //whether the worker got its CPU, false until it has started
+};
+
+//One connection to an InferenceServer, used by one thread. Requests are pipelined: trySubmit up to capacity() of them
+//and match the responses from tryResult by request id (requests to different models can come back out of order)
+class InferenceClient{
+    private:
+        int socket_m;
+        void* mapping_m;
+        size_t mapping_bytes_m;
+        std::vector<size_t> feature_sizes_m;
+        std::unique_ptr<SPSCRing> requests_m;
+        std::unique_ptr<SPSCRing> responses_m;
+        uint64_t next_id_m;
+
+    public:
+        //Throws runtime_error when the server is unreachable or full
+        explicit InferenceClient(const std::string& socket_path);
+        ~InferenceClient();
+
+        InferenceClient(const InferenceClient&)= delete;
+        InferenceClient& operator=(const InferenceClient&)= delete;
+
+        size_t numModels() const;
+        size_t featureSize(size_t model) const;
+        size_t capacity() const;
+
+        //false when the request ring is full
+        bool trySubmit(uint32_t model, const float* features, uint64_t request_id);
+        bool tryResult(inferenceResponse& response);
+        //Blocking round trip, only while no pipelined requests are outstanding
+        float score(uint32_t model, const float* features);
+};
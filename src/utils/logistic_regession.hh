@@ -1,30 +1,98 @@
+#pragma once
 #include "avx.hh"
 #include "containers.hh"
+#include "dispatch.hh"
+#include "model_file.hh"
+#include <memory>
+#include <optional>
+
+enum class Optimizer{
+    SGD,
+    AdamW
+};
 
 class SGDLogisticRegression{
     private:
+        const KernelTable& kernels_m;
         const size_t feature_size_m;
+        const size_t batch_stride_m;
         
         float learning_rate_m;
         float threshold_m;
+        Optimizer optimizer_m;
+        std::optional<AdamWParams> adamw_m;
         
         alignedArray<float> weights_m;
         alignedArray<float> inputs_m;
         alignedArray<int16_t> weights_q8_8_m;
         alignedArray<int16_t> inputs_q8_8_m;
+        alignedArray<int16_t> batch_q8_8_m;
+        alignedArray<int32_t> batch_q16_16_m;
+        alignedArray<int8_t> weights_int8_m;
+        alignedArray<int8_t> inputs_int8_m;
+        alignedArray<float> weights_int8_scales_m;
+        alignedArray<float> inputs_int8_scales_m;
+        float weights_int8_scale_m;
+        float inputs_int8_scale_m; //0 until calibrated, inputs are then scaled per sample
+        bool int8_blocked_m;
+        bool int8_dirty_m;
+        std::shared_ptr<modelMapping> mapping_m; //keeps mapped weights alive, null for heap models
+        ArrayAllocator* allocator_m;              //source of the model's arrays, null for aligned_alloc
 
+        int32_t logit_q16_16(alignedArray<float>& inputs);
         int16_t inference_q8_8(alignedArray<float>& inputs);
         void initWeights();
+        void reserveBatch(size_t batch_size);
+        void requantizeInt8();
+
+        //mapped_weights/mapped_q8_8 null allocates and Xavier-initialises, otherwise the model runs on them in place
+        SGDLogisticRegression(size_t feature_size, float learning_rate, float threshold, size_t alignment, ArrayAllocator* allocator, float* mapped_weights, int16_t* mapped_q8_8);
         
     public:
         
-        SGDLogisticRegression(size_t feature_size, float learning_rate= 0.01f, float threshold= 0.0f, size_t alignment= 32);
+        //allocator (see allocators.hh) must outlive the model, e.g. a HugePageAllocator for very wide models or one
+        //PoolAllocator shared by many small ones
+        SGDLogisticRegression(size_t feature_size, float learning_rate= 0.01f, float threshold= 0.0f, size_t alignment= ARRAY_DEFAULT_ALIGNMENT, ArrayAllocator* allocator= nullptr);
+        //Zero-copy load: weights point into the mapping, models sharing one mapping share (and see each other's updates to) the weights
+        explicit SGDLogisticRegression(std::shared_ptr<modelMapping> mapping, size_t alignment= ARRAY_DEFAULT_ALIGNMENT);
+
+        void save(const std::string& path) const;
         
         void setThreshold(float val);
         void setLearningRate(float val);
         void setInputs(float* x);
+        //AdamW captures the current learning rate and starts from zeroed moments
+        void setOptimizer(Optimizer optimizer);
+        //Copies feature_size weights in and refreshes the quantized copies
+        void setWeights(float* w);
+        const float* weights() const;
+        const int16_t* weights_q8_8() const;
+        size_t featureSize() const;
         
         float inference_fp(alignedArray<float>& inputs);
         float inference_q8_8_to_fp(alignedArray<float>& inputs);
+        //Q8.8 logit through the interpolated sigmoid of inference_batch_q8_8_to_fp, for single samples on any tier
+        float inference_interp_q8_8_to_fp(alignedArray<float>& inputs);
+        //inputs holds batch_size row-major samples, outputs receives one probability per sample
+        //Batched activations use the interpolated sigmoid tables, Q8.8 keeps all 16 fractional bits of each logit
+        void inference_batch_fp(alignedArray<float>& inputs, float* outputs, size_t batch_size);
+        void inference_batch_q8_8_to_fp(alignedArray<float>& inputs, float* outputs, size_t batch_size);
         void update_weights(float prediction, float label);
+        //One fused pass over the weights for batch_size (input, prediction, label) triples, SGD only
+        void update_weights_batch(alignedArray<float>& inputs, float* predictions, float* labels, size_t batch_size);
+
+        float inference_sparse_fp(sparseArray& inputs);
+        float inference_sparse_q8_8_to_fp(sparseArray& inputs);
+        void inference_sparse_batch_fp(sparseBatch& inputs, float* outputs);
+        void inference_sparse_batch_q8_8_to_fp(sparseBatch& inputs, float* outputs);
+        //SGD only, touches just the active weights and their Q8.8 copies
+        void update_weights_sparse(sparseArray& inputs, float prediction, float label);
+
+        //One online step, same result as setInputs + inference_q8_8_to_fp + update_weights
+        //x is read once to predict and once to update (refreshing Q8.8 in that pass), inputs_m is left untouched
+        float predict_and_learn(alignedArray<float>& inputs, float label);
+
+        //Static activation scales from sample_count row-major samples, per_block uses one scale per INT8_BLOCK features (AVX2 only)
+        void calibrate_int8(alignedArray<float>& samples, size_t sample_count, bool per_block= false);
+        float inference_int8_to_fp(alignedArray<float>& inputs);
 };
\ No newline at end of file
@@ -1,17 +1,45 @@
 #include "logistic_regession.hh"
 #include "tools.hh"
 #include "avx.hh"
+#include "dispatch.hh"
 #include <random>
 
-SGDLogisticRegression::SGDLogisticRegression(size_t feature_size, float learning_rate, float threshold, size_t alignment)
-    :feature_size_m(feature_size),
+SGDLogisticRegression::SGDLogisticRegression(size_t feature_size, float learning_rate, float threshold, size_t alignment, ArrayAllocator* allocator)
+    :SGDLogisticRegression(feature_size, learning_rate, threshold, alignment, allocator, nullptr, nullptr){}
+
+SGDLogisticRegression::SGDLogisticRegression(std::shared_ptr<modelMapping> mapping, size_t alignment)
+    :SGDLogisticRegression(mapping->header().feature_size, mapping->header().learning_rate, mapping->header().threshold, alignment, nullptr, mapping->weights(), mapping->weights_q8_8()){
+    mapping_m= std::move(mapping);
+}
+
+SGDLogisticRegression::SGDLogisticRegression(size_t feature_size, float learning_rate, float threshold, size_t alignment, ArrayAllocator* allocator, float* mapped_weights, int16_t* mapped_q8_8)
+    :kernels_m(kernels()),
+    feature_size_m(feature_size),
+    batch_stride_m((feature_size + 15) & ~size_t(15)),
     learning_rate_m(learning_rate),
     threshold_m(threshold),
-    weights_m(alignment, feature_size),
-    inputs_m(alignment, feature_size),
-    weights_q8_8_m(alignment, feature_size),
-    inputs_q8_8_m(alignment, feature_size){
-    initWeights();
+    optimizer_m(Optimizer::SGD),
+    weights_m(mapped_weights? alignedArray<float>::view(mapped_weights, feature_size): alignedArray<float>(alignment, feature_size, allocator)),
+    inputs_m(alignment, feature_size, allocator),
+    //one element of slack for the 32-bit sparse gathers
+    weights_q8_8_m(mapped_q8_8? alignedArray<int16_t>::view(mapped_q8_8, feature_size + 1): alignedArray<int16_t>(alignment, feature_size + 1, allocator)),
+    inputs_q8_8_m(alignment, feature_size, allocator),
+    weights_int8_m(alignment, feature_size, allocator),
+    inputs_int8_m(alignment, feature_size, allocator),
+    weights_int8_scales_m(ARRAY_DEFAULT_ALIGNMENT, (feature_size + INT8_BLOCK - 1)/ INT8_BLOCK, allocator),
+    inputs_int8_scales_m(ARRAY_DEFAULT_ALIGNMENT, (feature_size + INT8_BLOCK - 1)/ INT8_BLOCK, allocator),
+    weights_int8_scale_m(1.0f),
+    inputs_int8_scale_m(0.0f),
+    int8_blocked_m(false),
+    int8_dirty_m(true),
+    allocator_m(allocator){
+    if (!mapped_weights){
+        initWeights();
+    }
+}
+
+void SGDLogisticRegression::save(const std::string& path) const{
+    writeModelFile(path, feature_size_m, learning_rate_m, threshold_m, weights_m.data(), weights_q8_8_m.data());
 }
 
 void SGDLogisticRegression::setThreshold(float threshold){
@@ -22,39 +50,237 @@ void SGDLogisticRegression::setLearningRate(float learning_rate){
     learning_rate_m= learning_rate;
 }
 
-void SGDLogisticRegression::setInputs(float* x){
-    size_t i= 0;
-    for (; i + 16 <= feature_size_m; i += 16){
-        _mm_prefetch(reinterpret_cast<const char*>(&x[i + 32]), _MM_HINT_T0);
+void SGDLogisticRegression::setOptimizer(Optimizer optimizer){
+    if (optimizer == Optimizer::AdamW){
+        requireISA(ISA::AVX2, "AdamW");
+    }
+    optimizer_m= optimizer;
+    if (optimizer == Optimizer::AdamW){
+        adamw_m.emplace(feature_size_m, learning_rate_m);
+    }
+    else{
+        adamw_m.reset();
+    }
+}
 
-        __m256 vec1= _mm256_loadu_ps(&x[i]);
-        __m256 vec2= _mm256_loadu_ps(&x[i + 8]);
+void SGDLogisticRegression::setWeights(float* w){
+    std::memcpy(weights_m.data(), w, feature_size_m* sizeof(float));
+    kernels_m.quantize8_8_inplace(weights_m.data(), weights_q8_8_m.data(), feature_size_m);
+    int8_dirty_m= true;
+}
 
-        _mm256_store_ps(&inputs_m[i], vec1);
-        _mm256_store_ps(&inputs_m[i+ 8], vec2);
-    }
+const float* SGDLogisticRegression::weights() const{
+    return weights_m.data();
+}
 
-    for(; i < feature_size_m; i++ ){
-        inputs_m[i]= x[i];
+const int16_t* SGDLogisticRegression::weights_q8_8() const{
+    return weights_q8_8_m.data();
+}
+
+size_t SGDLogisticRegression::featureSize() const{
+    return feature_size_m;
+}
+
+//plain copy so this translation unit stays baseline ISA, memcpy picks its own vector width
+void SGDLogisticRegression::setInputs(float* x){
+    std::memcpy(inputs_m.data(), x, feature_size_m* sizeof(float));
+}
+
+int32_t SGDLogisticRegression::logit_q16_16(alignedArray<float>& inputs){
+    kernels_m.quantize8_8_inplace(inputs.data(), inputs_q8_8_m.data(), feature_size_m);
+    if (feature_size_m > Q8_8_NARROW_MAX_FEATURES){
+        return saturate_q16_16(kernels_m.dotproduct_q8_8_wide(weights_q8_8_m.data(), inputs_q8_8_m.data(), feature_size_m));
     }
+    return kernels_m.dotproduct_q8_8(weights_q8_8_m.data(), inputs_q8_8_m.data(), feature_size_m);
 }
 
 int16_t SGDLogisticRegression::inference_q8_8(alignedArray<float>& inputs){
-    quantize8_8_inplace(inputs.data(), inputs_q8_8_m.data(), feature_size_m);
-    return sigmoidApprox_q16_16_to_q8_8(dotproduct_q8_8(weights_q8_8_m.data(), inputs_q8_8_m.data(), feature_size_m));
+    return sigmoidApprox_q16_16_to_q8_8(logit_q16_16(inputs));
 }
 
 float SGDLogisticRegression::inference_fp(alignedArray<float>& inputs){
-    return q8_8_to_float(sigmoid_fp_to_q8_8(dotproduct_fp(weights_m.data(), inputs.data(), feature_size_m)));
+    return q8_8_to_float(sigmoid_fp_to_q8_8(kernels_m.dotproduct_fp(weights_m.data(), inputs.data(), feature_size_m)));
 }
 
 float SGDLogisticRegression::inference_q8_8_to_fp(alignedArray<float>& inputs){
     return q8_8_to_float(inference_q8_8(inputs));
 }
 
+float SGDLogisticRegression::inference_interp_q8_8_to_fp(alignedArray<float>& inputs){
+    return q8_8_to_float(sigmoidInterp_q16_16_to_q8_8(logit_q16_16(inputs)));
+}
+
+void SGDLogisticRegression::reserveBatch(size_t batch_size){
+    if (batch_q16_16_m.size() >= batch_size){
+        return;
+    }
+    batch_q8_8_m= alignedArray<int16_t>(ARRAY_DEFAULT_ALIGNMENT, batch_size* batch_stride_m, allocator_m);
+    batch_q16_16_m= alignedArray<int32_t>(ARRAY_DEFAULT_ALIGNMENT, batch_size, allocator_m);
+}
+
+void SGDLogisticRegression::inference_batch_fp(alignedArray<float>& inputs, float* outputs, size_t batch_size){
+    assert(inputs.size() >= batch_size* feature_size_m && "Batch larger than inputs");
+    requireISA(ISA::AVX2, "Batched inference");
+    dotproduct_fp_batch(weights_m.data(), inputs.data(), outputs, batch_size, feature_size_m);
+    sigmoid_batch_fp(outputs, outputs, batch_size);
+    for (size_t n= 0; n < batch_size; n++){
+        outputs[n]= q8_8_to_float(float_to_q8_8(outputs[n]));
+    }
+}
+
+void SGDLogisticRegression::inference_batch_q8_8_to_fp(alignedArray<float>& inputs, float* outputs, size_t batch_size){
+    assert(inputs.size() >= batch_size* feature_size_m && "Batch larger than inputs");
+    requireISA(ISA::AVX2, "Batched inference");
+    reserveBatch(batch_size);
+    quantize8_8_rows(inputs.data(), batch_q8_8_m.data(), batch_size, feature_size_m, batch_stride_m);
+    //the batch kernel accumulates in int32 like dotproduct_q8_8, wide models score row by row like inference_q8_8
+    if (feature_size_m > Q8_8_NARROW_MAX_FEATURES){
+        for (size_t n= 0; n < batch_size; n++){
+            batch_q16_16_m[n]= saturate_q16_16(kernels_m.dotproduct_q8_8_wide(weights_q8_8_m.data(), &batch_q8_8_m[n* batch_stride_m], feature_size_m));
+        }
+    }
+    else{
+        dotproduct_q8_8_batch(weights_q8_8_m.data(), batch_q8_8_m.data(), batch_q16_16_m.data(), batch_size, feature_size_m, batch_stride_m);
+    }
+    sigmoid_batch_q16_16_to_q8_8(batch_q16_16_m.data(), batch_q8_8_m.data(), batch_size);
+    for (size_t n= 0; n < batch_size; n++){
+        outputs[n]= q8_8_to_float(batch_q8_8_m[n]);
+    }
+}
+
+//SGD refreshes Q8.8 in the same pass and skips the blocks of zero inputs, AdamW moves every weight so it requantizes all
 void SGDLogisticRegression::update_weights(float prediction, float label) {
-    sgd_inplace(prediction, label, weights_m.data(), inputs_m.data(), feature_size_m, learning_rate_m);
-    quantize8_8_inplace(weights_m.data(), weights_q8_8_m.data(), feature_size_m);
+    if (optimizer_m == Optimizer::AdamW){
+        adamW_inplace(float_to_q8_8(prediction), label, weights_m.data(), inputs_m.data(), feature_size_m, *adamw_m);
+        kernels_m.quantize8_8_inplace(weights_m.data(), weights_q8_8_m.data(), feature_size_m);
+    }
+    else{
+        kernels_m.sgd_q8_8_inplace(float_to_q8_8(prediction), label, weights_m.data(), weights_q8_8_m.data(), inputs_m.data(), feature_size_m, learning_rate_m);
+    }
+    int8_dirty_m= true;
+}
+
+void SGDLogisticRegression::update_weights_batch(alignedArray<float>& inputs, float* predictions, float* labels, size_t batch_size){
+    assert(inputs.size() >= batch_size* feature_size_m && "Batch larger than inputs");
+    if (optimizer_m != Optimizer::SGD){
+        throw std::logic_error("Batched updates require Optimizer::SGD");
+    }
+    requireISA(ISA::AVX2, "Batched updates");
+    sgd_batch_inplace(predictions, labels, weights_m.data(), weights_q8_8_m.data(), inputs.data(), batch_size, feature_size_m, learning_rate_m);
+    int8_dirty_m= true;
+}
+
+float SGDLogisticRegression::inference_sparse_fp(sparseArray& inputs){
+    requireISA(ISA::AVX2, "Sparse inference");
+    return q8_8_to_float(sigmoid_fp_to_q8_8(dotproduct_sparse_fp(weights_m.data(), inputs.indices.data(), inputs.values.data(), inputs.nnz)));
+}
+
+float SGDLogisticRegression::inference_sparse_q8_8_to_fp(sparseArray& inputs){
+    requireISA(ISA::AVX2, "Sparse inference");
+    return q8_8_to_float(sigmoidApprox_q16_16_to_q8_8(dotproduct_sparse_q8_8(weights_q8_8_m.data(), inputs.indices.data(), inputs.values.data(), inputs.nnz)));
+}
+
+void SGDLogisticRegression::inference_sparse_batch_fp(sparseBatch& inputs, float* outputs){
+    requireISA(ISA::AVX2, "Sparse inference");
+    dotproduct_sparse_fp_batch(weights_m.data(), inputs.row_offsets.data(), inputs.indices.data(), inputs.values.data(), outputs, inputs.rows);
+    sigmoid_batch_fp(outputs, outputs, inputs.rows);
+    for (size_t n= 0; n < inputs.rows; n++){
+        outputs[n]= q8_8_to_float(float_to_q8_8(outputs[n]));
+    }
+}
+
+void SGDLogisticRegression::inference_sparse_batch_q8_8_to_fp(sparseBatch& inputs, float* outputs){
+    requireISA(ISA::AVX2, "Sparse inference");
+    reserveBatch(inputs.rows);
+    dotproduct_sparse_q8_8_batch(weights_q8_8_m.data(), inputs.row_offsets.data(), inputs.indices.data(), inputs.values.data(), batch_q16_16_m.data(), inputs.rows);
+    sigmoid_batch_q16_16_to_q8_8(batch_q16_16_m.data(), batch_q8_8_m.data(), inputs.rows);
+    for (size_t n= 0; n < inputs.rows; n++){
+        outputs[n]= q8_8_to_float(batch_q8_8_m[n]);
+    }
+}
+
+void SGDLogisticRegression::update_weights_sparse(sparseArray& inputs, float prediction, float label){
+    if (optimizer_m != Optimizer::SGD){
+        throw std::logic_error("Sparse updates require Optimizer::SGD");
+    }
+    requireISA(ISA::AVX2, "Sparse updates");
+    sgd_sparse_inplace(float_to_q8_8(prediction), label, weights_m.data(), weights_q8_8_m.data(), inputs.indices.data(), inputs.values.data(), inputs.nnz, learning_rate_m);
+    int8_dirty_m= true;
+}
+
+//The fused kernels are AVX2-only and accumulate in int32, AdamW needs inputs_m for its moments
+float SGDLogisticRegression::predict_and_learn(alignedArray<float>& inputs, float label){
+    if (kernels_m.isa < ISA::AVX2 || optimizer_m != Optimizer::SGD || feature_size_m > Q8_8_NARROW_MAX_FEATURES){
+        setInputs(inputs.data());
+        float prediction= inference_q8_8_to_fp(inputs);
+        update_weights(prediction, label);
+        return prediction;
+    }
+
+    int16_t prediction= sigmoidApprox_q16_16_to_q8_8(dotproduct_q8_8_quantize(weights_q8_8_m.data(), inputs.data(), feature_size_m));
+    sgd_q8_8_inplace(prediction, label, weights_m.data(), weights_q8_8_m.data(), inputs.data(), feature_size_m, learning_rate_m);
+    int8_dirty_m= true;
+    return q8_8_to_float(prediction);
+}
+
+//Weight scales follow the weights, rebuilt lazily after any update
+void SGDLogisticRegression::requantizeInt8(){
+    if (int8_blocked_m){
+        absmax_scales_int8_blocked(weights_m.data(), weights_int8_scales_m.data(), feature_size_m);
+        quantize_int8_blocked(weights_m.data(), weights_int8_m.data(), weights_int8_scales_m.data(), feature_size_m);
+    }
+    else{
+        weights_int8_scale_m= kernels_m.absmax_scale_int8(weights_m.data(), feature_size_m);
+        kernels_m.quantize_int8(weights_m.data(), weights_int8_m.data(), feature_size_m, weights_int8_scale_m);
+    }
+    int8_dirty_m= false;
+}
+
+void SGDLogisticRegression::calibrate_int8(alignedArray<float>& samples, size_t sample_count, bool per_block){
+    assert(samples.size() >= sample_count* feature_size_m && "Calibration set larger than samples");
+    if (per_block){
+        requireISA(ISA::AVX2, "Per-block INT8");
+    }
+    size_t blocks= inputs_int8_scales_m.size();
+    alignedArray<float> sample_scales(blocks);
+
+    int8_blocked_m= per_block;
+    inputs_int8_scale_m= 0.0f;
+    for (size_t b= 0; b < blocks; b++){
+        inputs_int8_scales_m[b]= 0.0f;
+    }
+
+    for (size_t n= 0; n < sample_count; n++){
+        float* sample= &samples[n* feature_size_m];
+        if (per_block){
+            absmax_scales_int8_blocked(sample, sample_scales.data(), feature_size_m);
+            for (size_t b= 0; b < blocks; b++){
+                inputs_int8_scales_m[b]= std::max(inputs_int8_scales_m[b], sample_scales[b]);
+            }
+        }
+        else{
+            inputs_int8_scale_m= std::max(inputs_int8_scale_m, kernels_m.absmax_scale_int8(sample, feature_size_m));
+        }
+    }
+    int8_dirty_m= true;
+}
+
+float SGDLogisticRegression::inference_int8_to_fp(alignedArray<float>& inputs){
+    if (int8_dirty_m){
+        requantizeInt8();
+    }
+
+    float logit;
+    if (int8_blocked_m){
+        quantize_int8_blocked(inputs.data(), inputs_int8_m.data(), inputs_int8_scales_m.data(), feature_size_m);
+        logit= dotproduct_int8_blocked(weights_int8_m.data(), weights_int8_scales_m.data(), inputs_int8_m.data(), inputs_int8_scales_m.data(), feature_size_m);
+    }
+    else{
+        float x_scale= (inputs_int8_scale_m > 0.0f)? inputs_int8_scale_m: kernels_m.absmax_scale_int8(inputs.data(), feature_size_m);
+        kernels_m.quantize_int8(inputs.data(), inputs_int8_m.data(), feature_size_m, x_scale);
+        logit= kernels_m.dotproduct_int8(weights_int8_m.data(), inputs_int8_m.data(), feature_size_m)* weights_int8_scale_m* x_scale;
+    }
+    return q8_8_to_float(sigmoidApprox_fp_to_q8_8(logit));
 }
 
 //xavier init
@@ -69,5 +295,7 @@ void SGDLogisticRegression::initWeights(){
         weights_m[i]= dist(gen);
     }
 
-    quantize8_8_inplace(weights_m.data(), weights_q8_8_m.data(), feature_size_m);
+    kernels_m.quantize8_8_inplace(weights_m.data(), weights_q8_8_m.data(), feature_size_m);
+    weights_q8_8_m[feature_size_m]= 0;
+    int8_dirty_m= true;
 }
@@ -0,0 +1,257 @@
+#include "model_bank.hh"
+#include "tools.hh"
+#include <cassert>
+#include <random>
+
+//Interleaved tiles: FP32 w[f * BANK_TILE + k], Q8.8 pairs w[(f / 2) * 2 * BANK_TILE + 2k + (f & 1)] (softmax_logits_* layout)
+ModelBank::ModelBank(size_t num_models, size_t feature_size, BankLayout layout, float learning_rate)
+    :kernels_m(kernels()),
+    num_models_m(num_models),
+    feature_size_m(feature_size),
+    layout_m(layout),
+    model_stride_m((feature_size + 15) & ~size_t(15)),
+    num_tiles_m((num_models + BANK_TILE - 1)/ BANK_TILE),
+    learning_rate_m(learning_rate),
+    weights_m(64, layout == BankLayout::ModelMajor? num_models* model_stride_m: num_tiles_m* feature_size* BANK_TILE),
+    weights_q8_8_m(64, layout == BankLayout::ModelMajor? num_models* model_stride_m: num_tiles_m* ((feature_size + 1)/ 2)* 2* BANK_TILE),
+    inputs_q8_8_m(64, model_stride_m),
+    logits_m(64, num_tiles_m* BANK_TILE),
+    logits_q16_16_m(64, num_tiles_m* BANK_TILE),
+    tile_marks_m(num_tiles_m),
+    model_m(64, model_stride_m),
+    model_q8_8_m(64, model_stride_m){
+    assert(num_models > 0 && feature_size > 0 && "Empty model bank");
+    assert(feature_size <= Q8_8_NARROW_MAX_FEATURES && "Model banks hold small models, Q8.8 logits accumulate in int32");
+    if (layout == BankLayout::Interleaved){
+        requireISA(ISA::AVX2, "Interleaved banks");
+    }
+
+    //padding features and the padding models of the last tile stay zero
+    std::memset(weights_m.data(), 0, weights_m.size()* sizeof(float));
+    std::memset(weights_q8_8_m.data(), 0, weights_q8_8_m.size()* sizeof(int16_t));
+    std::memset(inputs_q8_8_m.data(), 0, inputs_q8_8_m.size()* sizeof(int16_t));
+    std::memset(model_m.data(), 0, model_m.size()* sizeof(float));
+    std::memset(tile_marks_m.data(), 0, tile_marks_m.size());
+    initWeights();
+}
+
+size_t ModelBank::numModels() const{
+    return num_models_m;
+}
+
+size_t ModelBank::featureSize() const{
+    return feature_size_m;
+}
+
+BankLayout ModelBank::layout() const{
+    return layout_m;
+}
+
+void ModelBank::setLearningRate(float learning_rate){
+    learning_rate_m= learning_rate;
+}
+
+float* ModelBank::modelWeights(size_t model){
+    return &weights_m[model* model_stride_m];
+}
+
+int16_t* ModelBank::modelWeights_q8_8(size_t model){
+    return &weights_q8_8_m[model* model_stride_m];
+}
+
+void ModelBank::gather(size_t model){
+    const float* tile= &weights_m[(model/ BANK_TILE)* feature_size_m* BANK_TILE];
+    const int16_t* tile_q8_8= &weights_q8_8_m[(model/ BANK_TILE)* ((feature_size_m + 1)/ 2)* 2* BANK_TILE];
+    const size_t k= model % BANK_TILE;
+    for (size_t f= 0; f < feature_size_m; f++){
+        model_m[f]= tile[f* BANK_TILE + k];
+        model_q8_8_m[f]= tile_q8_8[(f/ 2)* 2* BANK_TILE + 2* k + (f & 1)];
+    }
+}
+
+void ModelBank::scatter(size_t model){
+    float* tile= &weights_m[(model/ BANK_TILE)* feature_size_m* BANK_TILE];
+    int16_t* tile_q8_8= &weights_q8_8_m[(model/ BANK_TILE)* ((feature_size_m + 1)/ 2)* 2* BANK_TILE];
+    const size_t k= model % BANK_TILE;
+    for (size_t f= 0; f < feature_size_m; f++){
+        tile[f* BANK_TILE + k]= model_m[f];
+        tile_q8_8[(f/ 2)* 2* BANK_TILE + 2* k + (f & 1)]= model_q8_8_m[f];
+    }
+}
+
+void ModelBank::setWeights(size_t model, const float* w){
+    assert(model < num_models_m && "Model out of range");
+    if (layout_m == BankLayout::ModelMajor){
+        std::memcpy(modelWeights(model), w, feature_size_m* sizeof(float));
+        kernels_m.quantize8_8_inplace(modelWeights(model), modelWeights_q8_8(model), feature_size_m);
+        return;
+    }
+    std::memcpy(model_m.data(), w, feature_size_m* sizeof(float));
+    kernels_m.quantize8_8_inplace(model_m.data(), model_q8_8_m.data(), feature_size_m);
+    scatter(model);
+}
+
+void ModelBank::getWeights(size_t model, float* w) const{
+    assert(model < num_models_m && "Model out of range");
+    if (layout_m == BankLayout::ModelMajor){
+        std::memcpy(w, &weights_m[model* model_stride_m], feature_size_m* sizeof(float));
+        return;
+    }
+    const float* tile= &weights_m[(model/ BANK_TILE)* feature_size_m* BANK_TILE];
+    for (size_t f= 0; f < feature_size_m; f++){
+        w[f]= tile[f* BANK_TILE + model % BANK_TILE];
+    }
+}
+
+//Element feature_size stays zero, it is the odd feature's partner in the Q8.8 pairs
+void ModelBank::quantizeInputs(alignedArray<float>& inputs){
+    kernels_m.quantize8_8_inplace(inputs.data(), inputs_q8_8_m.data(), feature_size_m);
+}
+
+//Interleaved only, logits of the tile's BANK_TILE models land at logits_m[tile * BANK_TILE]
+void ModelBank::scoreTile(size_t tile, alignedArray<float>& inputs, bool q8_8){
+    if (q8_8){
+        softmax_logits_q8_8(&weights_q8_8_m[tile* ((feature_size_m + 1)/ 2)* 2* BANK_TILE], inputs_q8_8_m.data(), &logits_q16_16_m[tile* BANK_TILE], BANK_TILE, feature_size_m);
+    }
+    else{
+        softmax_logits_fp(&weights_m[tile* feature_size_m* BANK_TILE], inputs.data(), &logits_m[tile* BANK_TILE], BANK_TILE, feature_size_m);
+    }
+}
+
+float ModelBank::inference_fp(size_t model, alignedArray<float>& inputs){
+    assert(model < num_models_m && "Model out of range");
+    if (layout_m == BankLayout::ModelMajor){
+        return q8_8_to_float(sigmoid_fp_to_q8_8(kernels_m.dotproduct_fp(modelWeights(model), inputs.data(), feature_size_m)));
+    }
+    scoreTile(model/ BANK_TILE, inputs, false);
+    return q8_8_to_float(sigmoid_fp_to_q8_8(logits_m[model]));
+}
+
+float ModelBank::inference_q8_8_to_fp(size_t model, alignedArray<float>& inputs){
+    assert(model < num_models_m && "Model out of range");
+    quantizeInputs(inputs);
+    if (layout_m == BankLayout::ModelMajor){
+        return q8_8_to_float(sigmoidApprox_q16_16_to_q8_8(kernels_m.dotproduct_q8_8(modelWeights_q8_8(model), inputs_q8_8_m.data(), feature_size_m)));
+    }
+    scoreTile(model/ BANK_TILE, inputs, true);
+    return q8_8_to_float(sigmoidApprox_q16_16_to_q8_8(logits_q16_16_m[model]));
+}
+
+void ModelBank::inference_all_fp(alignedArray<float>& inputs, float* probabilities){
+    if (layout_m == BankLayout::ModelMajor){
+        for (size_t m= 0; m < num_models_m; m++){
+            probabilities[m]= q8_8_to_float(sigmoid_fp_to_q8_8(kernels_m.dotproduct_fp(modelWeights(m), inputs.data(), feature_size_m)));
+        }
+        return;
+    }
+    for (size_t tile= 0; tile < num_tiles_m; tile++){
+        scoreTile(tile, inputs, false);
+    }
+    for (size_t m= 0; m < num_models_m; m++){
+        probabilities[m]= q8_8_to_float(sigmoid_fp_to_q8_8(logits_m[m]));
+    }
+}
+
+void ModelBank::inference_all_q8_8_to_fp(alignedArray<float>& inputs, float* probabilities){
+    quantizeInputs(inputs);
+    if (layout_m == BankLayout::ModelMajor){
+        for (size_t m= 0; m < num_models_m; m++){
+            probabilities[m]= q8_8_to_float(sigmoidApprox_q16_16_to_q8_8(kernels_m.dotproduct_q8_8(modelWeights_q8_8(m), inputs_q8_8_m.data(), feature_size_m)));
+        }
+        return;
+    }
+    for (size_t tile= 0; tile < num_tiles_m; tile++){
+        scoreTile(tile, inputs, true);
+    }
+    for (size_t m= 0; m < num_models_m; m++){
+        probabilities[m]= q8_8_to_float(sigmoidApprox_q16_16_to_q8_8(logits_q16_16_m[m]));
+    }
+}
+
+//Requested models come in any order, so the next one is prefetched while the current one is scored
+template <typename T>
+static inline void prefetchModel(const T* weights, size_t size){
+    const char* begin= reinterpret_cast<const char*>(weights);
+    for (size_t offset= 0; offset < size* sizeof(T); offset+= 64){
+        _mm_prefetch(begin + offset, _MM_HINT_T0);
+    }
+}
+
+void ModelBank::inference_subset_fp(alignedArray<float>& inputs, const size_t* models, size_t count, float* probabilities){
+    if (layout_m == BankLayout::ModelMajor){
+        for (size_t i= 0; i < count; i++){
+            assert(models[i] < num_models_m && "Model out of range");
+            if (i + 1 < count){
+                prefetchModel(modelWeights(models[i + 1]), feature_size_m);
+            }
+            probabilities[i]= q8_8_to_float(sigmoid_fp_to_q8_8(kernels_m.dotproduct_fp(modelWeights(models[i]), inputs.data(), feature_size_m)));
+        }
+        return;
+    }
+    for (size_t i= 0; i < count; i++){
+        assert(models[i] < num_models_m && "Model out of range");
+        uint8_t& marked= tile_marks_m[models[i]/ BANK_TILE];
+        if (!marked){
+            scoreTile(models[i]/ BANK_TILE, inputs, false);
+            marked= 1;
+        }
+    }
+    for (size_t i= 0; i < count; i++){
+        probabilities[i]= q8_8_to_float(sigmoid_fp_to_q8_8(logits_m[models[i]]));
+        tile_marks_m[models[i]/ BANK_TILE]= 0;
+    }
+}
+
+void ModelBank::inference_subset_q8_8_to_fp(alignedArray<float>& inputs, const size_t* models, size_t count, float* probabilities){
+    quantizeInputs(inputs);
+    if (layout_m == BankLayout::ModelMajor){
+        for (size_t i= 0; i < count; i++){
+            assert(models[i] < num_models_m && "Model out of range");
+            if (i + 1 < count){
+                prefetchModel(modelWeights_q8_8(models[i + 1]), feature_size_m);
+            }
+            probabilities[i]= q8_8_to_float(sigmoidApprox_q16_16_to_q8_8(kernels_m.dotproduct_q8_8(modelWeights_q8_8(models[i]), inputs_q8_8_m.data(), feature_size_m)));
+        }
+        return;
+    }
+    for (size_t i= 0; i < count; i++){
+        assert(models[i] < num_models_m && "Model out of range");
+        uint8_t& marked= tile_marks_m[models[i]/ BANK_TILE];
+        if (!marked){
+            scoreTile(models[i]/ BANK_TILE, inputs, true);
+            marked= 1;
+        }
+    }
+    for (size_t i= 0; i < count; i++){
+        probabilities[i]= q8_8_to_float(sigmoidApprox_q16_16_to_q8_8(logits_q16_16_m[models[i]]));
+        tile_marks_m[models[i]/ BANK_TILE]= 0;
+    }
+}
+
+//Interleaved gathers the model into contiguous rows so the update runs the same kernel, and rounds the same, as ModelMajor
+void ModelBank::update_weights(size_t model, alignedArray<float>& inputs, float prediction, float label){
+    assert(model < num_models_m && "Model out of range");
+    if (layout_m == BankLayout::ModelMajor){
+        kernels_m.sgd_q8_8_inplace(float_to_q8_8(prediction), label, modelWeights(model), modelWeights_q8_8(model), inputs.data(), feature_size_m, learning_rate_m);
+        return;
+    }
+    gather(model);
+    kernels_m.sgd_q8_8_inplace(float_to_q8_8(prediction), label, model_m.data(), model_q8_8_m.data(), inputs.data(), feature_size_m, learning_rate_m);
+    scatter(model);
+}
+
+void ModelBank::initWeights(){
+    std::random_device rd;
+    std::mt19937 gen(rd());
+
+    float limit= sqrt(6.0f / feature_size_m);
+    std::uniform_real_distribution<float> dist(-limit, limit);
+
+    alignedArray<float> w(feature_size_m);
+    for (size_t m= 0; m < num_models_m; m++){
+        for (size_t i= 0; i < feature_size_m; i++){
+            w[i]= dist(gen);
+        }
+        setWeights(m, w.data());
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "avx.hh"
+#include "containers.hh"
+#include "dispatch.hh"
+
+enum class BankLayout{
+    ModelMajor, //each model's weights contiguous, one dispatched dot product per model on every tier
+    Interleaved //feature-major tiles of BANK_TILE models, one pass over the input scores a whole tile (AVX2)
+};
+
+//Models per interleaved tile, matches the class block the softmax logits kernels keep in registers
+constexpr size_t BANK_TILE= 32;
+
+//Many small logistic models with the same feature size in one FP32 and one Q8.8 arena, instead of four heap
+//allocations per SGDLogisticRegression. The input is quantized once per call however many models score it.
+//Single-model results match SGDLogisticRegression with the same weights, Q8.8 bit for bit in either layout
+class ModelBank{
+    private:
+        const KernelTable& kernels_m;
+        const size_t num_models_m;
+        const size_t feature_size_m;
+        const BankLayout layout_m;
+        const size_t model_stride_m; //ModelMajor: elements from one model to the next, a multiple of 16
+        const size_t num_tiles_m;
+
+        float learning_rate_m;
+
+        alignedArray<float> weights_m;
+        alignedArray<int16_t> weights_q8_8_m;
+        alignedArray<int16_t> inputs_q8_8_m;
+        alignedArray<float> logits_m;
+        alignedArray<int32_t> logits_q16_16_m;
+        alignedArray<uint8_t> tile_marks_m;
+        alignedArray<float> model_m;       //Interleaved: one model gathered into contiguous rows for updates
+        alignedArray<int16_t> model_q8_8_m;
+
+        float* modelWeights(size_t model);
+        int16_t* modelWeights_q8_8(size_t model);
+        void gather(size_t model);
+        void scatter(size_t model);
+        void quantizeInputs(alignedArray<float>& inputs);
+        void scoreTile(size_t tile, alignedArray<float>& inputs, bool q8_8);
+        void initWeights();
+
+    public:
+        ModelBank(size_t num_models, size_t feature_size, BankLayout layout= BankLayout::ModelMajor, float learning_rate= 0.01f);
+
+        size_t numModels() const;
+        size_t featureSize() const;
+        BankLayout layout() const;
+        void setLearningRate(float val);
+
+        //Copies feature_size weights in or out and refreshes the quantized copy
+        void setWeights(size_t model, const float* w);
+        void getWeights(size_t model, float* w) const;
+
+        float inference_fp(size_t model, alignedArray<float>& inputs);
+        float inference_q8_8_to_fp(size_t model, alignedArray<float>& inputs);
+        //probabilities receives num_models values
+        void inference_all_fp(alignedArray<float>& inputs, float* probabilities);
+        void inference_all_q8_8_to_fp(alignedArray<float>& inputs, float* probabilities);
+        //probabilities[i] belongs to models[i], Interleaved scores every tile that holds a requested model
+        void inference_subset_fp(alignedArray<float>& inputs, const size_t* models, size_t count, float* probabilities);
+        void inference_subset_q8_8_to_fp(alignedArray<float>& inputs, const size_t* models, size_t count, float* probabilities);
+
+        //SGD step on one model, same result as SGDLogisticRegression::update_weights in either layout
+        void update_weights(size_t model, alignedArray<float>& inputs, float prediction, float label);
+};
@@ -0,0 +1,96 @@
+#include "model_file.hh"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static inline uint64_t alignSection(uint64_t offset){
+    return (offset + MODEL_SECTION_ALIGN - 1)/ MODEL_SECTION_ALIGN* MODEL_SECTION_ALIGN;
+}
+
+void writeModelFile(const std::string& path, size_t feature_size, float learning_rate, float threshold, const float* weights, const int16_t* weights_q8_8){
+    modelHeader header{};
+    std::memcpy(header.magic, MODEL_MAGIC, sizeof(MODEL_MAGIC));
+    header.version= MODEL_VERSION;
+    header.header_size= sizeof(modelHeader);
+    header.feature_size= feature_size;
+    header.learning_rate= learning_rate;
+    header.threshold= threshold;
+    header.quant_format= QuantFormat::Q8_8;
+    header.fp32_offset= sizeof(modelHeader);
+    header.fp32_bytes= feature_size* sizeof(float);
+    header.q8_8_offset= alignSection(header.fp32_offset + header.fp32_bytes);
+    header.q8_8_bytes= (feature_size + 1)* sizeof(int16_t);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file){
+        throw std::runtime_error("Cannot open " + path + " for writing");
+    }
+
+    const char padding[MODEL_SECTION_ALIGN]= {};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(modelHeader));
+    file.write(reinterpret_cast<const char*>(weights), header.fp32_bytes);
+    file.write(padding, header.q8_8_offset - (header.fp32_offset + header.fp32_bytes));
+    file.write(reinterpret_cast<const char*>(weights_q8_8), header.q8_8_bytes);
+    //pad the tail so the whole file is a multiple of the section alignment
+    file.write(padding, alignSection(header.q8_8_offset + header.q8_8_bytes) - (header.q8_8_offset + header.q8_8_bytes));
+    if (!file){
+        throw std::runtime_error("Failed writing " + path);
+    }
+}
+
+modelMapping::modelMapping(const std::string& path): base_m(MAP_FAILED), length_m(0){
+    int fd= open(path.c_str(), O_RDONLY);
+    if (fd < 0){
+        throw std::runtime_error("Cannot open " + path);
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < sizeof(modelHeader)){
+        close(fd);
+        throw std::runtime_error(path + " is too small to be a model file");
+    }
+    length_m= file_stat.st_size;
+
+    //PROT_WRITE on a private read-only fd is allowed, writes never reach the file
+    base_m= mmap(nullptr, length_m, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base_m == MAP_FAILED){
+        throw std::runtime_error("Cannot map " + path);
+    }
+
+    const modelHeader& h= header();
+    bool valid= std::memcmp(h.magic, MODEL_MAGIC, sizeof(MODEL_MAGIC)) == 0
+        && h.version == MODEL_VERSION
+        && h.header_size == sizeof(modelHeader)
+        && h.quant_format == QuantFormat::Q8_8
+        && h.fp32_offset % MODEL_SECTION_ALIGN == 0
+        && h.q8_8_offset % MODEL_SECTION_ALIGN == 0
+        && h.fp32_bytes == h.feature_size* sizeof(float)
+        && h.q8_8_bytes == (h.feature_size + 1)* sizeof(int16_t)
+        && h.fp32_offset + h.fp32_bytes <= length_m
+        && h.q8_8_offset + h.q8_8_bytes <= length_m;
+    if (!valid){
+        munmap(base_m, length_m);
+        throw std::runtime_error(path + " is not a version " + std::to_string(MODEL_VERSION) + " model file");
+    }
+}
+
+modelMapping::~modelMapping(){
+    munmap(base_m, length_m);
+}
+
+const modelHeader& modelMapping::header() const{
+    return *static_cast<const modelHeader*>(base_m);
+}
+
+float* modelMapping::weights() const{
+    return reinterpret_cast<float*>(static_cast<char*>(base_m) + header().fp32_offset);
+}
+
+int16_t* modelMapping::weights_q8_8() const{
+    return reinterpret_cast<int16_t*>(static_cast<char*>(base_m) + header().q8_8_offset);
+}
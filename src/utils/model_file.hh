@@ -0,0 +1,53 @@
+//Versioned binary model file: a 64-byte-aligned header followed by 64-byte-aligned FP32 and Q8.8 weight sections
+//Little-endian, written and read on the same architecture
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+constexpr char MODEL_MAGIC[8]= {'A', 'V', 'X', 'L', 'R', 'M', 'D', 'L'};
+constexpr uint32_t MODEL_VERSION= 1;
+constexpr size_t MODEL_SECTION_ALIGN= 64;
+
+enum class QuantFormat: uint32_t{
+    Q8_8= 1
+};
+
+struct alignas(MODEL_SECTION_ALIGN) modelHeader{
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t feature_size;
+    float learning_rate;
+    float threshold;
+    QuantFormat quant_format;
+    uint32_t reserved;
+    uint64_t fp32_offset;
+    uint64_t fp32_bytes;
+    uint64_t q8_8_offset;
+    uint64_t q8_8_bytes; //feature_size + 1 values, the last is the zero slack slot the sparse gathers read
+};
+
+static_assert(sizeof(modelHeader) % MODEL_SECTION_ALIGN == 0, "Sections must start 64-byte aligned");
+
+//weights_q8_8 holds feature_size + 1 values
+void writeModelFile(const std::string& path, size_t feature_size, float learning_rate, float threshold, const float* weights, const int16_t* weights_q8_8);
+
+//Maps a model file copy-on-write: untouched pages stay shared through the page cache across every process
+//that maps the same file, the first update to a page gives this process a private copy
+class modelMapping{
+    private:
+        void* base_m;
+        size_t length_m;
+
+    public:
+        explicit modelMapping(const std::string& path);
+        ~modelMapping();
+
+        modelMapping(const modelMapping&)= delete;
+        modelMapping& operator=(const modelMapping&)= delete;
+
+        const modelHeader& header() const;
+        float* weights() const;
+        int16_t* weights_q8_8() const;
+};
@@ -0,0 +1,213 @@
+#pragma once
+#include "containers.hh"
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+//Records are padded to whole cache lines so neighbouring slots never share one
+constexpr size_t RING_RECORD_ALIGN= 64;
+
+constexpr size_t ringRecordBytes(size_t bytes){
+    return (bytes + RING_RECORD_ALIGN - 1)/ RING_RECORD_ALIGN* RING_RECORD_ALIGN;
+}
+
+//Producer and consumer positions of one ring, each on its own cache line. Plain lock-free atomics, so they also work
+//from shared memory mapped into several processes
+struct ringIndices{
+    alignas(64) std::atomic<size_t> tail; //next slot the producer fills
+    alignas(64) std::atomic<size_t> head; //next slot the consumer reads
+};
+
+//Bounded single-producer single-consumer ring of fixed-size records, the capacity is rounded up to a power of two
+//Each side keeps a private copy of the other's index, so the shared lines only move when the producer sees the ring as
+//full or the consumer sees it as empty. The indices and records can live in caller memory (e.g. a shm mapping shared
+//with another process), the cached copies always stay private to this object
+class SPSCRing{
+    private:
+        const size_t capacity_m;
+        const size_t mask_m;
+        const size_t record_bytes_m;
+        alignedArray<std::byte> storage_m; //indices then records, a view when the memory belongs to the caller
+        ringIndices* indices_m;
+        std::byte* records_m;
+
+        alignas(64) size_t cached_head_m; //producer side
+        alignas(64) size_t cached_tail_m; //consumer side
+
+    public:
+        SPSCRing(size_t capacity, size_t record_bytes):
+            SPSCRing(nullptr, capacity, record_bytes, true){}
+
+        //memory null allocates, otherwise it must hold sharedBytes(capacity, record_bytes) 64-byte aligned bytes;
+        //exactly one of the two sides initializes it
+        SPSCRing(void* memory, size_t capacity, size_t record_bytes, bool initialize):
+            capacity_m(std::bit_ceil(capacity)),
+            mask_m(capacity_m - 1),
+            record_bytes_m(ringRecordBytes(record_bytes)),
+            storage_m(memory? alignedArray<std::byte>::view(static_cast<std::byte*>(memory), sharedBytes(capacity, record_bytes)):
+                              alignedArray<std::byte>(RING_RECORD_ALIGN, sharedBytes(capacity, record_bytes))),
+            indices_m(reinterpret_cast<ringIndices*>(storage_m.data())),
+            records_m(storage_m.data() + sizeof(ringIndices)),
+            cached_head_m(0),
+            cached_tail_m(0){
+            assert(capacity > 0 && record_bytes > 0 && "Empty ring");
+            if (initialize){
+                new (indices_m) ringIndices{};
+                std::memset(records_m, 0, capacity_m* record_bytes_m);
+            }
+            cached_head_m= indices_m->head.load(std::memory_order_acquire);
+            cached_tail_m= indices_m->tail.load(std::memory_order_acquire);
+        }
+
+        static size_t sharedBytes(size_t capacity, size_t record_bytes){
+            return sizeof(ringIndices) + std::bit_ceil(capacity)* ringRecordBytes(record_bytes);
+        }
+
+        SPSCRing(const SPSCRing&)= delete;
+        SPSCRing& operator=(const SPSCRing&)= delete;
+
+        //Producer side: the next free record to fill in place (nullptr when full), push() publishes it
+        void* claim(){
+            size_t tail= indices_m->tail.load(std::memory_order_relaxed);
+            if (tail - cached_head_m == capacity_m){
+                cached_head_m= indices_m->head.load(std::memory_order_acquire);
+                if (tail - cached_head_m == capacity_m){
+                    return nullptr;
+                }
+            }
+            return records_m + (tail & mask_m)* record_bytes_m;
+        }
+
+        void push(void*){
+            indices_m->tail.store(indices_m->tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        //Producer side: records that can be claimed and pushed before the ring is full
+        size_t available(){
+            size_t tail= indices_m->tail.load(std::memory_order_relaxed);
+            if (tail - cached_head_m == capacity_m){
+                cached_head_m= indices_m->head.load(std::memory_order_acquire);
+            }
+            //more in flight than the ring holds only happens when the other process rewrote the indices, read it as full
+            return tail - cached_head_m > capacity_m? 0: capacity_m - (tail - cached_head_m);
+        }
+
+        //Whether the shared indices describe a possible ring state, for rings whose other side is not trusted
+        bool consistent() const{
+            size_t head= indices_m->head.load(std::memory_order_acquire);
+            return indices_m->tail.load(std::memory_order_acquire) - head <= capacity_m;
+        }
+
+        //Consumer side: the oldest record (nullptr when empty), pop() hands its slot back to the producer
+        void* front(){
+            size_t head= indices_m->head.load(std::memory_order_relaxed);
+            if (head == cached_tail_m){
+                cached_tail_m= indices_m->tail.load(std::memory_order_acquire);
+                if (head == cached_tail_m){
+                    return nullptr;
+                }
+            }
+            return records_m + (head & mask_m)* record_bytes_m;
+        }
+
+        void pop(){
+            indices_m->head.store(indices_m->head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        size_t capacity() const {
+            return capacity_m;
+        }
+
+        size_t recordBytes() const {
+            return record_bytes_m;
+        }
+};
+
+//Bounded multi-producer single-consumer ring (Vyukov's bounded queue with one consumer): producers reserve a slot with
+//a CAS on the tail and publish it through the slot's own sequence number, so a producer preempted between claim() and
+//push() only holds back the records behind its own, never another producer's claim
+class MPSCRing{
+    private:
+        const size_t capacity_m;
+        const size_t mask_m;
+        const size_t record_bytes_m;
+        alignedArray<std::byte> records_m;
+        alignedArray<uint64_t> sequences_m; //slot s is free for position p when it holds p, readable when it holds p + 1
+
+        alignas(64) std::atomic<size_t> tail_m;
+        alignas(64) size_t head_m;
+
+        std::atomic_ref<uint64_t> sequence(size_t slot){
+            return std::atomic_ref<uint64_t>(sequences_m[slot]);
+        }
+
+    public:
+        MPSCRing(size_t capacity, size_t record_bytes):
+            capacity_m(std::bit_ceil(capacity)),
+            mask_m(capacity_m - 1),
+            record_bytes_m(ringRecordBytes(record_bytes)),
+            records_m(RING_RECORD_ALIGN, capacity_m* record_bytes_m),
+            sequences_m(RING_RECORD_ALIGN, capacity_m),
+            tail_m(0),
+            head_m(0){
+            assert(capacity > 0 && record_bytes > 0 && "Empty ring");
+            std::memset(records_m.data(), 0, records_m.size());
+            for (size_t s= 0; s < capacity_m; s++){
+                sequences_m[s]= s;
+            }
+        }
+
+        MPSCRing(const MPSCRing&)= delete;
+        MPSCRing& operator=(const MPSCRing&)= delete;
+
+        //Producer side, any number of threads: claim() reserves a record (nullptr when full), push(record) publishes it
+        void* claim(){
+            size_t tail= tail_m.load(std::memory_order_relaxed);
+            while (true){
+                uint64_t seq= sequence(tail & mask_m).load(std::memory_order_acquire);
+                int64_t diff= static_cast<int64_t>(seq - tail);
+                if (diff == 0){
+                    if (tail_m.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed)){
+                        return records_m.data() + (tail & mask_m)* record_bytes_m;
+                    }
+                }
+                else if (diff < 0){
+                    return nullptr;
+                }
+                else{
+                    tail= tail_m.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        //The slot's sequence still holds the claimed position, nobody else writes it until this store
+        void push(void* record){
+            size_t slot= (static_cast<std::byte*>(record) - records_m.data())/ record_bytes_m;
+            std::atomic_ref<uint64_t> seq= sequence(slot);
+            seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        //Consumer side, one thread
+        void* front(){
+            uint64_t seq= sequence(head_m & mask_m).load(std::memory_order_acquire);
+            if (seq != head_m + 1){
+                return nullptr;
+            }
+            return records_m.data() + (head_m & mask_m)* record_bytes_m;
+        }
+
+        void pop(){
+            sequence(head_m & mask_m).store(head_m + capacity_m, std::memory_order_release);
+            head_m++;
+        }
+
+        size_t capacity() const {
+            return capacity_m;
+        }
+
+        size_t recordBytes() const {
+            return record_bytes_m;
+        }
+};
@@ -21,4 +21,23 @@ void sgd_inplace_scalar(float y_hat, float y, float* w, float* x, size_t size, f
     for (size_t i = 0; i < size; i++){
         w[i]+= neg_coeff*x[i];
     }
+}
+
+void adamW_inplace_scalar(float y_hat, float y, float* w, float* x, size_t size, AdamWParams& params){
+    float coeff= y_hat - y;
+    float m_correction= 1.0f - params.beta1i;
+    float v_correction= 1.0f - params.beta2i;
+
+    for (size_t i = 0; i < size; i++){
+        float g= coeff*x[i];
+        params.moment1[i]= params.beta1*params.moment1[i] + (1.0f - params.beta1)*g;
+        params.moment2[i]= params.beta2*params.moment2[i] + (1.0f - params.beta2)*g*g;
+
+        float m_hat= params.moment1[i]/m_correction;
+        float v_hat= params.moment2[i]/v_correction;
+        w[i]= params.decay*w[i] - params.learning_rate*m_hat/(std::sqrt(v_hat) + params.eps);
+    }
+
+    params.beta1i*= params.beta1;
+    params.beta2i*= params.beta2;
 }
\ No newline at end of file
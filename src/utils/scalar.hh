@@ -1,9 +1,12 @@
 //Functions with scalar implementations
 #pragma once
 #include <cstddef>
+#include "containers.hh"
 
 float dotproduct_scalar(float* w, float* x, size_t size);
 
 float sigmoid_scalar(float x);
 
-void sgd_inplace_scalar(float y_hat, float y, float* w, float* x, size_t size, float lr);
\ No newline at end of file
+void sgd_inplace_scalar(float y_hat, float y, float* w, float* x, size_t size, float lr);
+
+void adamW_inplace_scalar(float y_hat, float y, float* w, float* x, size_t size, AdamWParams& params);
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include "sharded_inference.hh"
+#include "tools.hh"
+#include "affinity.hh"
+#include <chrono>
+#include <immintrin.h>
+
+//Pause while the other side is close, yield once it clearly is not so an oversubscribed core still progresses
+template <typename Condition>
+static inline void spinUntil(Condition done){
+    for (size_t spins= 0; !done(); spins++){
+        if (spins < 4096){
+            _mm_pause();
+        }
+        else{
+            std::this_thread::yield();
+        }
+    }
+}
+
+ShardedInference::ShardedInference(size_t feature_size, size_t num_threads):
+    kernels_m(kernels()),
+    feature_size_m(feature_size),
+    shard_size_m(shardSize(feature_size, num_threads)),
+    num_threads_m((feature_size + shard_size_m - 1)/ shard_size_m),
+    sharded_m(num_threads_m > 1 && feature_size/ num_threads_m >= SHARD_MIN_FEATURES),
+    shards_m(num_threads_m),
+    generation_m(0),
+    pending_m(0),
+    job_inputs_m(nullptr),
+    job_q8_8_m(false),
+    stop_m(false){
+    for (size_t t= 0; t < num_threads_m; t++){
+        shards_m[t].begin= t* shard_size_m;
+        shards_m[t].size= std::min(shard_size_m, feature_size_m - shards_m[t].begin);
+    }
+
+    allocShard(0);
+    pending_m.store(num_threads_m - 1, std::memory_order_relaxed);
+    for (size_t t= 1; t < num_threads_m; t++){
+        workers_m.emplace_back(&ShardedInference::worker, this, t);
+    }
+    spinUntil([this]{ return pending_m.load(std::memory_order_acquire) == 0; });
+}
+
+ShardedInference::~ShardedInference(){
+    stop_m= true;
+    generation_m.fetch_add(1, std::memory_order_release);
+    generation_m.notify_all();
+    for (std::thread& worker: workers_m){
+        worker.join();
+    }
+}
+
+size_t ShardedInference::shardSize(size_t feature_size, size_t num_threads){
+    assert(feature_size > 0 && num_threads > 0 && "Need at least one feature and one thread");
+    size_t shard= (feature_size + num_threads - 1)/ num_threads;
+    return (shard + SHARD_ALIGN - 1)/ SHARD_ALIGN* SHARD_ALIGN;
+}
+
+void ShardedInference::allocShard(size_t shard_id){
+    inferenceShard& shard= shards_m[shard_id];
+    shard.weights= alignedArray<float>(64, shard.size);
+    shard.weights_q8_8= alignedArray<int16_t>(64, shard.size);
+    shard.inputs_q8_8= alignedArray<int16_t>(64, shard.size);
+    std::memset(shard.weights.data(), 0, shard.size* sizeof(float));
+    std::memset(shard.weights_q8_8.data(), 0, shard.size* sizeof(int16_t));
+    std::memset(shard.inputs_q8_8.data(), 0, shard.size* sizeof(int16_t));
+    shard.partial_fp= 0.0f;
+    shard.partial_q16_16= 0;
+}
+
+void ShardedInference::runShard(size_t shard_id, float* inputs, bool q8_8){
+    inferenceShard& shard= shards_m[shard_id];
+    if (q8_8){
+        kernels_m.quantize8_8_inplace(&inputs[shard.begin], shard.inputs_q8_8.data(), shard.size);
+        //same kernel choice as the single-thread model, so the partials add up to its logit
+        if (feature_size_m > Q8_8_NARROW_MAX_FEATURES){
+            shard.partial_q16_16= kernels_m.dotproduct_q8_8_wide(shard.weights_q8_8.data(), shard.inputs_q8_8.data(), shard.size);
+        }
+        else{
+            shard.partial_q16_16= kernels_m.dotproduct_q8_8(shard.weights_q8_8.data(), shard.inputs_q8_8.data(), shard.size);
+        }
+    }
+    else{
+        shard.partial_fp= kernels_m.dotproduct_fp(shard.weights.data(), &inputs[shard.begin], shard.size);
+    }
+}
+
+//Back-to-back jobs are picked up from the spin, a gap longer than the budget costs one futex wake
+void ShardedInference::awaitJob(uint64_t seen){
+    for (size_t spins= 0; spins < SHARD_SPIN_BUDGET; spins++){
+        if (generation_m.load(std::memory_order_acquire) != seen){
+            return;
+        }
+        _mm_pause();
+    }
+    generation_m.wait(seen, std::memory_order_acquire);
+}
+
+void ShardedInference::worker(size_t shard_id){
+    pinToAllowedCPU(shard_id);
+
+    allocShard(shard_id);
+    uint64_t seen= generation_m.load(std::memory_order_relaxed);
+    pending_m.fetch_sub(1, std::memory_order_release);
+
+    while (true){
+        awaitJob(seen);
+        seen++;
+        if (stop_m){
+            return;
+        }
+        runShard(shard_id, job_inputs_m, job_q8_8_m);
+        pending_m.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+//Publishes the job, runs shard 0 here and spins until every worker has written its partial
+void ShardedInference::dispatch(float* inputs, bool q8_8){
+    if (!sharded_m){
+        for (size_t t= 0; t < num_threads_m; t++){
+            runShard(t, inputs, q8_8);
+        }
+        return;
+    }
+
+    job_inputs_m= inputs;
+    job_q8_8_m= q8_8;
+    pending_m.store(num_threads_m - 1, std::memory_order_relaxed);
+    generation_m.fetch_add(1, std::memory_order_release);
+    generation_m.notify_all();
+
+    runShard(0, inputs, q8_8);
+    spinUntil([this]{ return pending_m.load(std::memory_order_acquire) == 0; });
+}
+
+void ShardedInference::setWeights(float* w){
+    for (inferenceShard& shard: shards_m){
+        std::memcpy(shard.weights.data(), &w[shard.begin], shard.size* sizeof(float));
+        kernels_m.quantize8_8_inplace(shard.weights.data(), shard.weights_q8_8.data(), shard.size);
+    }
+}
+
+void ShardedInference::setSharded(bool sharded){
+    sharded_m= sharded && num_threads_m > 1;
+}
+
+bool ShardedInference::sharded() const{
+    return sharded_m;
+}
+
+float ShardedInference::inference_fp(alignedArray<float>& inputs){
+    dispatch(inputs.data(), false);
+    float sum_fp= 0.0f;
+    for (inferenceShard& shard: shards_m){
+        sum_fp+= shard.partial_fp;
+    }
+    return q8_8_to_float(sigmoid_fp_to_q8_8(sum_fp));
+}
+
+//Integer partials, so the result matches the single-thread Q8.8 path exactly
+float ShardedInference::inference_q8_8_to_fp(alignedArray<float>& inputs){
+    dispatch(inputs.data(), true);
+    int64_t sum_q16_16= 0;
+    for (inferenceShard& shard: shards_m){
+        sum_q16_16+= shard.partial_q16_16;
+    }
+    return q8_8_to_float(sigmoidApprox_q16_16_to_q8_8(saturate_q16_16(sum_q16_16)));
+}
+
+void ShardedInference::tune(int reps){
+    if (num_threads_m == 1){
+        return;
+    }
+
+    alignedArray<float> inputs(64, feature_size_m);
+    for (size_t i= 0; i < feature_size_m; i++){
+        inputs[i]= static_cast<float>(i % 17)/ 17.0f - 0.5f;
+    }
+
+    volatile float accumulation= 0.0f;
+    double elapsed[2];
+    for (int mode= 0; mode < 2; mode++){
+        sharded_m= mode == 1;
+        auto start= std::chrono::high_resolution_clock::now();
+        for (int r= 0; r < reps; r++){
+            accumulation= accumulation + inference_q8_8_to_fp(inputs);
+        }
+        auto end= std::chrono::high_resolution_clock::now();
+        elapsed[mode]= std::chrono::duration<double>(end - start).count();
+    }
+    sharded_m= elapsed[1] < elapsed[0];
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "containers.hh"
+#include "dispatch.hh"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+//Shard boundaries are a multiple of this so every shard's float/Q8.8 slices stay 64-byte aligned
+constexpr size_t SHARD_ALIGN= 64;
+
+//Below this many features per shard the wake-up and reduction cost more than the split saves
+constexpr size_t SHARD_MIN_FEATURES= 16384;
+
+//Pauses an idle worker spends on the generation counter before it parks in atomic::wait (roughly 1 ms)
+constexpr size_t SHARD_SPIN_BUDGET= 16384;
+
+//Each shard owns its slice of the weights, allocated and first touched by the thread that reads it
+struct alignas(64) inferenceShard{
+    size_t begin;
+    size_t size;
+    alignedArray<float> weights;
+    alignedArray<int16_t> weights_q8_8;
+    alignedArray<int16_t> inputs_q8_8;
+    float partial_fp;
+    int64_t partial_q16_16;
+};
+
+//Logistic regression inference split by feature range over a persistent pool of pinned workers
+//Workers spin for SHARD_SPIN_BUDGET between jobs and then sleep, so an idle or unsharded model holds no cores
+//The calling thread runs shard 0 and reduces the partial sums once the others have checked in
+class ShardedInference{
+    private:
+        const KernelTable& kernels_m;
+        const size_t feature_size_m;
+        const size_t shard_size_m;
+        const size_t num_threads_m; //can come out below the requested count when shards would be empty
+
+        bool sharded_m;
+        std::vector<inferenceShard> shards_m;
+        std::vector<std::thread> workers_m;
+
+        alignas(64) std::atomic<uint64_t> generation_m;
+        alignas(64) std::atomic<size_t> pending_m;
+        float* job_inputs_m;
+        bool job_q8_8_m;
+        bool stop_m;
+
+        static size_t shardSize(size_t feature_size, size_t num_threads);
+        void allocShard(size_t shard_id);
+        void runShard(size_t shard_id, float* inputs, bool q8_8);
+        void worker(size_t shard_id);
+        void awaitJob(uint64_t seen);
+        void dispatch(float* inputs, bool q8_8);
+
+    public:
+        ShardedInference(size_t feature_size, size_t num_threads);
+        ~ShardedInference();
+
+        ShardedInference(const ShardedInference&)= delete;
+        ShardedInference& operator=(const ShardedInference&)= delete;
+
+        //Copies feature_size weights into the shards and quantizes them
+        void setWeights(float* w);
+        void setSharded(bool sharded);
+        bool sharded() const;
+
+        //Times both modes on this model and keeps the faster one
+        void tune(int reps= 1000);
+
+        float inference_fp(alignedArray<float>& inputs);
+        float inference_q8_8_to_fp(alignedArray<float>& inputs);
+};
@@ -0,0 +1,94 @@
+#include "snapshot_model.hh"
+#include "tools.hh"
+
+SnapshotModel::SnapshotModel(size_t feature_size, size_t max_readers, float learning_rate):
+    kernels_m(kernels()),
+    feature_size_m(feature_size),
+    trainer_m(feature_size, learning_rate),
+    readers_m(max_readers),
+    current_m(0),
+    version_m(0){
+    for (weightSnapshot& snapshot: snapshots_m){
+        snapshot.weights= alignedArray<float>(64, feature_size_m);
+        snapshot.weights_q8_8= alignedArray<int16_t>(64, feature_size_m);
+        std::memcpy(snapshot.weights.data(), trainer_m.weights(), feature_size_m* sizeof(float));
+        std::memcpy(snapshot.weights_q8_8.data(), trainer_m.weights_q8_8(), feature_size_m* sizeof(int16_t));
+        snapshot.version= 0;
+    }
+    for (snapshotReader& reader: readers_m){
+        reader.pinned.store(SNAPSHOT_NONE, std::memory_order_relaxed);
+        reader.inputs_q8_8= alignedArray<int16_t>(64, feature_size_m);
+    }
+}
+
+SGDLogisticRegression& SnapshotModel::trainer(){
+    return trainer_m;
+}
+
+uint64_t SnapshotModel::version() const{
+    return version_m.load(std::memory_order_acquire);
+}
+
+//Pin, then confirm the snapshot is still current: either the writer saw the pin before choosing a buffer,
+//or it already moved current on and the loop pins the new one (both sides seq_cst, Dekker style)
+uint32_t SnapshotModel::pin(size_t reader_id){
+    assert(reader_id < readers_m.size() && "reader_id out of range");
+    std::atomic<uint32_t>& pinned= readers_m[reader_id].pinned;
+    uint32_t current= current_m.load(std::memory_order_seq_cst);
+    while (true){
+        pinned.store(current, std::memory_order_seq_cst);
+        uint32_t confirmed= current_m.load(std::memory_order_seq_cst);
+        if (confirmed == current){
+            return current;
+        }
+        current= confirmed;
+    }
+}
+
+void SnapshotModel::unpin(size_t reader_id){
+    readers_m[reader_id].pinned.store(SNAPSHOT_NONE, std::memory_order_release);
+}
+
+bool SnapshotModel::publish(){
+    uint32_t current= current_m.load(std::memory_order_relaxed);
+    for (uint32_t candidate= 0; candidate < SNAPSHOT_COUNT; candidate++){
+        if (candidate == current){
+            continue;
+        }
+        bool pinned= false;
+        for (snapshotReader& reader: readers_m){
+            pinned|= reader.pinned.load(std::memory_order_seq_cst) == candidate;
+        }
+        if (pinned){
+            continue;
+        }
+
+        weightSnapshot& snapshot= snapshots_m[candidate];
+        std::memcpy(snapshot.weights.data(), trainer_m.weights(), feature_size_m* sizeof(float));
+        std::memcpy(snapshot.weights_q8_8.data(), trainer_m.weights_q8_8(), feature_size_m* sizeof(int16_t));
+        snapshot.version= version_m.load(std::memory_order_relaxed) + 1;
+
+        current_m.store(candidate, std::memory_order_seq_cst);
+        version_m.store(snapshot.version, std::memory_order_release);
+        return true;
+    }
+    return false;
+}
+
+float SnapshotModel::inference_fp(size_t reader_id, alignedArray<float>& inputs){
+    weightSnapshot& snapshot= snapshots_m[pin(reader_id)];
+    float logit= kernels_m.dotproduct_fp(snapshot.weights.data(), inputs.data(), feature_size_m);
+    unpin(reader_id);
+    return q8_8_to_float(sigmoid_fp_to_q8_8(logit));
+}
+
+float SnapshotModel::inference_q8_8_to_fp(size_t reader_id, alignedArray<float>& inputs){
+    weightSnapshot& snapshot= snapshots_m[pin(reader_id)];
+    int16_t* inputs_q8_8= readers_m[reader_id].inputs_q8_8.data();
+    kernels_m.quantize8_8_inplace(inputs.data(), inputs_q8_8, feature_size_m);
+    int32_t logit_q16_16= (feature_size_m > Q8_8_NARROW_MAX_FEATURES)?
+        saturate_q16_16(kernels_m.dotproduct_q8_8_wide(snapshot.weights_q8_8.data(), inputs_q8_8, feature_size_m)):
+        kernels_m.dotproduct_q8_8(snapshot.weights_q8_8.data(), inputs_q8_8, feature_size_m);
+    unpin(reader_id);
+    return q8_8_to_float(sigmoidApprox_q16_16_to_q8_8(logit_q16_16));
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "logistic_regession.hh"
+#include <array>
+#include <atomic>
+#include <vector>
+
+constexpr size_t SNAPSHOT_COUNT= 3;
+constexpr uint32_t SNAPSHOT_NONE= UINT32_MAX;
+
+struct weightSnapshot{
+    alignedArray<float> weights;
+    alignedArray<int16_t> weights_q8_8;
+    uint64_t version;
+};
+
+//Each reader pins the snapshot it is using in its own cache line, the writer never touches a pinned snapshot
+struct alignas(64) snapshotReader{
+    std::atomic<uint32_t> pinned;
+    alignedArray<int16_t> inputs_q8_8;
+};
+
+//Serve and learn in one process without locks (RCU over SNAPSHOT_COUNT weight buffers):
+//one trainer thread updates trainer() freely and publish()es copies, up to max_readers threads read the
+//latest published copy. Readers never wait or retry more than once per publish, the writer never waits on readers
+class SnapshotModel{
+    private:
+        const KernelTable& kernels_m;
+        const size_t feature_size_m;
+
+        SGDLogisticRegression trainer_m;
+        std::array<weightSnapshot, SNAPSHOT_COUNT> snapshots_m;
+        std::vector<snapshotReader> readers_m;
+
+        alignas(64) std::atomic<uint32_t> current_m;
+        std::atomic<uint64_t> version_m;
+
+        uint32_t pin(size_t reader_id);
+        void unpin(size_t reader_id);
+
+    public:
+        SnapshotModel(size_t feature_size, size_t max_readers, float learning_rate= 0.01f);
+
+        //Writer side, single thread
+        SGDLogisticRegression& trainer();
+        //Copies the trainer's weights into a free snapshot and makes it current
+        //false (nothing published) when readers still pin every non-current snapshot, try again after the next update
+        bool publish();
+
+        //Reader side, reader_id in [0, max_readers) and used by one thread at a time
+        float inference_fp(size_t reader_id, alignedArray<float>& inputs);
+        float inference_q8_8_to_fp(size_t reader_id, alignedArray<float>& inputs);
+        //Number of publishes so far, the initial weights are version 0
+        uint64_t version() const;
+};
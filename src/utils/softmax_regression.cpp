@@ -0,0 +1,83 @@
+#include "softmax_regression.hh"
+#include "tools.hh"
+#include "avx.hh"
+#include "dispatch.hh"
+#include <random>
+
+//Every method runs the AVX2 softmax kernels, the tier is checked before any member is built
+SGDSoftmaxRegression::SGDSoftmaxRegression(size_t feature_size, size_t num_classes, float learning_rate, size_t alignment)
+    :feature_size_m((requireISA(ISA::AVX2, "Softmax regression"), feature_size)),
+    num_classes_m(num_classes),
+    class_stride_m((num_classes + 7) & ~size_t(7)),
+    feature_stride_m((feature_size + 1) & ~size_t(1)),
+    learning_rate_m(learning_rate),
+    weights_m(alignment, feature_stride_m* class_stride_m),
+    inputs_m(alignment, feature_stride_m),
+    weights_q8_8_m(alignment, feature_stride_m* class_stride_m),
+    inputs_q8_8_m(alignment, feature_stride_m),
+    logits_q16_16_m(alignment, class_stride_m),
+    logits_m(alignment, class_stride_m),
+    neg_coeff_m(alignment, class_stride_m){
+    std::memset(inputs_m.data(), 0, feature_stride_m* sizeof(float));
+    std::memset(inputs_q8_8_m.data(), 0, feature_stride_m* sizeof(int16_t));
+    initWeights();
+}
+
+void SGDSoftmaxRegression::setLearningRate(float learning_rate){
+    learning_rate_m= learning_rate;
+}
+
+void SGDSoftmaxRegression::setInputs(float* x){
+    std::memcpy(inputs_m.data(), x, feature_size_m* sizeof(float));
+}
+
+void SGDSoftmaxRegression::inference_fp(alignedArray<float>& inputs, float* probabilities){
+    softmax_logits_fp(weights_m.data(), inputs.data(), logits_m.data(), class_stride_m, feature_size_m);
+    softmax_inplace(logits_m.data(), num_classes_m, class_stride_m);
+    std::memcpy(probabilities, logits_m.data(), num_classes_m* sizeof(float));
+}
+
+void SGDSoftmaxRegression::inference_q8_8_to_fp(alignedArray<float>& inputs, float* probabilities){
+    quantize8_8_inplace(inputs.data(), inputs_q8_8_m.data(), feature_size_m);
+    softmax_logits_q8_8(weights_q8_8_m.data(), inputs_q8_8_m.data(), logits_q16_16_m.data(), class_stride_m, feature_size_m);
+
+    __m256 vec_scale= _mm256_set1_ps(1.0f/ (SCALE_FACTOR* SCALE_FACTOR));
+    for (size_t k= 0; k < class_stride_m; k += 8){
+        __m256 vec_logits= _mm256_cvtepi32_ps(_mm256_load_si256((__m256i*)&logits_q16_16_m[k]));
+        _mm256_store_ps(&logits_m[k], _mm256_mul_ps(vec_logits, vec_scale));
+    }
+
+    softmax_inplace(logits_m.data(), num_classes_m, class_stride_m);
+    std::memcpy(probabilities, logits_m.data(), num_classes_m* sizeof(float));
+}
+
+//Cross-entropy gradient: every class row moves by lr * (onehot_k - p_k) x in one pass over the weights
+void SGDSoftmaxRegression::update_weights(float* probabilities, size_t label){
+    assert(label < num_classes_m && "Label out of range");
+    for (size_t k= 0; k < class_stride_m; k++){
+        float target= (k == label)? 1.0f: 0.0f;
+        neg_coeff_m[k]= (k < num_classes_m)? learning_rate_m* (target - probabilities[k]): 0.0f;
+    }
+    softmax_sgd_q8_8_inplace(neg_coeff_m.data(), weights_m.data(), weights_q8_8_m.data(), inputs_m.data(), class_stride_m, feature_size_m);
+}
+
+//xavier init, padding classes and the padding feature row stay zero
+void SGDSoftmaxRegression::initWeights(){
+    std::random_device rd;
+    std::mt19937 gen(rd());
+
+    float limit= sqrt(6.0f / (feature_size_m + num_classes_m));
+    std::uniform_real_distribution<float> dist(-limit, limit);
+
+    for (size_t f= 0; f < feature_stride_m; f++){
+        for (size_t k= 0; k < class_stride_m; k++){
+            weights_m[f* class_stride_m + k]= (f < feature_size_m && k < num_classes_m)? dist(gen): 0.0f;
+        }
+    }
+
+    for (size_t k= 0; k < class_stride_m; k++){
+        neg_coeff_m[k]= 0.0f;
+    }
+    //a zero step re-quantizes every weight into the pair-interleaved layout
+    softmax_sgd_q8_8_inplace(neg_coeff_m.data(), weights_m.data(), weights_q8_8_m.data(), inputs_m.data(), class_stride_m, feature_size_m);
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "avx.hh"
+#include "containers.hh"
+
+class SGDSoftmaxRegression{
+    private:
+        const size_t feature_size_m;
+        const size_t num_classes_m;
+        const size_t class_stride_m;
+        const size_t feature_stride_m;
+
+        float learning_rate_m;
+
+        alignedArray<float> weights_m;
+        alignedArray<float> inputs_m;
+        alignedArray<int16_t> weights_q8_8_m;
+        alignedArray<int16_t> inputs_q8_8_m;
+        alignedArray<int32_t> logits_q16_16_m;
+        alignedArray<float> logits_m;
+        alignedArray<float> neg_coeff_m;
+
+        void initWeights();
+
+    public:
+
+        SGDSoftmaxRegression(size_t feature_size, size_t num_classes, float learning_rate= 0.01f, size_t alignment= ARRAY_DEFAULT_ALIGNMENT);
+
+        void setLearningRate(float val);
+        void setInputs(float* x);
+
+        //probabilities receives num_classes values
+        void inference_fp(alignedArray<float>& inputs, float* probabilities);
+        void inference_q8_8_to_fp(alignedArray<float>& inputs, float* probabilities);
+        void update_weights(float* probabilities, size_t label);
+};
@@ -0,0 +1,249 @@
+#include "tools.hh"
+#include "sse.hh"
+
+void quantize8_8_inplace_sse42(float* v, int16_t* q, size_t size){
+    const __m128 vec_maxq= _mm_set1_ps(MAXQ);
+    const __m128 vec_minq= _mm_set1_ps(MINQ);
+    const __m128 vec_scale= _mm_set1_ps(SCALE_FACTOR);
+    const __m128 vec_round= _mm_set1_ps(ROUND_FACTOR);
+
+    //16 per step so the vector/scalar split matches the AVX2 kernel bit for bit
+    size_t i= 0;
+    for(; i + 16 <= size; i+= 16){
+        _mm_prefetch(reinterpret_cast<const char*>(&v[i+ 64]), _MM_HINT_T0);
+        for(size_t k= 0; k < 16; k+= 8){
+            __m128 vec1_fp= _mm_loadu_ps(&v[i + k]);
+            __m128 vec2_fp= _mm_loadu_ps(&v[i + k + 4]);
+
+            vec1_fp= _mm_max_ps(vec_minq, _mm_min_ps(vec_maxq, vec1_fp));
+            vec2_fp= _mm_max_ps(vec_minq, _mm_min_ps(vec_maxq, vec2_fp));
+
+            __m128i vec1_pi= _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(vec1_fp, vec_scale), vec_round));
+            __m128i vec2_pi= _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(vec2_fp, vec_scale), vec_round));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&q[i + k]), _mm_packs_epi32(vec1_pi, vec2_pi));
+        }
+    }
+
+    for (; i < size; i++) {
+        float val= v[i];
+        q[i]= avx_float_to_q8_8(clamp(val, MINQ, MAXQ));
+    }
+}
+
+int32_t dotproduct_q8_8_sse42(int16_t* w_q8_8, int16_t* x_q8_8, size_t size){
+    __m128i vec_sum_q16_16= _mm_setzero_si128();
+    size_t i= 0;
+    for(; i + 16 <= size; i += 16){
+        _mm_prefetch(reinterpret_cast<const char*>(&w_q8_8[i+ 64]), _MM_HINT_T0);
+        _mm_prefetch(reinterpret_cast<const char*>(&x_q8_8[i+ 64]), _MM_HINT_T0);
+
+        __m128i dot1= _mm_madd_epi16(_mm_loadu_si128((__m128i*)&w_q8_8[i]), _mm_loadu_si128((__m128i*)&x_q8_8[i]));
+        __m128i dot2= _mm_madd_epi16(_mm_loadu_si128((__m128i*)&w_q8_8[i+ 8]), _mm_loadu_si128((__m128i*)&x_q8_8[i+ 8]));
+
+        vec_sum_q16_16= _mm_add_epi32(vec_sum_q16_16, _mm_add_epi32(dot1, dot2));
+    }
+
+    vec_sum_q16_16= _mm_hadd_epi32(vec_sum_q16_16, vec_sum_q16_16);
+    vec_sum_q16_16= _mm_hadd_epi32(vec_sum_q16_16, vec_sum_q16_16);
+    int32_t sum_q16_16= _mm_cvtsi128_si32(vec_sum_q16_16);
+
+    for(; i < size; i++){
+        sum_q16_16 += w_q8_8[i] * x_q8_8[i];
+    }
+
+    return sum_q16_16;
+}
+
+//Same hi/lo split as the AVX2 kernel, up to 32768 madds per lane per block keep both sums inside int32
+static inline void accumulate_wide_sse42(__m128i r, __m128i& vec_hi, __m128i& vec_lo){
+    r= _mm_add_epi32(r, _mm_set1_epi32(-1));
+    vec_hi= _mm_add_epi32(vec_hi, _mm_srai_epi32(r, 16));
+    vec_lo= _mm_add_epi32(vec_lo, _mm_and_si128(r, _mm_set1_epi32(0xFFFF)));
+}
+
+int64_t dotproduct_q8_8_wide_sse42(int16_t* w_q8_8, int16_t* x_q8_8, size_t size){
+    int64_t sum_q16_16= 0;
+    size_t i= 0;
+    while (i + 8 <= size){
+        size_t block_end= std::min(size, i + Q8_8_WIDE_BLOCK);
+        size_t block_begin= i;
+        __m128i vec_hi= _mm_setzero_si128();
+        __m128i vec_lo= _mm_setzero_si128();
+
+        for (; i + 16 <= block_end; i += 16){
+            _mm_prefetch(reinterpret_cast<const char*>(&w_q8_8[i+ 64]), _MM_HINT_T0);
+            _mm_prefetch(reinterpret_cast<const char*>(&x_q8_8[i+ 64]), _MM_HINT_T0);
+
+            accumulate_wide_sse42(_mm_madd_epi16(_mm_loadu_si128((__m128i*)&w_q8_8[i]), _mm_loadu_si128((__m128i*)&x_q8_8[i])), vec_hi, vec_lo);
+            accumulate_wide_sse42(_mm_madd_epi16(_mm_loadu_si128((__m128i*)&w_q8_8[i+ 8]), _mm_loadu_si128((__m128i*)&x_q8_8[i+ 8])), vec_hi, vec_lo);
+        }
+        if (i + 8 <= block_end){
+            accumulate_wide_sse42(_mm_madd_epi16(_mm_loadu_si128((__m128i*)&w_q8_8[i]), _mm_loadu_si128((__m128i*)&x_q8_8[i])), vec_hi, vec_lo);
+            i+= 8;
+        }
+
+        alignas(16) int32_t hi[4];
+        alignas(16) int32_t lo[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(hi), vec_hi);
+        _mm_store_si128(reinterpret_cast<__m128i*>(lo), vec_lo);
+        for (size_t k= 0; k < 4; k++){
+            sum_q16_16+= static_cast<int64_t>(hi[k])* 65536 + lo[k];
+        }
+        sum_q16_16+= static_cast<int64_t>((i - block_begin)/ 2);
+    }
+
+    for(; i < size; i++){
+        sum_q16_16+= static_cast<int64_t>(w_q8_8[i])* x_q8_8[i];
+    }
+
+    return sum_q16_16;
+}
+
+float dotproduct_fp_sse42(float* w_fp, float* x_fp, size_t size){
+    __m128 vec1_sum_fp= _mm_setzero_ps();
+    __m128 vec2_sum_fp= _mm_setzero_ps();
+    size_t i= 0;
+    for(; i + 8 <= size; i += 8){
+        _mm_prefetch(reinterpret_cast<const char*>(&w_fp[i+ 32]), _MM_HINT_T0);
+        _mm_prefetch(reinterpret_cast<const char*>(&x_fp[i+ 32]), _MM_HINT_T0);
+
+        vec1_sum_fp= _mm_add_ps(vec1_sum_fp, _mm_mul_ps(_mm_loadu_ps(&w_fp[i]), _mm_loadu_ps(&x_fp[i])));
+        vec2_sum_fp= _mm_add_ps(vec2_sum_fp, _mm_mul_ps(_mm_loadu_ps(&w_fp[i+ 4]), _mm_loadu_ps(&x_fp[i+ 4])));
+    }
+
+    __m128 sum_fp_128= _mm_add_ps(vec1_sum_fp, vec2_sum_fp);
+    sum_fp_128= _mm_hadd_ps(sum_fp_128, sum_fp_128);
+    sum_fp_128= _mm_hadd_ps(sum_fp_128, sum_fp_128);
+    float sum_fp= _mm_cvtss_f32(sum_fp_128);
+
+    for(; i < size; i++){
+        sum_fp += w_fp[i] * x_fp[i];
+    }
+    return sum_fp;
+}
+
+void sgd_inplace_sse42(int16_t y_hat, float y, float* w_fp, float* x_fp, size_t size, float lr){
+    float neg_coeff= lr*(y- q8_8_to_float(y_hat));
+    __m128 vec_neg_coeff= _mm_set1_ps(neg_coeff);
+
+    size_t i= 0;
+    for (; i + 8 <= size; i += 8){
+        _mm_prefetch(reinterpret_cast<const char*>(&x_fp[i + 32]), _MM_HINT_T0);
+        _mm_prefetch(reinterpret_cast<const char*>(&w_fp[i + 32]), _MM_HINT_T0);
+
+        __m128 vec1_w_fp= _mm_add_ps(_mm_loadu_ps(&w_fp[i]), _mm_mul_ps(vec_neg_coeff, _mm_loadu_ps(&x_fp[i])));
+        __m128 vec2_w_fp= _mm_add_ps(_mm_loadu_ps(&w_fp[i+ 4]), _mm_mul_ps(vec_neg_coeff, _mm_loadu_ps(&x_fp[i+ 4])));
+
+        _mm_storeu_ps(&w_fp[i], vec1_w_fp);
+        _mm_storeu_ps(&w_fp[i + 4], vec2_w_fp);
+    }
+
+    for (; i < size; i ++){
+        w_fp[i]+= neg_coeff*x_fp[i];
+    }
+}
+
+//16 per step so the vector/scalar split of the Q8.8 refresh matches quantize8_8_inplace_sse42
+void sgd_q8_8_inplace_sse42(int16_t y_hat, float y, float* w_fp, int16_t* w_q8_8, float* x_fp, size_t size, float lr){
+    const __m128 vec_maxq= _mm_set1_ps(MAXQ);
+    const __m128 vec_minq= _mm_set1_ps(MINQ);
+    const __m128 vec_scale= _mm_set1_ps(SCALE_FACTOR);
+    const __m128 vec_round= _mm_set1_ps(ROUND_FACTOR);
+    const __m128i vec_abs_mask= _mm_set1_epi32(0x7FFFFFFF);
+    float neg_coeff= lr*(y- q8_8_to_float(y_hat));
+    __m128 vec_neg_coeff= _mm_set1_ps(neg_coeff);
+
+    size_t i= 0;
+    for (; i + 16 <= size; i += 16){
+        _mm_prefetch(reinterpret_cast<const char*>(&x_fp[i + 32]), _MM_HINT_T0);
+        _mm_prefetch(reinterpret_cast<const char*>(&w_fp[i + 32]), _MM_HINT_T0);
+
+        __m128 vec_x_fp[4];
+        for (size_t k= 0; k < 4; k++){
+            vec_x_fp[k]= _mm_loadu_ps(&x_fp[i + 4* k]);
+        }
+        __m128 vec_x_any= _mm_or_ps(_mm_or_ps(vec_x_fp[0], vec_x_fp[1]), _mm_or_ps(vec_x_fp[2], vec_x_fp[3]));
+        if (_mm_testz_si128(_mm_castps_si128(vec_x_any), vec_abs_mask)){
+            continue;
+        }
+
+        for (size_t k= 0; k < 4; k+= 2){
+            __m128 vec1_w_fp= _mm_add_ps(_mm_loadu_ps(&w_fp[i + 4* k]), _mm_mul_ps(vec_neg_coeff, vec_x_fp[k]));
+            __m128 vec2_w_fp= _mm_add_ps(_mm_loadu_ps(&w_fp[i + 4* k + 4]), _mm_mul_ps(vec_neg_coeff, vec_x_fp[k + 1]));
+            _mm_storeu_ps(&w_fp[i + 4* k], vec1_w_fp);
+            _mm_storeu_ps(&w_fp[i + 4* k + 4], vec2_w_fp);
+
+            vec1_w_fp= _mm_max_ps(vec_minq, _mm_min_ps(vec_maxq, vec1_w_fp));
+            vec2_w_fp= _mm_max_ps(vec_minq, _mm_min_ps(vec_maxq, vec2_w_fp));
+            __m128i vec1_pi= _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(vec1_w_fp, vec_scale), vec_round));
+            __m128i vec2_pi= _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(vec2_w_fp, vec_scale), vec_round));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&w_q8_8[i + 4* k]), _mm_packs_epi32(vec1_pi, vec2_pi));
+        }
+    }
+
+    for (; i < size; i++){
+        float w= w_fp[i] + neg_coeff*x_fp[i];
+        w_fp[i]= w;
+        w_q8_8[i]= avx_float_to_q8_8(clamp(w, MINQ, MAXQ));
+    }
+}
+
+float absmax_scale_int8_sse42(float* v, size_t size){
+    const __m128 vec_abs_mask= _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    __m128 vec_max= _mm_setzero_ps();
+
+    size_t i= 0;
+    for(; i + 4 <= size; i += 4){
+        vec_max= _mm_max_ps(vec_max, _mm_and_ps(_mm_loadu_ps(&v[i]), vec_abs_mask));
+    }
+
+    vec_max= _mm_max_ps(vec_max, _mm_movehl_ps(vec_max, vec_max));
+    vec_max= _mm_max_ss(vec_max, _mm_shuffle_ps(vec_max, vec_max, 1));
+    float max_fp= _mm_cvtss_f32(vec_max);
+    for(; i < size; i++){
+        max_fp= std::fmaxf(max_fp, std::fabs(v[i]));
+    }
+    //floor keeps 1/scale finite for all-zero inputs (which then quantize to 0) without inflating calibration maxima
+    return std::fmaxf(max_fp, 1e-30f)/ INT8_MAXQ;
+}
+
+void quantize_int8_sse42(float* v, int8_t* q, size_t size, float scale){
+    float inv_scale= 1.0f/ scale;
+    __m128 vec_inv_scale= _mm_set1_ps(inv_scale);
+
+    size_t i= 0;
+    for(; i + 16 <= size; i += 16){
+        __m128i ab= _mm_packs_epi32(_mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(&v[i]), vec_inv_scale)),
+                                    _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(&v[i+ 4]), vec_inv_scale)));
+        __m128i cd= _mm_packs_epi32(_mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(&v[i+ 8]), vec_inv_scale)),
+                                    _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(&v[i+ 12]), vec_inv_scale)));
+        __m128i abcd= _mm_max_epi8(_mm_packs_epi16(ab, cd), _mm_set1_epi8(-127));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&q[i]), abcd);
+    }
+
+    for(; i < size; i++){
+        q[i]= static_cast<int8_t>(clamp(std::nearbyint(v[i]* inv_scale), -127.0f, 127.0f));
+    }
+}
+
+int32_t dotproduct_int8_sse42(int8_t* w_int8, int8_t* x_int8, size_t size){
+    const __m128i vec_ones= _mm_set1_epi16(1);
+    __m128i vec_sum= _mm_setzero_si128();
+
+    size_t i= 0;
+    for(; i + 16 <= size; i += 16){
+        __m128i x= _mm_loadu_si128((__m128i*)&x_int8[i]);
+        __m128i w= _mm_loadu_si128((__m128i*)&w_int8[i]);
+        __m128i prod_16= _mm_maddubs_epi16(_mm_abs_epi8(x), _mm_sign_epi8(w, x));
+        vec_sum= _mm_add_epi32(vec_sum, _mm_madd_epi16(prod_16, vec_ones));
+    }
+
+    vec_sum= _mm_hadd_epi32(vec_sum, vec_sum);
+    vec_sum= _mm_hadd_epi32(vec_sum, vec_sum);
+    int32_t sum= _mm_cvtsi128_si32(vec_sum);
+    for(; i < size; i++){
+        sum += w_int8[i] * x_int8[i];
+    }
+    return sum;
+}
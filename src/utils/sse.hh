@@ -0,0 +1,23 @@
+//SSE4.2 fallbacks of the core kernels, same contracts as avx.hh
+#pragma once
+#include <immintrin.h>
+#include <cstdint>
+#include <cstddef>
+
+void quantize8_8_inplace_sse42(float* v, int16_t* q, size_t size);
+
+int32_t dotproduct_q8_8_sse42(int16_t* w_q8_8, int16_t* x_q8_8, size_t size);
+
+int64_t dotproduct_q8_8_wide_sse42(int16_t* w_q8_8, int16_t* x_q8_8, size_t size);
+
+float dotproduct_fp_sse42(float* w_fp, float* x_fp, size_t size);
+
+void sgd_inplace_sse42(int16_t y_hat, float y, float* w_fp, float* x_fp, size_t size, float lr);
+
+void sgd_q8_8_inplace_sse42(int16_t y_hat, float y, float* w_fp, int16_t* w_q8_8, float* x_fp, size_t size, float lr);
+
+float absmax_scale_int8_sse42(float* v, size_t size);
+
+void quantize_int8_sse42(float* v, int8_t* q, size_t size, float scale);
+
+int32_t dotproduct_int8_sse42(int8_t* w_int8, int8_t* x_int8, size_t size);
\ No newline at end of file
@@ -4,11 +4,18 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstdint>
 
 constexpr float MAXQ= 127.9940f;
 constexpr float MINQ= -128.0f;
 constexpr float SCALE_FACTOR= 256.0f;
 constexpr float ROUND_FACTOR= 0.5f;
+constexpr float INT8_MAXQ= 127.0f;
+//dotproduct_q8_8 keeps Q16.16 sums in int32: exact for values within +-1.0 up to this many features (32767 * 2^16
+//< 2^31), beyond it models use dotproduct_q8_8_wide, which is exact for any values and sizes and folds its int32
+//partials into int64 every block
+constexpr size_t Q8_8_NARROW_MAX_FEATURES= 32767;
+constexpr size_t Q8_8_WIDE_BLOCK= size_t(1) << 18;
 
 extern const __m256 MM256_MAXQ;
 extern const __m256 MM256_MINQ;
@@ -29,9 +36,46 @@ static inline int16_t clamp(int16_t n, int16_t min, int16_t max){
     return  std::max(min, std::min(max, n));
 }
 
+//Cephes-style exp, range reduced to 2^n * e^r with a degree 5 polynomial on r
+static inline __m256 exp_ps(__m256 x){
+    x= clamp(x, _mm256_set1_ps(-87.3365f), _mm256_set1_ps(88.3762f));
+
+    __m256 fx= _mm256_fmadd_ps(x, _mm256_set1_ps(1.44269504088896341f), _mm256_set1_ps(0.5f));
+    fx= _mm256_floor_ps(fx);
+
+    x= _mm256_fnmadd_ps(fx, _mm256_set1_ps(0.693359375f), x);
+    x= _mm256_fnmadd_ps(fx, _mm256_set1_ps(-2.12194440e-4f), x);
+
+    __m256 y= _mm256_set1_ps(1.9875691500e-4f);
+    y= _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.3981999507e-3f));
+    y= _mm256_fmadd_ps(y, x, _mm256_set1_ps(8.3334519073e-3f));
+    y= _mm256_fmadd_ps(y, x, _mm256_set1_ps(4.1665795894e-2f));
+    y= _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.6666665459e-1f));
+    y= _mm256_fmadd_ps(y, x, _mm256_set1_ps(5.0000001201e-1f));
+    y= _mm256_fmadd_ps(y, _mm256_mul_ps(x, x), _mm256_add_ps(x, _mm256_set1_ps(1.0f)));
+
+    __m256i pow2n= _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvttps_epi32(fx), _mm256_set1_epi32(127)), 23);
+    return _mm256_mul_ps(y, _mm256_castsi256_ps(pow2n));
+}
+
+static inline int32_t hsum_epi32(__m256i v){
+    __m128i lower= _mm256_castsi256_si128(v);
+    __m128i higher= _mm256_extracti128_si256(v, 1);
+    __m128i sum_128= _mm_add_epi32(lower, higher);
+    sum_128= _mm_hadd_epi32(sum_128, sum_128);
+    sum_128= _mm_hadd_epi32(sum_128, sum_128);
+    return _mm_cvtsi128_si32(sum_128);
+}
+
+//Clamped, scaled and rounded like quantize8_8_inplace, one int32 per lane
+static inline __m256i quantize8_8_epi32(__m256 v){
+    return _mm256_cvtps_epi32(_mm256_fmadd_ps(clamp(v, MM256_MINQ, MM256_MAXQ), MM256_SCALE, MM256_ROUND));
+}
+
+//SSE only so baseline (dispatched) translation units can use it; n * 256 is exact so mul+add matches fmadd
 static inline int16_t avx_float_to_q8_8(float n) {
     __m128 n_ps   = _mm_set_ss(n);
-    __m128 result = _mm_fmadd_ss(n_ps, MM128_SCALE, MM128_ROUND);
+    __m128 result = _mm_add_ss(_mm_mul_ss(n_ps, MM128_SCALE), MM128_ROUND);
     return static_cast<int16_t>(_mm_cvtss_si32(result));
 }
 
@@ -39,6 +83,10 @@ constexpr inline int16_t float_to_q8_8(float n){
     return static_cast<int16_t>(n* SCALE_FACTOR + ROUND_FACTOR);
 }
 
+constexpr inline int32_t saturate_q16_16(int64_t n){
+    return static_cast<int32_t>(std::clamp<int64_t>(n, INT32_MIN, INT32_MAX));
+}
+
 constexpr inline float q8_8_to_float(int16_t n){
     return static_cast<float>(n)/ SCALE_FACTOR; 
 }
@@ -82,8 +130,78 @@ inline int16_t sigmoidApprox_q8_8(int16_t n){
     return SIGMOID_TABLE[i];
 }
 
+//Clamped in int32 before narrowing, logits of 128 and beyond (saturated wide sums included) would wrap in int16
 inline int16_t sigmoidApprox_q16_16_to_q8_8(int32_t n){
-    int16_t n_q8_8= static_cast<int16_t>(n >> 8);
-    int16_t i= clamp(n_q8_8, -1024, 1023) + 1024;
+    int32_t i= std::clamp<int32_t>(n >> 8, -1024, 1023) + 1024;
     return SIGMOID_TABLE[i];
-}
\ No newline at end of file
+}
+
+//Finer tables for linear interpolation: steps entries per unit over [-range, range], plus the end point and one
+//slack entry so the upper neighbour of the last cell is always readable
+enum class SigmoidPrecision{
+    Q8_8, //[-8, 8], 1/32 steps: max error ~3.5e-4, under half a Q8.8 step
+    FP32  //[-16, 16], 1/128 steps: max error ~1e-6
+};
+
+template <size_t range, size_t steps>
+constexpr std::array<float, 2* range* steps + 2> precompute_sigmoid_lut(){
+    std::array<float, 2* range* steps + 2> lut{};
+    for (size_t i= 0; i < lut.size(); i++){
+        double x= static_cast<double>(i)/ steps - static_cast<double>(range);
+        lut[i]= static_cast<float>(1.0/ (1.0 + std::exp(-x)));
+    }
+    return lut;
+}
+
+constexpr size_t SIGMOID_LUT_Q8_8_RANGE= 8;
+constexpr size_t SIGMOID_LUT_Q8_8_STEPS= 32;
+constexpr size_t SIGMOID_LUT_FP32_RANGE= 16;
+constexpr size_t SIGMOID_LUT_FP32_STEPS= 128;
+
+alignas(64) constexpr std::array<float, 2* SIGMOID_LUT_Q8_8_RANGE* SIGMOID_LUT_Q8_8_STEPS + 2>
+SIGMOID_LUT_Q8_8= precompute_sigmoid_lut<SIGMOID_LUT_Q8_8_RANGE, SIGMOID_LUT_Q8_8_STEPS>();
+alignas(64) constexpr std::array<float, 2* SIGMOID_LUT_FP32_RANGE* SIGMOID_LUT_FP32_STEPS + 2>
+SIGMOID_LUT_FP32= precompute_sigmoid_lut<SIGMOID_LUT_FP32_RANGE, SIGMOID_LUT_FP32_STEPS>();
+
+template <size_t range, size_t steps, size_t N>
+inline float sigmoidInterp(const std::array<float, N>& lut, float x){
+    float t= (clamp(x, -static_cast<float>(range), static_cast<float>(range)) + range)* steps;
+    size_t i= static_cast<size_t>(t);
+    float frac= t - static_cast<float>(i);
+    return lut[i] + frac*(lut[i + 1] - lut[i]);
+}
+
+inline float sigmoidInterp_fp(float x, SigmoidPrecision precision= SigmoidPrecision::FP32){
+    if (precision == SigmoidPrecision::Q8_8){
+        return sigmoidInterp<SIGMOID_LUT_Q8_8_RANGE, SIGMOID_LUT_Q8_8_STEPS>(SIGMOID_LUT_Q8_8, x);
+    }
+    return sigmoidInterp<SIGMOID_LUT_FP32_RANGE, SIGMOID_LUT_FP32_STEPS>(SIGMOID_LUT_FP32, x);
+}
+
+inline int16_t sigmoidInterp_fp_to_q8_8(float x){
+    return float_to_q8_8(sigmoidInterp_fp(x, SigmoidPrecision::Q8_8));
+}
+
+//Keeps all 16 fractional bits of the accumulator instead of truncating to Q8.8 first
+inline int16_t sigmoidInterp_q16_16_to_q8_8(int32_t n){
+    return sigmoidInterp_fp_to_q8_8(static_cast<float>(n)* (1.0f/ 65536.0f));
+}
+//Feature hashing: murmur3's fmix64 finalizer over id ^ seed. The high 32 bits pick an index in [0, size) by
+//multiply-shift, bit 0 flips the value's sign so colliding features cancel in expectation instead of piling up
+constexpr inline uint64_t hash_feature_id(uint64_t id, uint64_t seed){
+    uint64_t h= id ^ seed;
+    h^= h >> 33;
+    h*= 0xFF51AFD7ED558CCDull;
+    h^= h >> 33;
+    h*= 0xC4CEB9FE1A85EC53ull;
+    h^= h >> 33;
+    return h;
+}
+
+constexpr inline int32_t hashed_index(uint64_t h, uint32_t size){
+    return static_cast<int32_t>(((h >> 32)* size) >> 32);
+}
+
+constexpr inline float hashed_sign(uint64_t h){
+    return (h & 1)? -1.0f: 1.0f;
+}
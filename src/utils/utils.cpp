@@ -2,12 +2,13 @@
 #include "tools.hh"
 #include <immintrin.h>
 
-alignas(32) const __m256 MM256_MAXQ= _mm256_broadcast_ss(&MAXQ);
-alignas(32) const __m256 MM256_MINQ= _mm256_broadcast_ss(&MINQ);
-alignas(32) const __m256 MM256_SCALE= _mm256_broadcast_ss(&SCALE_FACTOR);
-alignas(32) const __m256 MM256_ROUND= _mm256_broadcast_ss(&ROUND_FACTOR);
-alignas(32) const __m128 MM128_SCALE= _mm_broadcast_ss(&SCALE_FACTOR);
-alignas(32) const __m128 MM128_ROUND= _mm_broadcast_ss(&ROUND_FACTOR);
+//Constant-initialized so no AVX instruction runs during static init on hosts dispatched to SSE4.2
+alignas(32) const __m256 MM256_MAXQ= {MAXQ, MAXQ, MAXQ, MAXQ, MAXQ, MAXQ, MAXQ, MAXQ};
+alignas(32) const __m256 MM256_MINQ= {MINQ, MINQ, MINQ, MINQ, MINQ, MINQ, MINQ, MINQ};
+alignas(32) const __m256 MM256_SCALE= {SCALE_FACTOR, SCALE_FACTOR, SCALE_FACTOR, SCALE_FACTOR, SCALE_FACTOR, SCALE_FACTOR, SCALE_FACTOR, SCALE_FACTOR};
+alignas(32) const __m256 MM256_ROUND= {ROUND_FACTOR, ROUND_FACTOR, ROUND_FACTOR, ROUND_FACTOR, ROUND_FACTOR, ROUND_FACTOR, ROUND_FACTOR, ROUND_FACTOR};
+alignas(32) const __m128 MM128_SCALE= {SCALE_FACTOR, SCALE_FACTOR, SCALE_FACTOR, SCALE_FACTOR};
+alignas(32) const __m128 MM128_ROUND= {ROUND_FACTOR, ROUND_FACTOR, ROUND_FACTOR, ROUND_FACTOR};
 
 AdamWParams::AdamWParams(size_t size, float lr):
         learning_rate(lr), 
@@ -25,7 +26,7 @@ AdamWParams::AdamWParams(size_t size, float lr):
         __m256 zeros= _mm256_setzero_ps();
 
         size_t i= 0;
-        for(; i <= size; i+= 8){
+        for(; i + 8 <= size; i+= 8){
             _mm256_store_ps(moment1.data() + i, zeros);
             _mm256_store_ps(moment2.data() + i, zeros);
         }